@@ -14,6 +14,7 @@
 
 #include "Blitter.hpp"
 
+#include "Parallel.hpp"
 #include "Pipeline/ShaderCore.hpp"
 #include "Reactor/Reactor.hpp"
 #include "System/Half.hpp"
@@ -79,6 +80,7 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 	}
 
 	State state(format, dstFormat, 1, dest->getSampleCountFlagBits(), Options{ 0xF });
+	state.tiledDest = dest->isTiled();
 	auto blitRoutine = getBlitRoutine(state);
 	if(!blitRoutine)
 	{
@@ -127,6 +129,8 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 			0, 0,  // sWidth, sHeight
 		};
 
+		size_t bytesPerRow = area.extent.width * dstFormat.bytes() * dest->getSampleCountFlagBits();
+
 		if(renderArea && dest->is3DSlice())
 		{
 			// Reinterpret layers as depth slices
@@ -135,7 +139,7 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 			for(uint32_t depth = subresourceRange.baseArrayLayer; depth <= lastLayer; depth++)
 			{
 				data.dest = dest->getTexelPointer({ 0, 0, static_cast<int32_t>(depth) }, subresLayers);
-				blitRoutine(&data);
+				runBlitRoutine(blitRoutine, data, bytesPerRow);
 			}
 		}
 		else
@@ -146,29 +150,20 @@ void Blitter::clear(void *pixel, vk::Format format, vk::Image *dest, const vk::F
 				{
 					data.dest = dest->getTexelPointer({ 0, 0, static_cast<int32_t>(depth) }, subresLayers);
 
-					blitRoutine(&data);
+					runBlitRoutine(blitRoutine, data, bytesPerRow);
 				}
 			}
 		}
 	}
 }
 
-bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
+bool Blitter::packClearColor(float *color, const vk::Format &viewFormat, uint32_t &packed)
 {
-	if(format != VK_FORMAT_R32G32B32A32_SFLOAT)
-	{
-		return false;
-	}
-
-	float *color = (float *)pixel;
 	float r = color[0];
 	float g = color[1];
 	float b = color[2];
 	float a = color[3];
 
-	uint32_t packed;
-
-	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
 	switch(viewFormat)
 	{
 		case VK_FORMAT_R5G6B5_UNORM_PACK16:
@@ -205,6 +200,24 @@ bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const v
 			return false;
 	}
 
+	return true;
+}
+
+bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const vk::Format &viewFormat, const VkImageSubresourceRange &subresourceRange, const VkRect2D *renderArea)
+{
+	if(format != VK_FORMAT_R32G32B32A32_SFLOAT)
+	{
+		return false;
+	}
+
+	uint32_t packed;
+	if(!packClearColor(static_cast<float *>(pixel), viewFormat, packed))
+	{
+		return false;
+	}
+
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
+
 	VkImageSubresourceLayers subresLayers = {
 		subresourceRange.aspectMask,
 		subresourceRange.baseMipLevel,
@@ -231,6 +244,13 @@ bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const v
 			area.extent.width = extent.width;
 			area.extent.height = extent.height;
 		}
+		if(dest->isTiled())
+		{
+			// Whole levels of tiled images are cleared, as rows of tiles.
+			ASSERT(!renderArea);
+			area.extent.width = rowPitchBytes / viewFormat.bytes();
+			area.extent.height = (extent.height + 3) / 4;
+		}
 		if(dest->is3DSlice())
 		{
 			extent.depth = 1;  // The 3D image is instead interpreted as a 2D image with layers
@@ -245,29 +265,33 @@ bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const v
 
 				for(int j = 0; j < dest->getSampleCountFlagBits(); j++)
 				{
-					uint8_t *d = slice;
+					int bytes = viewFormat.bytes();
 
-					switch(viewFormat.bytes())
-					{
-						case 2:
-							for(uint32_t i = 0; i < area.extent.height; i++)
-							{
-								ASSERT(d < dest->end());
-								sw::clear((uint16_t *)d, static_cast<uint16_t>(packed), area.extent.width);
-								d += rowPitchBytes;
-							}
-							break;
-						case 4:
-							for(uint32_t i = 0; i < area.extent.height; i++)
-							{
-								ASSERT(d < dest->end());
-								sw::clear((uint32_t *)d, packed, area.extent.width);
-								d += rowPitchBytes;
-							}
-							break;
-						default:
-							assert(false);
-					}
+					parallelFor(area.extent.height, area.extent.width * bytes, [&](uint32_t begin, uint32_t end) {
+						uint8_t *d = slice + begin * rowPitchBytes;
+
+						switch(bytes)
+						{
+							case 2:
+								for(uint32_t i = begin; i < end; i++)
+								{
+									ASSERT(d < dest->end());
+									sw::clear((uint16_t *)d, static_cast<uint16_t>(packed), area.extent.width);
+									d += rowPitchBytes;
+								}
+								break;
+							case 4:
+								for(uint32_t i = begin; i < end; i++)
+								{
+									ASSERT(d < dest->end());
+									sw::clear((uint32_t *)d, packed, area.extent.width);
+									d += rowPitchBytes;
+								}
+								break;
+							default:
+								assert(false);
+						}
+					});
 
 					slice += slicePitchBytes;
 				}
@@ -1354,6 +1378,12 @@ Int Blitter::ComputeOffset(Int &x, Int &y, Int &pitchB, int bytes)
 	return y * pitchB + x * bytes;
 }
 
+Int Blitter::ComputeTiledOffset(Int &x, Int &y, Int &pitchB, int bytes)
+{
+	// pitchB is the size of a row of 4x4 tiles.
+	return (y >> 2) * pitchB + (((x >> 2) << 4) + ((y & 3) << 2) + (x & 3)) * bytes;
+}
+
 Float4 Blitter::LinearToSRGB(Float4 &c)
 {
 	Float4 lc = Min(c, Float4(0.0031308f)) * Float4(12.92f);
@@ -1436,7 +1466,7 @@ Blitter::BlitRoutineType Blitter::generate(const State &state)
 			For(Int i = x0d, i < x1d, i++)
 			{
 				Float x = state.clearOperation ? RValue<Float>(x0) : x0 + Float(i) * w;
-				Pointer<Byte> d = destLine + i * dstBytes;
+				Pointer<Byte> d = state.tiledDest ? dest + ComputeTiledOffset(i, j, dPitchB, dstBytes) : destLine + i * dstBytes;
 
 				if(hasConstantColorI)
 				{
@@ -1615,6 +1645,19 @@ Blitter::CornerUpdateRoutineType Blitter::getCornerUpdateRoutine(const State &st
 	return cornerUpdateRoutine;
 }
 
+CacheStats Blitter::getCacheStats()
+{
+	std::unique_lock<std::mutex> blitLock(blitMutex);
+	std::unique_lock<std::mutex> cornerUpdateLock(cornerUpdateMutex);
+
+	CacheStats blitStats = blitCache.getStats();
+	CacheStats cornerUpdateStats = cornerUpdateCache.getStats();
+
+	return { blitStats.hits + cornerUpdateStats.hits,
+	         blitStats.misses + cornerUpdateStats.misses,
+	         blitStats.evictions + cornerUpdateStats.evictions };
+}
+
 void Blitter::blitToBuffer(const vk::Image *src, VkImageSubresourceLayers subresource, VkOffset3D offset, VkExtent3D extent, uint8_t *dst, int bufferRowPitch, int bufferSlicePitch)
 {
 	auto aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
@@ -1681,6 +1724,7 @@ void Blitter::blitFromBuffer(const vk::Image *dst, VkImageSubresourceLayers subr
 	auto aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
 	auto format = dst->getFormat(aspect);
 	State state(format, format, VK_SAMPLE_COUNT_1_BIT, VK_SAMPLE_COUNT_1_BIT, Options{ false, false });
+	state.tiledDest = dst->isTiled();
 
 	auto blitRoutine = getBlitRoutine(state);
 	if(!blitRoutine)
@@ -1795,6 +1839,7 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkF
 	                    (static_cast<uint32_t>(region.srcOffsets[1].x) > srcExtent.width) ||
 	                    (static_cast<uint32_t>(region.srcOffsets[1].y) > srcExtent.height) ||
 	                    (doFilter && ((x0 < 0.5f) || (y0 < 0.5f)));
+	state.tiledDest = dst->isTiled();
 
 	auto blitRoutine = getBlitRoutine(state);
 	if(!blitRoutine)
@@ -1824,6 +1869,8 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkF
 		static_cast<int>(srcExtent.height)  // sHeight;
 	};
 
+	size_t bytesPerRow = (region.dstOffsets[1].x - region.dstOffsets[0].x) * dstFormat.bytes() * dst->getSampleCountFlagBits();
+
 	VkOffset3D srcOffset = { 0, 0, region.srcOffsets[0].z };
 	VkOffset3D dstOffset = { 0, 0, region.dstOffsets[0].z };
 
@@ -1864,13 +1911,27 @@ void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkF
 			ASSERT(data.source < src->end());
 			ASSERT(data.dest < dst->end());
 
-			blitRoutine(&data);
+			runBlitRoutine(blitRoutine, data, bytesPerRow);
 			srcOffset.z++;
 			dstOffset.z++;
 		}
 	}
 }
 
+void Blitter::runBlitRoutine(const BlitRoutineType &blitRoutine, const BlitData &data, size_t bytesPerRow)
+{
+	// The routine computes the source coordinates from the absolute
+	// destination row, so the rows can be split into independent ranges.
+	uint32_t rowCount = std::max(data.y1d - data.y0d, 0);
+
+	parallelFor(rowCount, bytesPerRow, [&](uint32_t begin, uint32_t end) {
+		BlitData rows = data;
+		rows.y0d = data.y0d + begin;
+		rows.y1d = data.y0d + end;
+		blitRoutine(&rows);
+	});
+}
+
 void Blitter::computeCubeCorner(Pointer<Byte> &layer, Int &x0, Int &x1, Int &y0, Int &y1, Int &pitchB, const State &state)
 {
 	int bytes = state.sourceFormat.bytes();
@@ -43,6 +43,7 @@ class Blitter
 		    , filter(filter)
 		    , allowSRGBConversion(allowSRGBConversion)
 		    , clampToEdge(false)
+		    , tiledDest(false)
 		{}
 		explicit Options(unsigned int writeMask)
 		    : writeMask(writeMask)
@@ -50,6 +51,7 @@ class Blitter
 		    , filter(false)
 		    , allowSRGBConversion(true)
 		    , clampToEdge(false)
+		    , tiledDest(false)
 		{}
 
 		union
@@ -69,6 +71,7 @@ class Blitter
 		bool filter : 1;
 		bool allowSRGBConversion : 1;
 		bool clampToEdge : 1;
+		bool tiledDest : 1;  // Destination stored in 4x4 tiles, see vk::Image::isTiled()
 	};
 
 	struct State : Memset<State>, Options
@@ -144,6 +147,13 @@ public:
 
 	void updateBorders(vk::Image *image, const VkImageSubresourceLayers &subresourceLayers);
 
+	// Packs a clamped R32G32B32A32_SFLOAT clear color into the pixel layout of
+	// viewFormat. Returns false if the format can't be cleared this way.
+	static bool packClearColor(float *color, const vk::Format &viewFormat, uint32_t &packed);
+
+	// Queries of the blit and cube corner update routine caches.
+	CacheStats getCacheStats();
+
 private:
 	enum Edge
 	{
@@ -161,6 +171,7 @@ private:
 	void write(Int4 &color, Pointer<Byte> element, const State &state);
 	static void ApplyScaleAndClamp(Float4 &value, const State &state, bool preScaled = false);
 	static Int ComputeOffset(Int &x, Int &y, Int &pitchB, int bytes);
+	static Int ComputeTiledOffset(Int &x, Int &y, Int &pitchB, int bytes);
 	static Float4 LinearToSRGB(Float4 &color);
 	static Float4 sRGBtoLinear(Float4 &color);
 
@@ -168,6 +179,7 @@ private:
 	using BlitRoutineType = BlitFunction::RoutineType;
 	BlitRoutineType getBlitRoutine(const State &state);
 	BlitRoutineType generate(const State &state);
+	static void runBlitRoutine(const BlitRoutineType &blitRoutine, const BlitData &data, size_t bytesPerRow);
 
 	using CornerUpdateFunction = FunctionT<void(const CubeBorderData *)>;
 	using CornerUpdateRoutineType = CornerUpdateFunction::RoutineType;
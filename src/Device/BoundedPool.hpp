@@ -0,0 +1,123 @@
+// Copyright 2020 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_BoundedPool_hpp
+#define sw_BoundedPool_hpp
+
+#include "marl/conditionvariable.h"
+#include "marl/pool.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sw {
+
+// BoundedPool<T, POLICY> is a pool of at most capacity items of type T. It
+// behaves like marl::BoundedPool<T, N, POLICY>, except that the capacity is
+// chosen at construction instead of at compile time, so it can be sized after
+// the number of worker threads. Items are allocated on first borrow, so the
+// pool only grows as large as the number of items simultaneously on loan.
+template<typename T, marl::PoolPolicy POLICY = marl::PoolPolicy::Reconstruct>
+class BoundedPool : public marl::Pool<T>
+{
+public:
+	using Item = typename marl::Pool<T>::Item;
+	using Loan = typename marl::Pool<T>::Loan;
+
+	explicit BoundedPool(int capacity)
+	    : storage(std::make_shared<Storage>(capacity))
+	{}
+
+	int capacity() const { return storage->capacity; }
+
+	// borrow() borrows a single item from the pool, blocking until an item is
+	// returned if the pool is empty and already holds capacity items.
+	Loan borrow() const
+	{
+		std::unique_lock<std::mutex> lock(storage->mutex);
+		Item *item = nullptr;
+
+		if(!storage->free && static_cast<int>(storage->items.size()) < storage->capacity)
+		{
+			storage->items.emplace_back(new Item());
+			item = storage->items.back().get();
+			lock.unlock();
+
+			item->construct();  // Preserved items are constructed only once.
+		}
+		else
+		{
+			storage->returned.wait(lock, [&] { return storage->free != nullptr; });
+			item = storage->free;
+			storage->free = storage->free->next;
+			lock.unlock();
+
+			if(POLICY == marl::PoolPolicy::Reconstruct)
+			{
+				item->construct();
+			}
+		}
+
+		return Loan(item, storage);
+	}
+
+private:
+	class Storage : public marl::Pool<T>::Storage
+	{
+	public:
+		explicit Storage(int capacity)
+		    : capacity(capacity)
+		{
+			items.reserve(capacity);
+		}
+
+		~Storage()
+		{
+			if(POLICY == marl::PoolPolicy::Preserve)
+			{
+				for(auto &item : items)
+				{
+					item->destruct();
+				}
+			}
+		}
+
+		void return_(Item *item) override
+		{
+			if(POLICY == marl::PoolPolicy::Reconstruct)
+			{
+				item->destruct();
+			}
+
+			std::unique_lock<std::mutex> lock(mutex);
+			item->next = free;
+			free = item;
+			lock.unlock();
+			returned.notify_one();
+		}
+
+		const int capacity;
+		std::vector<std::unique_ptr<Item>> items;
+		std::mutex mutex;
+		marl::ConditionVariable returned;
+		Item *free = nullptr;
+	};
+
+	std::shared_ptr<Storage> storage;
+};
+
+}  // namespace sw
+
+#endif  // sw_BoundedPool_hpp
@@ -47,7 +47,6 @@ extern Profiler profiler;
 
 enum
 {
-	OUTLINE_RESOLUTION = 8192,  // Maximum vertical resolution of the render target
 	MIPMAP_LEVELS = 14,
 	MAX_UNIFORM_BLOCK_SIZE = 16384,
 	MAX_CLIP_DISTANCES = 8,
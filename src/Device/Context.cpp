@@ -90,10 +90,15 @@ void Context::init()
 	for(int i = 0; i < RENDERTARGETS; ++i)
 	{
 		renderTarget[i] = nullptr;
+		renderTargetFormat[i] = VK_FORMAT_UNDEFINED;
 	}
 
 	depthBuffer = nullptr;
 	stencilBuffer = nullptr;
+	depthBufferFormat = VK_FORMAT_UNDEFINED;
+	stencilBufferFormat = VK_FORMAT_UNDEFINED;
+
+	precompiledRoutines = nullptr;
 
 	stencilEnable = false;
 	frontStencil = {};
@@ -143,12 +148,12 @@ bool Context::depthWriteActive() const
 
 bool Context::depthBufferActive() const
 {
-	return depthBuffer && depthBufferEnable;
+	return (depthBufferFormat != VK_FORMAT_UNDEFINED) && depthBufferEnable;
 }
 
 bool Context::stencilActive() const
 {
-	return stencilBuffer && stencilEnable;
+	return (stencilBufferFormat != VK_FORMAT_UNDEFINED) && stencilEnable;
 }
 
 void Context::setBlendState(int index, BlendState state)
@@ -244,7 +249,7 @@ bool Context::allTargetsColorClamp() const
 	// TODO: remove all of this and support VkPhysicalDeviceFeatures::independentBlend instead
 	for(int i = 0; i < RENDERTARGETS; i++)
 	{
-		if(renderTarget[i] && renderTarget[i]->getFormat().isFloatFormat())
+		if(vk::Format(renderTargetFormat[i]).isFloatFormat())
 		{
 			return false;
 		}
@@ -525,14 +530,7 @@ VkFormat Context::renderTargetInternalFormat(int index) const
 {
 	ASSERT((index >= 0) && (index < RENDERTARGETS));
 
-	if(renderTarget[index])
-	{
-		return renderTarget[index]->getFormat();
-	}
-	else
-	{
-		return VK_FORMAT_UNDEFINED;
-	}
+	return renderTargetFormat[index];
 }
 
 bool Context::colorWriteActive() const
@@ -552,7 +550,7 @@ int Context::colorWriteActive(int index) const
 {
 	ASSERT((index >= 0) && (index < RENDERTARGETS));
 
-	if(!renderTarget[index] || renderTarget[index]->getFormat() == VK_FORMAT_UNDEFINED)
+	if(renderTargetFormat[index] == VK_FORMAT_UNDEFINED)
 	{
 		return 0;
 	}
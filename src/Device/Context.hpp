@@ -32,6 +32,7 @@ class PipelineLayout;
 namespace sw {
 
 class SpirvShader;
+struct PrecompiledRoutines;
 
 struct PushConstantStorage
 {
@@ -118,12 +119,21 @@ public:
 	vk::ImageView *depthBuffer;
 	vk::ImageView *stencilBuffer;
 
+	// Formats of the attachments above. Routine states only depend on these, so
+	// they can be known from the render pass before a framebuffer is bound.
+	VkFormat renderTargetFormat[RENDERTARGETS];
+	VkFormat depthBufferFormat;
+	VkFormat stencilBufferFormat;
+
 	vk::PipelineLayout const *pipelineLayout;
 
 	// Shaders
 	const SpirvShader *pixelShader;
 	const SpirvShader *vertexShader;
 
+	// Routines built at pipeline creation, if any.
+	const PrecompiledRoutines *precompiledRoutines;
+
 	bool occlusionEnabled;
 
 	// Pixel processor states
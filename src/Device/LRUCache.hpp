@@ -17,11 +17,21 @@
 
 #include "System/Math.hpp"
 
+#include <cstdint>
 #include <type_traits>
 #include <unordered_map>
 
 namespace sw {
 
+// Number of queries to a cache which found what they looked for, and which
+// didn't, and number of entries replaced to make room for new ones.
+struct CacheStats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
 template<class Key, class Data>
 class LRUCache
 {
@@ -36,12 +46,19 @@ public:
 	int getSize() { return size; }
 	Key &getKey(int i) { return key[i]; }
 
+	// Results of query() and add(), guarded like the cache itself.
+	CacheStats getStats() const { return { hits, misses, evictions }; }
+
 protected:
 	int size;
 	int mask;
 	int top;
 	int fill;
 
+	mutable uint64_t hits = 0;
+	mutable uint64_t misses = 0;
+	uint64_t evictions = 0;
+
 	Key *key;
 	Key **ref;
 	Data *data;
@@ -146,16 +163,23 @@ Data LRUCache<Key, Data>::query(const Key &key) const
 				ref[j] = swapK;
 			}
 
+			hits++;
 			return hit;
 		}
 	}
 
+	misses++;
 	return {};  // Not found
 }
 
 template<class Key, class Data>
 Data LRUCache<Key, Data>::add(const Key &key, const Data &data)
 {
+	if(fill == size)
+	{
+		evictions++;
+	}
+
 	top = (top + 1) & mask;
 	fill = fill + 1 < size ? fill + 1 : size;
 
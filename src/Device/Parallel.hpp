@@ -0,0 +1,76 @@
+// Copyright 2020 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_Parallel_hpp
+#define sw_Parallel_hpp
+
+#include "marl/scheduler.h"
+#include "marl/waitgroup.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace sw {
+
+// Work smaller than ParallelMinBytes is performed on the calling thread, and
+// larger work is split in ranges of at least ParallelMinBytesPerTask bytes.
+constexpr size_t ParallelMinBytes = 512 * 1024;
+constexpr size_t ParallelMinBytesPerTask = 128 * 1024;
+
+// parallelFor calls function(begin, end) for consecutive ranges of items which
+// together cover [0, count). bytesPerItem is the amount of memory written by
+// each item, used to decide whether the work is worth spreading across the
+// scheduler's worker threads. The last range is processed on the calling
+// thread. Returns once all ranges have been processed.
+template<typename Function>
+void parallelFor(uint32_t count, size_t bytesPerItem, const Function &function)
+{
+	size_t totalBytes = count * bytesPerItem;
+	marl::Scheduler *scheduler = marl::Scheduler::get();
+	uint32_t workerCount = scheduler ? scheduler->getWorkerThreadCount() : 0;
+
+	uint32_t taskCount = 1;
+	if((totalBytes >= ParallelMinBytes) && (workerCount > 1))
+	{
+		taskCount = static_cast<uint32_t>(std::min<size_t>({ count, workerCount, totalBytes / ParallelMinBytesPerTask }));
+	}
+
+	if(taskCount <= 1)
+	{
+		function(0, count);
+		return;
+	}
+
+	marl::WaitGroup wg(taskCount - 1);
+
+	for(uint32_t task = 0; task < taskCount - 1; task++)
+	{
+		uint32_t begin = static_cast<uint32_t>(uint64_t(count) * task / taskCount);
+		uint32_t end = static_cast<uint32_t>(uint64_t(count) * (task + 1) / taskCount);
+
+		marl::schedule([=, &function] {
+			function(begin, end);
+			wg.done();
+		});
+	}
+
+	function(static_cast<uint32_t>(uint64_t(count) * (taskCount - 1) / taskCount), count);
+
+	wg.wait();
+}
+
+}  // namespace sw
+
+#endif  // sw_Parallel_hpp
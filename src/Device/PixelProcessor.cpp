@@ -50,14 +50,10 @@ bool PixelProcessor::State::operator==(const State &state) const
 
 PixelProcessor::PixelProcessor()
 {
-	routineCache = nullptr;
-	setRoutineCacheSize(1024);
 }
 
 PixelProcessor::~PixelProcessor()
 {
-	delete routineCache;
-	routineCache = nullptr;
 }
 
 void PixelProcessor::setBlendConstant(const Color<float> &blendConstant)
@@ -84,13 +80,7 @@ void PixelProcessor::setBlendConstant(const Color<float> &blendConstant)
 	factor.invBlendConstant4F[3] = float4(1 - blendConstant.a);
 }
 
-void PixelProcessor::setRoutineCacheSize(int cacheSize)
-{
-	delete routineCache;
-	routineCache = new RoutineCacheType(clamp(cacheSize, 1, 65536));
-}
-
-const PixelProcessor::State PixelProcessor::update(const Context *context) const
+const PixelProcessor::State PixelProcessor::update(const Context *context)
 {
 	State state;
 
@@ -120,7 +110,7 @@ const PixelProcessor::State PixelProcessor::update(const Context *context) const
 	{
 		state.depthTestActive = true;
 		state.depthCompareMode = context->depthCompareMode;
-		state.depthFormat = context->depthBuffer->getFormat();
+		state.depthFormat = context->depthBufferFormat;
 	}
 
 	state.occlusionEnabled = context->occlusionEnabled;
@@ -145,6 +135,46 @@ const PixelProcessor::State PixelProcessor::update(const Context *context) const
 
 	state.frontFace = context->frontFace;
 
+	// Only single-sampled 32-bit float depth attachments have a hierarchical
+	// depth buffer. It must be kept up to date by all draws which write depth,
+	// but can only reject the quads of draws which would otherwise have no
+	// side effects when failing the depth test.
+	if(state.depthTestActive && (state.multiSampleCount == 1) &&
+	   ((state.depthFormat == VK_FORMAT_D32_SFLOAT) || (state.depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT)))
+	{
+		bool earlyDepthTest = !context->pixelShader ||
+		                      (context->pixelShader->getModes().EarlyFragmentTests &&
+		                       !context->pixelShader->getModes().DepthReplacing &&
+		                       !state.alphaToCoverage);
+
+		switch(state.depthCompareMode)
+		{
+			case VK_COMPARE_OP_LESS:
+			case VK_COMPARE_OP_LESS_OR_EQUAL:
+			case VK_COMPARE_OP_GREATER:
+			case VK_COMPARE_OP_GREATER_OR_EQUAL:
+			case VK_COMPARE_OP_EQUAL:
+				state.hiZTest = earlyDepthTest && !state.stencilActive;
+				break;
+			default:
+				state.hiZTest = false;
+		}
+
+		state.hiZUpdate = state.depthWriteEnable;
+	}
+
+	// Pending clears are resolved by the draws which touch the attachment. The
+	// attachment formats tell whether they may have any.
+	if(state.multiSampleCount == 1)
+	{
+		for(int i = 0; i < RENDERTARGETS; i++)
+		{
+			state.deferredClear[i] = state.colorWriteActive(i) && vk::ImageView::SupportsDeferredClear(state.targetFormat[i]);
+		}
+
+		state.deferredDepthClear = state.depthTestActive && vk::ImageView::SupportsDeferredClear(state.depthFormat);
+	}
+
 	state.hash = state.computeHash();
 
 	return state;
@@ -155,18 +185,87 @@ PixelProcessor::RoutineType PixelProcessor::routine(const State &state,
                                                     SpirvShader const *pixelShader,
                                                     const vk::DescriptorSet::Bindings &descriptorSets)
 {
-	auto routine = routineCache->query(state);
+	auto routine = RoutineCacheType::get().query(state);
 
 	if(!routine)
 	{
-		QuadRasterizer *generator = new PixelProgram(state, pipelineLayout, pixelShader, descriptorSets);
-		generator->generate();
-		routine = (*generator)("PixelRoutine_%0.8X", state.shaderID);
-		delete generator;
+		routine = generate(state, pipelineLayout, pixelShader, descriptorSets);
+		RoutineCacheType::get().add(state, routine);
+	}
+
+	return routine;
+}
+
+PixelProcessor::RoutineType PixelProcessor::optimizedRoutine(const State &state,
+                                                             vk::PipelineLayout const *pipelineLayout,
+                                                             SpirvShader const *pixelShader)
+{
+	if(state.optimized || !pixelShader->countDraw())
+	{
+		return {};
+	}
 
-		routineCache->add(state, routine);
+	State optimized = state;
+	optimized.optimized = true;
+	optimized.hash = optimized.computeHash();
+
+	if(auto routine = RoutineCacheType::get().query(optimized))
+	{
+		return routine;
 	}
 
+	// Keys of specialized routines have a non-zero sampling version in the
+	// upper half, so they don't collide with this one.
+	pixelShader->buildInBackground(optimized.hash, [=] {
+		RoutineCacheType::get().add(optimized, generate(optimized, pipelineLayout, pixelShader, {}));
+	});
+
+	return {};
+}
+
+PixelProcessor::RoutineType PixelProcessor::specializedRoutine(const State &state,
+                                                               vk::PipelineLayout const *pipelineLayout,
+                                                               SpirvShader const *pixelShader)
+{
+	uint32_t samplingVersion = pixelShader->getStableSamplingVersion();
+	if(samplingVersion == 0)
+	{
+		return {};
+	}
+
+	State specialized = state;
+	specialized.samplingVersion = samplingVersion;
+	specialized.optimized = true;
+	specialized.hash = specialized.computeHash();
+
+	if(auto routine = RoutineCacheType::get().query(specialized))
+	{
+		return routine;
+	}
+
+	uint64_t key = (static_cast<uint64_t>(samplingVersion) << 32) | specialized.hash;
+	pixelShader->buildInBackground(key, [=] {
+		RoutineCacheType::get().add(specialized, generate(specialized, pipelineLayout, pixelShader, {}));
+	});
+
+	return {};
+}
+
+CacheStats PixelProcessor::getCacheStats()
+{
+	return RoutineCacheType::get().getStats();
+}
+
+PixelProcessor::RoutineType PixelProcessor::generate(const State &state,
+                                                     vk::PipelineLayout const *pipelineLayout,
+                                                     SpirvShader const *pixelShader,
+                                                     const vk::DescriptorSet::Bindings &descriptorSets)
+{
+	QuadRasterizer *generator = new PixelProgram(state, pipelineLayout, pixelShader, descriptorSets);
+	generator->generate();
+	auto routine = (*generator)(drawRoutineConfig(state.optimized), "PixelRoutine_%0.8X", state.shaderID);
+	delete generator;
+
 	return routine;
 }
 
@@ -19,6 +19,7 @@
 #include "Context.hpp"
 #include "Memset.hpp"
 #include "RoutineCache.hpp"
+#include "SharedRoutineCache.hpp"
 
 namespace sw {
 
@@ -27,8 +28,9 @@ class Rasterizer;
 struct Texture;
 struct DrawData;
 struct Primitive;
+struct Tile;
 
-using RasterizerFunction = FunctionT<void(const Primitive *primitive, int count, int cluster, int clusterCount, DrawData *draw)>;
+using RasterizerFunction = FunctionT<void(const Primitive *primitive, int count, int cluster, int clusterCount, DrawData *draw, const Tile *tile)>;
 
 class PixelProcessor
 {
@@ -91,6 +93,23 @@ public:
 		bool centroid;
 		VkFrontFace frontFace;
 		VkFormat depthFormat;
+
+		// Hierarchical depth buffer usage, see vk::ImageView::getHiZPointer()
+		bool hiZTest;
+		bool hiZUpdate;
+
+		// Attachments which may have deferred clears pending, see
+		// vk::ImageView::hasDeferredClear()
+		bool deferredClear[RENDERTARGETS];
+		bool deferredDepthClear;
+
+		// SpirvShader::getStableSamplingVersion() the routine inlines sampling
+		// for, or zero if it doesn't.
+		uint32_t samplingVersion;
+
+		// Built at the default optimization level rather than the quicker to
+		// compile first tier, see TIERED_COMPILATION_THRESHOLD.
+		bool optimized;
 	};
 
 	struct State : States
@@ -151,18 +170,36 @@ public:
 
 	void setBlendConstant(const Color<float> &blendConstant);
 
+	static const State update(const Context *context);
+
+	// Builds a routine without consulting or populating the routine cache.
+	static RoutineType generate(const State &state, vk::PipelineLayout const *pipelineLayout,
+	                            SpirvShader const *pixelShader, const vk::DescriptorSet::Bindings &descriptorSets);
+
+	// Queries of the process-wide routine cache.
+	static CacheStats getCacheStats();
+
+	// Returns the routine for the state built at the default optimization level
+	// once the shader is hot, scheduling it to be built in the background if it
+	// hasn't been yet. Returns a null routine until it is available.
+	static RoutineType optimizedRoutine(const State &state, vk::PipelineLayout const *pipelineLayout,
+	                                    SpirvShader const *pixelShader);
+
+	// Returns the routine for the state with sampling inlined for the descriptors
+	// the shader has been seeing, see SpirvShader::SamplingProfile. If it hasn't
+	// been built yet, starts building it on a worker thread and returns null.
+	static RoutineType specializedRoutine(const State &state, vk::PipelineLayout const *pipelineLayout,
+	                                      SpirvShader const *pixelShader);
+
 protected:
-	const State update(const Context *context) const;
 	RoutineType routine(const State &state, vk::PipelineLayout const *pipelineLayout,
 	                    SpirvShader const *pixelShader, const vk::DescriptorSet::Bindings &descriptorSets);
-	void setRoutineCacheSize(int routineCacheSize);
 
 	// Other semi-constants
 	Factor factor;
 
 private:
-	using RoutineCacheType = RoutineCacheT<State, RasterizerFunction::CFunctionType>;
-	RoutineCacheType *routineCache;
+	using RoutineCacheType = SharedRoutineCache<State, RasterizerFunction::CFunctionType>;
 };
 
 }  // namespace sw
@@ -60,6 +60,8 @@ struct Primitive MEMORY_SANITIZER_ONLY(
 
 	int yMin;
 	int yMax;
+	int xMin;  // Conservative horizontal extent, for binning
+	int xMax;
 
 	float4 xQuad;
 	float4 yQuad;
@@ -78,17 +80,24 @@ struct Primitive MEMORY_SANITIZER_ONLY(
 	int64_t clockwiseMask;
 	int64_t invClockwiseMask;
 
-	struct Span
+	// Incremental form of a polygon edge, as produced by the setup routine's
+	// DDA. The column crossed at row y, for yMin <= y < yMax, is
+	// x + k * Q + (d + k * R + D - 1) / D, with k = y - yMin.
+	struct Edge
 	{
-		unsigned short left;
-		unsigned short right;
+		int yMin;
+		int yMax;
+		int x;      // Column at yMin
+		int d;      // Error term at yMin, in (-D, 0]
+		int Q;      // Edge step
+		int R;      // Error step, in [0, D)
+		int D;      // Error overflow
+		int right;  // Non-zero if the edge bounds the polygon on the right
 	};
 
-	// The rasterizer adds a zero length span to the top and bottom of the polygon to allow
-	// for 2x2 pixel processing. We need an even number of spans to keep accesses aligned.
-	Span outlineUnderflow[2];
-	Span outline[OUTLINE_RESOLUTION];
-	Span outlineOverflow[2];
+	// Rows not crossed by any left and right edge pair are empty.
+	int edgeCount;
+	Edge edge[16];  // One per side of the clipped polygon
 };
 
 }  // namespace sw
@@ -37,12 +37,15 @@ void QuadRasterizer::generate()
 	constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, constants));
 	occlusion = 0;
 
+	// Rows are interleaved between clusters in pairs, unless the cluster
+	// rasterizes a whole tile, which is indicated by a cluster count of 1.
+	Int cluster2 = IfThenElse(clusterCount == 1, Int(0), cluster + cluster);
+
 	Do
 	{
-		Int yMin = *Pointer<Int>(primitive + OFFSET(Primitive, yMin));
-		Int yMax = *Pointer<Int>(primitive + OFFSET(Primitive, yMax));
+		Int yMin = Max(*Pointer<Int>(primitive + OFFSET(Primitive, yMin)), *Pointer<Int>(tile + OFFSET(Tile, y0)));
+		Int yMax = Min(*Pointer<Int>(primitive + OFFSET(Primitive, yMax)), *Pointer<Int>(tile + OFFSET(Tile, y1)));
 
-		Int cluster2 = cluster + cluster;
 		yMin += clusterCount * 2 - 2 - cluster2;
 		yMin &= -clusterCount * 2;
 		yMin += cluster2;
@@ -93,34 +96,59 @@ void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 		sBuffer = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, stencilBuffer)) + yMin * *Pointer<Int>(data + OFFSET(DrawData, stencilPitchB));
 	}
 
+	Pointer<Byte> hiZ;
+
+	if(state.hiZTest || state.hiZUpdate)
+	{
+		hiZ = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, hiZ)) + (yMin / vk::HIZ_CELL_HEIGHT) * *Pointer<Int>(data + OFFSET(DrawData, hiZPitchB));
+	}
+
+	Pointer<Byte> clearCells[RENDERTARGETS];
+	Pointer<Byte> depthClearCells;
+	bool deferredClear = state.deferredDepthClear;
+
+	for(int index = 0; index < RENDERTARGETS; index++)
+	{
+		if(state.deferredClear[index])
+		{
+			clearCells[index] = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, colorClear[index].cells)) + (yMin / vk::CLEAR_CELL_HEIGHT) * *Pointer<Int>(data + OFFSET(DrawData, colorClear[index].cellsPitchB));
+			deferredClear = true;
+		}
+	}
+
+	if(state.deferredDepthClear)
+	{
+		depthClearCells = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, depthClear.cells)) + (yMin / vk::CLEAR_CELL_HEIGHT) * *Pointer<Int>(data + OFFSET(DrawData, depthClear.cellsPitchB));
+	}
+
 	Int y = yMin;
 
 	Do
 	{
-		Int x0a = Int(*Pointer<Short>(primitive + OFFSET(Primitive, outline->left) + (y + 0) * sizeof(Primitive::Span)));
-		Int x0b = Int(*Pointer<Short>(primitive + OFFSET(Primitive, outline->left) + (y + 1) * sizeof(Primitive::Span)));
-		Int x0 = Min(x0a, x0b);
+		// Spans of rows y and y + 1, for each sample
+		Int left[4][2];
+		Int right[4][2];
 
-		for(unsigned int q = 1; q < state.multiSampleCount; q++)
+		for(unsigned int q = 0; q < state.multiSampleCount; q++)
 		{
-			x0a = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline->left) + (y + 0) * sizeof(Primitive::Span)));
-			x0b = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline->left) + (y + 1) * sizeof(Primitive::Span)));
-			x0 = Min(x0, Min(x0a, x0b));
+			span(q, y + 0, left[q][0], right[q][0]);
+			span(q, y + 1, left[q][1], right[q][1]);
 		}
 
-		x0 &= 0xFFFFFFFE;
-
-		Int x1a = Int(*Pointer<Short>(primitive + OFFSET(Primitive, outline->right) + (y + 0) * sizeof(Primitive::Span)));
-		Int x1b = Int(*Pointer<Short>(primitive + OFFSET(Primitive, outline->right) + (y + 1) * sizeof(Primitive::Span)));
-		Int x1 = Max(x1a, x1b);
+		Int x0 = Min(left[0][0], left[0][1]);
+		Int x1 = Max(right[0][0], right[0][1]);
 
 		for(unsigned int q = 1; q < state.multiSampleCount; q++)
 		{
-			x1a = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline->right) + (y + 0) * sizeof(Primitive::Span)));
-			x1b = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline->right) + (y + 1) * sizeof(Primitive::Span)));
-			x1 = Max(x1, Max(x1a, x1b));
+			x0 = Min(x0, Min(left[q][0], left[q][1]));
+			x1 = Max(x1, Max(right[q][0], right[q][1]));
 		}
 
+		x0 = Max(x0, *Pointer<Int>(tile + OFFSET(Tile, x0)));
+		x1 = Min(x1, *Pointer<Int>(tile + OFFSET(Tile, x1)));
+
+		x0 &= 0xFFFFFFFE;
+
 		Float4 yyyy = Float4(Float(y)) + *Pointer<Float4>(primitive + OFFSET(Primitive, yQuad), 16);
 
 		if(interpolateZ())
@@ -178,33 +206,58 @@ void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 
 			for(unsigned int q = 0; q < state.multiSampleCount; q++)
 			{
-				xLeft[q] = *Pointer<Short4>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline) + y * sizeof(Primitive::Span));
-				xRight[q] = xLeft[q];
+				xLeft[q] = Insert(Insert(Short4(left[q][0]), Short(left[q][1]), 2), Short(left[q][1]), 3);
+				xRight[q] = Insert(Insert(Short4(right[q][0]), Short(right[q][1]), 2), Short(right[q][1]), 3);
 
-				xLeft[q] = Swizzle(xLeft[q], 0x0022) - Short4(1, 2, 1, 2);
-				xRight[q] = Swizzle(xRight[q], 0x1133) - Short4(0, 1, 0, 1);
+				xLeft[q] = xLeft[q] - Short4(1, 2, 1, 2);
+				xRight[q] = xRight[q] - Short4(0, 1, 0, 1);
 			}
 
-			For(Int x = x0, x < x1, x += 2)
+			if(state.hiZTest || state.hiZUpdate || deferredClear)
 			{
-				Short4 xxxx = Short4(x);
-				Int cMask[4];
-
-				for(unsigned int q = 0; q < state.multiSampleCount; q++)
+				// Process the span one hierarchical depth cell at a time, so that
+				// occluded cells are skipped and written ones are kept up to date,
+				// and pending clears are resolved before the cell's pixels are read.
+				For(Int cx = x0 & -vk::HIZ_CELL_WIDTH, cx < x1, cx += vk::HIZ_CELL_WIDTH)
 				{
-					if(state.multiSampleMask & (1 << q))
+					Int cx0 = Max(cx, x0);
+					Int cx1 = Min(cx + vk::HIZ_CELL_WIDTH, x1);
+					Pointer<Byte> cell = hiZ + 8 * (cx / vk::HIZ_CELL_WIDTH);
+
+					Bool occluded = false;
+
+					if(state.hiZTest)
 					{
-						unsigned int i = state.enableMultiSampling ? q : 0;
-						Short4 mask = CmpGT(xxxx, xLeft[i]) & CmpGT(xRight[i], xxxx);
-						cMask[q] = SignMask(PackSigned(mask, mask)) & 0x0000000F;
+						occluded = hiZOccluded(cell, cx0, cx1);
 					}
-					else
+
+					If(!occluded)
 					{
-						cMask[q] = 0;
+						for(int index = 0; index < RENDERTARGETS; index++)
+						{
+							if(state.deferredClear[index])
+							{
+								resolveDeferredClear(clearCells[index], cBuffer[index], OFFSET(DrawData, colorClear[index]), OFFSET(DrawData, colorPitchB[index]), cx, y);
+							}
+						}
+
+						if(state.deferredDepthClear)
+						{
+							resolveDeferredClear(depthClearCells, zBuffer, OFFSET(DrawData, depthClear), OFFSET(DrawData, depthPitchB), cx, y);
+						}
+
+						rasterizeQuads(cBuffer, zBuffer, sBuffer, xLeft, xRight, cx0, cx1, y);
+
+						if(state.hiZUpdate)
+						{
+							updateHiZ(cell, zBuffer, cx, y);
+						}
 					}
 				}
-
-				quad(cBuffer, zBuffer, sBuffer, cMask, x, y);
+			}
+			else
+			{
+				rasterizeQuads(cBuffer, zBuffer, sBuffer, xLeft, xRight, x0, x1, y);
 			}
 		}
 
@@ -226,11 +279,187 @@ void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 			sBuffer += *Pointer<Int>(data + OFFSET(DrawData, stencilPitchB)) << (1 + clusterCountLog2);  // FIXME: Precompute
 		}
 
+		if(state.hiZTest || state.hiZUpdate)
+		{
+			hiZ += *Pointer<Int>(data + OFFSET(DrawData, hiZPitchB)) << clusterCountLog2;
+		}
+
+		for(int index = 0; index < RENDERTARGETS; index++)
+		{
+			if(state.deferredClear[index])
+			{
+				clearCells[index] += *Pointer<Int>(data + OFFSET(DrawData, colorClear[index].cellsPitchB)) << clusterCountLog2;
+			}
+		}
+
+		if(state.deferredDepthClear)
+		{
+			depthClearCells += *Pointer<Int>(data + OFFSET(DrawData, depthClear.cellsPitchB)) << clusterCountLog2;
+		}
+
 		y += 2 * clusterCount;
 	}
 	Until(y >= yMax);
 }
 
+void QuadRasterizer::rasterizeQuads(Pointer<Byte> cBuffer[4], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Short4 xLeft[4], Short4 xRight[4], Int &x0, Int &x1, Int &y)
+{
+	For(Int x = x0, x < x1, x += 2)
+	{
+		Short4 xxxx = Short4(x);
+		Int cMask[4];
+
+		for(unsigned int q = 0; q < state.multiSampleCount; q++)
+		{
+			if(state.multiSampleMask & (1 << q))
+			{
+				unsigned int i = state.enableMultiSampling ? q : 0;
+				Short4 mask = CmpGT(xxxx, xLeft[i]) & CmpGT(xRight[i], xxxx);
+				cMask[q] = SignMask(PackSigned(mask, mask)) & 0x0000000F;
+			}
+			else
+			{
+				cMask[q] = 0;
+			}
+		}
+
+		quad(cBuffer, zBuffer, sBuffer, cMask, x, y);
+	}
+}
+
+Bool QuadRasterizer::hiZOccluded(Pointer<Byte> &cell, Int &x0, Int &x1)
+{
+	// Depth is linear along the row pair, so its range over the quads from x0 to
+	// x1 is found at the first and last quad. Lanes outside of the primitive
+	// only make the range more conservative.
+	Float4 xQuad = *Pointer<Float4>(primitive + OFFSET(Primitive, xQuad), 16);
+	Float4 xFirst = Float4(Float(x0)) + xQuad;
+	Float4 xLast = Float4(Float(x0 + ((x1 - x0 - 1) & -2))) + xQuad;
+	Float4 rhw;  // Unused
+
+	Float4 zFirst = interpolate(xFirst, Dz[0], rhw, primitive + OFFSET(Primitive, z), false, false, state.depthClamp);
+	Float4 zLast = interpolate(xLast, Dz[0], rhw, primitive + OFFSET(Primitive, z), false, false, state.depthClamp);
+
+	Float4 zMin4 = Min(zFirst, zLast);
+	Float4 zMax4 = Max(zFirst, zLast);
+	Float zMin = Min(Min(Extract(zMin4, 0), Extract(zMin4, 1)), Min(Extract(zMin4, 2), Extract(zMin4, 3)));
+	Float zMax = Max(Max(Extract(zMax4, 0), Extract(zMax4, 1)), Max(Extract(zMax4, 2), Extract(zMax4, 3)));
+
+	Float cellMin = *Pointer<Float>(cell + 0);
+	Float cellMax = *Pointer<Float>(cell + 4);
+
+	switch(state.depthCompareMode)
+	{
+		case VK_COMPARE_OP_LESS:
+			return zMin >= cellMax;
+		case VK_COMPARE_OP_LESS_OR_EQUAL:
+			return zMin > cellMax;
+		case VK_COMPARE_OP_GREATER:
+			return zMax <= cellMin;
+		case VK_COMPARE_OP_GREATER_OR_EQUAL:
+			return zMax < cellMin;
+		case VK_COMPARE_OP_EQUAL:
+			return (zMax < cellMin) || (zMin > cellMax);
+		default:
+			UNREACHABLE("VkCompareOp: %d", int(state.depthCompareMode));
+			return false;
+	}
+}
+
+void QuadRasterizer::updateHiZ(Pointer<Byte> &cell, Pointer<Byte> &zBuffer, Int &x, Int &y)
+{
+	// Incomplete cells at the right and bottom edges are never known.
+	If(x < *Pointer<Int>(data + OFFSET(DrawData, hiZX1)) && y < *Pointer<Int>(data + OFFSET(DrawData, hiZY1)))
+	{
+		Int pitchB = *Pointer<Int>(data + OFFSET(DrawData, depthPitchB));
+		Pointer<Byte> buffer = zBuffer + 4 * x;
+
+		Float4 zMin4 = *Pointer<Float4>(buffer, 4);
+		Float4 zMax4 = zMin4;
+
+		for(int row = 0; row < vk::HIZ_CELL_HEIGHT; row++)
+		{
+			for(int i = 0; i < vk::HIZ_CELL_WIDTH; i += 4)
+			{
+				Float4 z = *Pointer<Float4>(buffer + 4 * i, 4);
+				zMin4 = Min(zMin4, z);
+				zMax4 = Max(zMax4, z);
+			}
+
+			buffer += pitchB;
+		}
+
+		*Pointer<Float>(cell + 0) = Min(Min(Extract(zMin4, 0), Extract(zMin4, 1)), Min(Extract(zMin4, 2), Extract(zMin4, 3)));
+		*Pointer<Float>(cell + 4) = Max(Max(Extract(zMax4, 0), Extract(zMax4, 1)), Max(Extract(zMax4, 2), Extract(zMax4, 3)));
+	}
+}
+
+void QuadRasterizer::resolveDeferredClear(Pointer<Byte> &cells, Pointer<Byte> &buffer, int clearOffset, int pitchOffset, Int &x, Int &y)
+{
+	// Only complete cells are ever pending.
+	If(x < *Pointer<Int>(data + clearOffset + OFFSET(DeferredClear, x1)) && y < *Pointer<Int>(data + clearOffset + OFFSET(DeferredClear, y1)))
+	{
+		Pointer<Byte> cell = cells + x / vk::CLEAR_CELL_WIDTH;
+
+		If(Int(*Pointer<Byte>(cell)) != 0)
+		{
+			Int4 pixel = Int4(*Pointer<Int>(data + clearOffset + OFFSET(DeferredClear, pixel)));
+			Int pitchB = *Pointer<Int>(data + pitchOffset);
+			Pointer<Byte> row = buffer + 4 * x;
+
+			for(int j = 0; j < vk::CLEAR_CELL_HEIGHT; j++)
+			{
+				for(int i = 0; i < vk::CLEAR_CELL_WIDTH; i += 4)
+				{
+					*Pointer<Int4>(row + 4 * i, 4) = pixel;
+				}
+
+				row += pitchB;
+			}
+
+			*Pointer<Byte>(cell) = Byte(0);
+		}
+	}
+}
+
+void QuadRasterizer::span(unsigned int q, RValue<Int> y, Int &left, Int &right)
+{
+	Int xMin = *Pointer<Int>(data + OFFSET(DrawData, scissorX0));
+	Int xMax = *Pointer<Int>(data + OFFSET(DrawData, scissorX1));
+
+	// Rows which no edge crosses are left empty
+	left = xMax;
+	right = xMin;
+
+	Pointer<Byte> edge = primitive + q * sizeof(Primitive) + OFFSET(Primitive, edge);
+	Int edgeCount = *Pointer<Int>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, edgeCount));
+	Int row = y;
+
+	For(Int i = 0, i < edgeCount, i++)
+	{
+		Int yMin = *Pointer<Int>(edge + OFFSET(Primitive::Edge, yMin));
+		Int yMax = *Pointer<Int>(edge + OFFSET(Primitive::Edge, yMax));
+
+		If(row >= yMin && row < yMax)
+		{
+			Int k = row - yMin;
+			Int d = *Pointer<Int>(edge + OFFSET(Primitive::Edge, d));
+			Int D = *Pointer<Int>(edge + OFFSET(Primitive::Edge, D));
+
+			Int x = *Pointer<Int>(edge + OFFSET(Primitive::Edge, x)) +
+			        k * *Pointer<Int>(edge + OFFSET(Primitive::Edge, Q)) +
+			        (d + k * *Pointer<Int>(edge + OFFSET(Primitive::Edge, R)) + D - 1) / D;
+			x = Clamp(x, xMin, xMax);
+
+			Bool isRight = *Pointer<Int>(edge + OFFSET(Primitive::Edge, right)) != 0;
+			left = IfThenElse(isRight, left, x);
+			right = IfThenElse(isRight, x, right);
+		}
+
+		edge += sizeof(Primitive::Edge);
+	}
+}
+
 Float4 QuadRasterizer::interpolate(Float4 &x, Float4 &D, Float4 &rhw, Pointer<Byte> planeEquation, bool flat, bool perspective, bool clamp)
 {
 	Float4 interpolant = D;
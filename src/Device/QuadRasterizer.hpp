@@ -53,6 +53,11 @@ protected:
 
 private:
 	void rasterize(Int &yMin, Int &yMax);
+	void span(unsigned int q, RValue<Int> y, Int &left, Int &right);
+	void rasterizeQuads(Pointer<Byte> cBuffer[4], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Short4 xLeft[4], Short4 xRight[4], Int &x0, Int &x1, Int &y);
+	Bool hiZOccluded(Pointer<Byte> &cell, Int &x0, Int &x1);
+	void updateHiZ(Pointer<Byte> &cell, Pointer<Byte> &zBuffer, Int &x, Int &y);
+	void resolveDeferredClear(Pointer<Byte> &cells, Pointer<Byte> &buffer, int clearOffset, int pitchOffset, Int &x, Int &y);
 };
 
 }  // namespace sw
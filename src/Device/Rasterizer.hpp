@@ -30,6 +30,7 @@ public:
 	    , cluster(Arg<2>())
 	    , clusterCount(Arg<3>())
 	    , data(Arg<4>())
+	    , tile(Arg<5>())
 	{}
 	virtual ~Rasterizer() {}
 
@@ -39,6 +40,7 @@ protected:
 	Int cluster;
 	Int clusterCount;
 	Pointer<Byte> data;
+	Pointer<Byte> tile;
 };
 
 }  // namespace sw
@@ -34,7 +34,13 @@
 
 #include "marl/containers.h"
 #include "marl/defer.h"
+#include "marl/scheduler.h"
 #include "marl/trace.h"
+#include "marl/waitgroup.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 
 #undef max
 
@@ -142,6 +148,64 @@ inline bool setBatchIndices(unsigned int batch[128][3], VkPrimitiveTopology topo
 	return true;
 }
 
+inline void setDeferredClear(DeferredClear &clear, const vk::ImageView *view, int layer)
+{
+	if(view->hasDeferredClear())
+	{
+		VkExtent2D cells = view->getClearCellsExtent();
+
+		clear.cells = view->getClearCellsPointer(layer);
+		clear.cellsPitchB = view->clearCellsPitchBytes();
+		clear.x1 = cells.width * vk::CLEAR_CELL_WIDTH;
+		clear.y1 = cells.height * vk::CLEAR_CELL_HEIGHT;
+		clear.pixel = view->getClearPixel();
+	}
+	else
+	{
+		// No cells are pending, so the pixel routine never reads them.
+		clear.cells = nullptr;
+		clear.cellsPitchB = 0;
+		clear.x1 = 0;
+		clear.y1 = 0;
+		clear.pixel = 0;
+	}
+}
+
+inline int workerThreadCount(vk::Device *device)
+{
+	marl::Scheduler *scheduler = device->getScheduler();
+	return scheduler ? scheduler->getWorkerThreadCount() : 0;
+}
+
+// Enough batches for every worker thread to process one, as long as they fit
+// within MaxBatchMemory.
+inline int chooseBatchCount(vk::Device *device)
+{
+	constexpr int memoryBound = static_cast<int>(MaxBatchMemory / sizeof(DrawCall::BatchData));
+	constexpr int maxBatchCount = std::max(MinBatchCount, std::min(MaxBatchCount, memoryBound));
+
+	return clamp(workerThreadCount(device), MinBatchCount, maxBatchCount);
+}
+
+// Enough vertex tasks for every worker thread to shade a chunk of unique
+// vertices, up to the number of chunks of the largest deduplicated draw.
+inline int chooseVertexTaskCount(vk::Device *device)
+{
+	return clamp(workerThreadCount(device), 1, static_cast<int>(MaxDeduplicatedVertices / DeduplicationChunkSize));
+}
+
+// At least one cluster per worker thread, so they can all rasterize at once.
+inline int chooseClusterCount(vk::Device *device)
+{
+	return clamp(ceilPow2(workerThreadCount(device)), MinClusterCount, MaxClusterCount);
+}
+
+inline bool useTiledRasterization()
+{
+	const char *env = getenv("SWIFTSHADER_TILED_RASTERIZATION");
+	return env && (atoi(env) != 0);
+}
+
 DrawCall::DrawCall()
 {
 	data = (DrawData *)allocate(sizeof(DrawData));
@@ -154,16 +218,17 @@ DrawCall::~DrawCall()
 }
 
 Renderer::Renderer(vk::Device *device)
-    : device(device)
+    : batchDataPool(chooseBatchCount(device))
+    , vertexTaskPool(chooseVertexTaskCount(device))
+    , clusterCount(chooseClusterCount(device))
+    , tiledRasterization(useTiledRasterization())
+    , device(device)
 {
-	VertexProcessor::setRoutineCacheSize(1024);
-	PixelProcessor::setRoutineCacheSize(1024);
-	SetupProcessor::setRoutineCacheSize(1024);
 }
 
 Renderer::~Renderer()
 {
-	drawTickets.take().wait();
+	tickets.take().wait();
 }
 
 // Renderer objects have to be mem aligned to the alignment provided in the class declaration
@@ -219,9 +284,45 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 		setupState = SetupProcessor::update(context);
 		pixelState = PixelProcessor::update(context);
 
-		vertexRoutine = VertexProcessor::routine(vertexState, context->pipelineLayout, context->vertexShader, context->descriptorSets);
-		setupRoutine = SetupProcessor::routine(setupState);
-		pixelRoutine = PixelProcessor::routine(pixelState, context->pipelineLayout, context->pixelShader, context->descriptorSets);
+		auto precompiled = context->precompiledRoutines;
+
+		vertexRoutine = (precompiled && precompiled->vertexState == vertexState)
+		                    ? precompiled->vertexRoutine
+		                    : VertexProcessor::routine(vertexState, context->pipelineLayout, context->vertexShader, context->descriptorSets);
+		setupRoutine = (precompiled && precompiled->setupState == setupState)
+		                   ? precompiled->setupRoutine
+		                   : SetupProcessor::routine(setupState);
+		pixelRoutine = (precompiled && precompiled->pixelState == pixelState)
+		                   ? precompiled->pixelRoutine
+		                   : PixelProcessor::routine(pixelState, context->pipelineLayout, context->pixelShader, context->descriptorSets);
+	}
+
+	if(vk::TIERED_COMPILATION_THRESHOLD > 0)
+	{
+		// Switch to the routines built at the default optimization level once
+		// they have been.
+		if(auto optimized = VertexProcessor::optimizedRoutine(vertexState, context->pipelineLayout, context->vertexShader))
+		{
+			vertexRoutine = optimized;
+		}
+
+		if(context->pixelShader)
+		{
+			if(auto optimized = PixelProcessor::optimizedRoutine(pixelState, context->pipelineLayout, context->pixelShader))
+			{
+				pixelRoutine = optimized;
+			}
+		}
+	}
+
+	const bool specializeSampling = context->pixelShader && (vk::SAMPLING_SPECIALIZATION_THRESHOLD > 0);
+	if(specializeSampling)
+	{
+		// Switch to the routine with sampling inlined once it has been built.
+		if(auto specialized = PixelProcessor::specializedRoutine(pixelState, context->pipelineLayout, context->pixelShader))
+		{
+			pixelRoutine = specialized;
+		}
 	}
 
 	DrawCall::SetupFunction setupPrimitives = nullptr;
@@ -259,9 +360,16 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 	DrawData *data = draw->data;
 	draw->occlusionQuery = occlusionQuery;
 	draw->batchDataPool = &batchDataPool;
+	draw->vertexTaskPool = &vertexTaskPool;
 	draw->numPrimitives = count;
 	draw->numPrimitivesPerBatch = numPrimitivesPerBatch;
 	draw->numBatches = (count + draw->numPrimitivesPerBatch - 1) / draw->numPrimitivesPerBatch;
+	draw->clusterCount = clusterCount;
+	draw->tiledRasterization = tiledRasterization;
+	// Only shadeUniqueVertices() sets verticesDeduplicated, and pooled draw calls
+	// would otherwise keep the value of their previous draw.
+	draw->deduplicateVertices = DeduplicateVertices && indexBuffer && !vertexState.isPoint && (draw->numBatches > 1);
+	draw->verticesDeduplicated = false;
 	draw->topology = context->topology;
 	draw->provokingVertexMode = context->provokingVertexMode;
 	draw->indexType = indexType;
@@ -275,6 +383,7 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 
 	data->descriptorSets = context->descriptorSets;
 	data->descriptorDynamicOffsets = context->descriptorDynamicOffsets;
+	data->samplingProfiles = specializeSampling ? context->pixelShader->getSamplingProfiles() : nullptr;
 
 	for(int i = 0; i < MAX_INTERFACE_COMPONENTS / 4; i++)
 	{
@@ -318,7 +427,7 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 
 	if(pixelState.occlusionEnabled)
 	{
-		for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+		for(int cluster = 0; cluster < clusterCount; cluster++)
 		{
 			data->occlusion[cluster] = 0;
 		}
@@ -363,6 +472,11 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 				data->colorBuffer[index] = (unsigned int *)context->renderTarget[index]->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_COLOR_BIT, 0, data->viewID);
 				data->colorPitchB[index] = context->renderTarget[index]->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
 				data->colorSliceB[index] = context->renderTarget[index]->slicePitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+
+				if(pixelState.deferredClear[index])
+				{
+					setDeferredClear(data->colorClear[index], context->renderTarget[index], data->viewID);
+				}
 			}
 		}
 
@@ -374,6 +488,22 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 			data->depthBuffer = (float *)context->depthBuffer->getOffsetPointer({ 0, 0, 0 }, VK_IMAGE_ASPECT_DEPTH_BIT, 0, data->viewID);
 			data->depthPitchB = context->depthBuffer->rowPitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
 			data->depthSliceB = context->depthBuffer->slicePitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
+
+			if(pixelState.hiZTest || pixelState.hiZUpdate)
+			{
+				VkExtent3D extent = context->depthBuffer->getMipLevelExtent(0);
+
+				data->hiZ = context->depthBuffer->getHiZPointer(data->viewID);
+				data->hiZPitchB = context->depthBuffer->hiZPitchBytes();
+				data->hiZX1 = extent.width & -vk::HIZ_CELL_WIDTH;
+				data->hiZY1 = extent.height & -vk::HIZ_CELL_HEIGHT;
+				ASSERT(data->hiZ);
+			}
+
+			if(pixelState.deferredDepthClear)
+			{
+				setDeferredClear(data->depthClear, context->depthBuffer, data->viewID);
+			}
 		}
 
 		if(draw->stencilBuffer)
@@ -399,7 +529,7 @@ void Renderer::draw(const sw::Context *context, VkIndexType indexType, unsigned
 
 	draw->events = events;
 
-	DrawCall::run(draw, &drawTickets, clusterQueues);
+	DrawCall::run(draw, &tickets, clusterQueues);
 }
 
 void DrawCall::setup()
@@ -415,6 +545,16 @@ void DrawCall::setup()
 	}
 }
 
+// Frees the memory of a scratch vector which grew beyond maxRetained elements.
+template<typename T>
+inline void releaseScratch(std::vector<T> &scratch, size_t maxRetained)
+{
+	if(scratch.capacity() > maxRetained)
+	{
+		std::vector<T>().swap(scratch);
+	}
+}
+
 void DrawCall::teardown()
 {
 	if(events)
@@ -425,7 +565,7 @@ void DrawCall::teardown()
 
 	if(occlusionQuery != nullptr)
 	{
-		for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+		for(int cluster = 0; cluster < clusterCount; cluster++)
 		{
 			occlusionQuery->add(data->occlusion[cluster]);
 		}
@@ -435,6 +575,16 @@ void DrawCall::teardown()
 	vertexRoutine = {};
 	setupRoutine = {};
 	pixelRoutine = {};
+
+	if(shadedVertexCapacity > MaxRetainedDeduplicatedVertices)
+	{
+		shadedVertices.reset();
+		shadedVertexCapacity = 0;
+	}
+
+	releaseScratch(vertexSlots, 3 * MaxRetainedDeduplicatedVertices);
+	releaseScratch(indexSlots, 4 * MaxRetainedDeduplicatedVertices);
+	releaseScratch(uniqueIndices, MaxRetainedDeduplicatedVertices + 3);
 }
 
 void DrawCall::run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *tickets, marl::Ticket::Queue clusterQueues[MaxClusterCount])
@@ -444,6 +594,7 @@ void DrawCall::run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *ticket
 	auto const numPrimitives = draw->numPrimitives;
 	auto const numPrimitivesPerBatch = draw->numPrimitivesPerBatch;
 	auto const numBatches = draw->numBatches;
+	auto const clusterCount = draw->clusterCount;
 
 	auto ticket = tickets->take();
 	auto finally = marl::make_shared_finally([draw, ticket] {
@@ -452,6 +603,12 @@ void DrawCall::run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *ticket
 		ticket.done();
 	});
 
+	if(draw->deduplicateVertices)
+	{
+		draw->verticesShaded.clear();
+		marl::schedule([draw] { shadeUniqueVertices(draw.get()); });
+	}
+
 	for(unsigned int batchId = 0; batchId < numBatches; batchId++)
 	{
 		auto batch = draw->batchDataPool->borrow();
@@ -459,12 +616,17 @@ void DrawCall::run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *ticket
 		batch->firstPrimitive = batch->id * numPrimitivesPerBatch;
 		batch->numPrimitives = std::min(batch->firstPrimitive + numPrimitivesPerBatch, numPrimitives) - batch->firstPrimitive;
 
-		for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+		for(int cluster = 0; cluster < clusterCount; cluster++)
 		{
 			batch->clusterTickets[cluster] = std::move(clusterQueues[cluster].take());
 		}
 
-		marl::schedule([draw, batch, finally] {
+		marl::schedule([draw, batch, finally, clusterCount] {
+			if(draw->deduplicateVertices)
+			{
+				draw->verticesShaded.wait();
+			}
+
 			processVertices(draw.get(), batch.get());
 
 			if(!draw->setupState.rasterizerDiscard)
@@ -478,7 +640,7 @@ void DrawCall::run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *ticket
 				}
 			}
 
-			for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+			for(int cluster = 0; cluster < clusterCount; cluster++)
 			{
 				batch->clusterTickets[cluster].done();
 			}
@@ -486,10 +648,111 @@ void DrawCall::run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *ticket
 	}
 }
 
+void DrawCall::shadeUniqueVertices(DrawCall *draw)
+{
+	MARL_SCOPED_EVENT("UNIQUE VERTICES draw %d", draw->id);
+
+	draw->verticesDeduplicated = false;
+	defer(draw->verticesShaded.signal());
+
+	// Collect the vertex indices of all primitives, the same way the batches would.
+	auto &vertexSlots = draw->vertexSlots;
+	vertexSlots.resize(3 * draw->numPrimitives);
+	for(unsigned int first = 0; first < draw->numPrimitives; first += draw->numPrimitivesPerBatch)
+	{
+		unsigned int triangleIndices[MaxBatchSize + 1][3];
+		unsigned int count = std::min(draw->numPrimitivesPerBatch, draw->numPrimitives - first);
+		processPrimitiveVertices(
+		    triangleIndices,
+		    draw->data->indices,
+		    draw->indexType,
+		    first,
+		    count,
+		    draw->topology,
+		    draw->provokingVertexMode);
+		memcpy(&vertexSlots[3 * first], triangleIndices, 3 * count * sizeof(uint32_t));
+	}
+
+	// Bound the size of indexSlots, so that filling it costs no more than the
+	// rest of the deduplication.
+	auto indexRange = std::minmax_element(vertexSlots.begin(), vertexSlots.end());
+	uint32_t minIndex = *indexRange.first;
+	if(*indexRange.second - minIndex >= std::min<size_t>(MaxDeduplicatedIndexRange, 4 * vertexSlots.size()))
+	{
+		return;
+	}
+
+	// Replace each index with the position of its first occurrence in uniqueIndices.
+	auto &indexSlots = draw->indexSlots;
+	auto &uniqueIndices = draw->uniqueIndices;
+	indexSlots.assign(*indexRange.second - minIndex + 1, ~0u);
+	uniqueIndices.clear();
+	for(auto &slot : vertexSlots)
+	{
+		uint32_t &indexSlot = indexSlots[slot - minIndex];
+		if(indexSlot == ~0u)
+		{
+			if(uniqueIndices.size() == MaxDeduplicatedVertices)
+			{
+				return;
+			}
+
+			indexSlot = static_cast<uint32_t>(uniqueIndices.size());
+			uniqueIndices.push_back(slot);
+		}
+
+		slot = indexSlot;
+	}
+
+	// Repeat the last index to allow for SIMD width overrun.
+	unsigned int uniqueCount = static_cast<unsigned int>(uniqueIndices.size());
+	uniqueIndices.insert(uniqueIndices.end(), 3, uniqueIndices.back());
+
+	if(uniqueCount > draw->shadedVertexCapacity)
+	{
+		draw->shadedVertices.reset(new Vertex[uniqueCount]);
+		draw->shadedVertexCapacity = uniqueCount;
+	}
+
+	marl::WaitGroup chunks;
+	for(unsigned int first = 0; first < uniqueCount; first += DeduplicationChunkSize)
+	{
+		auto vertexTask = draw->vertexTaskPool->borrow();
+		chunks.add();
+		marl::schedule([draw, first, uniqueCount, vertexTask, chunks] {
+			MARL_SCOPED_EVENT("VERTEX draw %d, unique vertex %d", draw->id, first);
+
+			vertexTask->primitiveStart = 0;
+			vertexTask->vertexCount = std::min(uniqueCount - first, DeduplicationChunkSize);
+			vertexTask->gatherShadedVertices = false;
+			vertexTask->vertexCache.clear();
+
+			draw->vertexRoutine(&draw->shadedVertices[first], &draw->uniqueIndices[first], vertexTask.get(), draw->data);
+			chunks.done();
+		});
+	}
+	chunks.wait();
+
+	draw->verticesDeduplicated = true;
+}
+
 void DrawCall::processVertices(DrawCall *draw, BatchData *batch)
 {
 	MARL_SCOPED_EVENT("VERTEX draw %d, batch %d", draw->id, batch->id);
 
+	auto &vertexTask = batch->vertexTask;
+
+	if(draw->verticesDeduplicated)
+	{
+		// Gather the vertices shaded by shadeUniqueVertices().
+		vertexTask.vertexCount = 3 * batch->numPrimitives;
+		vertexTask.gatherShadedVertices = true;
+		vertexTask.shadedVertices = draw->shadedVertices.get();
+
+		draw->vertexRoutine(&batch->triangles.front().v0, &draw->vertexSlots[3 * batch->firstPrimitive], &vertexTask, draw->data);
+		return;
+	}
+
 	unsigned int triangleIndices[MaxBatchSize + 1][3];  // One extra for SIMD width overrun. TODO: Adjust to dynamic batch size.
 	{
 		MARL_SCOPED_EVENT("processPrimitiveVertices");
@@ -503,10 +766,10 @@ void DrawCall::processVertices(DrawCall *draw, BatchData *batch)
 		    draw->provokingVertexMode);
 	}
 
-	auto &vertexTask = batch->vertexTask;
 	vertexTask.primitiveStart = batch->firstPrimitive;
 	// We're only using batch compaction for points, not lines
 	vertexTask.vertexCount = batch->numPrimitives * ((draw->topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST) ? 1 : 3);
+	vertexTask.gatherShadedVertices = false;
 	if(vertexTask.vertexCache.drawCall != draw->id)
 	{
 		vertexTask.vertexCache.clear();
@@ -538,22 +801,123 @@ void DrawCall::processPixels(const marl::Loan<DrawCall> &draw, const marl::Loan<
 		std::shared_ptr<marl::Finally> finally;
 	};
 	auto data = std::make_shared<Data>(draw, batch, finally);
-	for(int cluster = 0; cluster < MaxClusterCount; cluster++)
+	int clusterCount = draw->clusterCount;
+
+	if(draw->tiledRasterization)
+	{
+		// Only clusters owning a tile touched by the batch have any work.
+		int ms = draw->setupState.multiSampleCount;
+		bool clusterActive[MaxClusterCount] = {};
+
+		for(int i = 0; i < batch->numVisible; i++)
+		{
+			const Primitive &primitive = batch->primitives[i * ms];
+			int tileY0 = primitive.yMin / TileSize;
+			int tileY1 = std::min((primitive.yMax - 1) / TileSize, tileY0 + clusterCount - 1);
+			int tileX0 = primitive.xMin / TileSize;
+			int tileX1 = std::min((primitive.xMax - 1) / TileSize, tileX0 + clusterCount - 1);
+
+			for(int tileY = tileY0; tileY <= tileY1; tileY++)
+			{
+				for(int tileX = tileX0; tileX <= tileX1; tileX++)
+				{
+					clusterActive[tileCluster(tileX, tileY, clusterCount)] = true;
+				}
+			}
+		}
+
+		for(int cluster = 0; cluster < clusterCount; cluster++)
+		{
+			if(!clusterActive[cluster])
+			{
+				batch->clusterTickets[cluster].done();
+				continue;
+			}
+
+			batch->clusterTickets[cluster].onCall([data, cluster] {
+				auto &draw = data->draw;
+				auto &batch = data->batch;
+				MARL_SCOPED_EVENT("PIXEL draw %d, batch %d, cluster %d", draw->id, batch->id, cluster);
+				processTiles(draw.get(), batch.get(), cluster);
+				batch->clusterTickets[cluster].done();
+			});
+		}
+
+		return;
+	}
+
+	for(int cluster = 0; cluster < clusterCount; cluster++)
 	{
-		batch->clusterTickets[cluster].onCall([data, cluster] {
+		batch->clusterTickets[cluster].onCall([data, cluster, clusterCount] {
 			auto &draw = data->draw;
 			auto &batch = data->batch;
 			MARL_SCOPED_EVENT("PIXEL draw %d, batch %d, cluster %d", draw->id, batch->id, cluster);
-			draw->pixelRoutine(&batch->primitives.front(), batch->numVisible, cluster, MaxClusterCount, draw->data);
+			static const Tile everything = { 0, 0, INT_MAX, INT_MAX };
+			draw->pixelRoutine(&batch->primitives.front(), batch->numVisible, cluster, clusterCount, draw->data, &everything);
 			batch->clusterTickets[cluster].done();
 		});
 	}
 }
 
+int DrawCall::tileCluster(int tileX, int tileY, int clusterCount)
+{
+	// Neighboring tiles belong to different clusters. A tile always belongs to
+	// the same cluster, so that the cluster tickets keep its draws in order.
+	return (tileX + 4 * tileY) % clusterCount;
+}
+
+void DrawCall::processTiles(DrawCall *draw, BatchData *batch, int cluster)
+{
+	int ms = draw->setupState.multiSampleCount;
+	int count = batch->numVisible;
+	const Primitive *primitives = &batch->primitives.front();
+
+	// Bounds of the batch, in tiles
+	int tileX0 = INT_MAX;
+	int tileY0 = INT_MAX;
+	int tileX1 = 0;
+	int tileY1 = 0;
+
+	for(int i = 0; i < count; i++)
+	{
+		const Primitive &primitive = primitives[i * ms];
+		tileX0 = std::min(tileX0, primitive.xMin / TileSize);
+		tileY0 = std::min(tileY0, primitive.yMin / TileSize);
+		tileX1 = std::max(tileX1, (primitive.xMax - 1) / TileSize);
+		tileY1 = std::max(tileY1, (primitive.yMax - 1) / TileSize);
+	}
+
+	// Rasterize all the primitives of a tile before moving on to the next
+	// one, so the tile's color and depth data stays in cache.
+	for(int tileY = tileY0; tileY <= tileY1; tileY++)
+	{
+		for(int tileX = tileX0; tileX <= tileX1; tileX++)
+		{
+			if(tileCluster(tileX, tileY, draw->clusterCount) != cluster)
+			{
+				continue;
+			}
+
+			Tile tile = { tileX * TileSize, tileY * TileSize, (tileX + 1) * TileSize, (tileY + 1) * TileSize };
+
+			for(int i = 0; i < count; i++)
+			{
+				const Primitive &primitive = primitives[i * ms];
+
+				if(primitive.xMin < tile.x1 && primitive.xMax > tile.x0 &&
+				   primitive.yMin < tile.y1 && primitive.yMax > tile.y0)
+				{
+					draw->pixelRoutine(&primitive, 1, cluster, 1, draw->data, &tile);
+				}
+			}
+		}
+	}
+}
+
 void Renderer::synchronize()
 {
 	MARL_SCOPED_EVENT("synchronize");
-	auto ticket = drawTickets.take();
+	auto ticket = tickets.take();
 	ticket.wait();
 	device->updateSamplingRoutineConstCache();
 	ticket.done();
@@ -16,6 +16,7 @@
 #define sw_Renderer_hpp
 
 #include "Blitter.hpp"
+#include "BoundedPool.hpp"
 #include "PixelProcessor.hpp"
 #include "Plane.hpp"
 #include "Primitive.hpp"
@@ -24,6 +25,7 @@
 #include "Device/Config.hpp"
 #include "Vulkan/VkDescriptorSet.hpp"
 
+#include "marl/event.h"
 #include "marl/finally.h"
 #include "marl/pool.h"
 #include "marl/ticket.h"
@@ -32,6 +34,7 @@
 #include <list>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace vk {
 
@@ -52,13 +55,76 @@ class Resource;
 struct Constants;
 
 static constexpr int MaxBatchSize = 128;
-static constexpr int MaxBatchCount = 16;
-static constexpr int MaxClusterCount = 16;
 static constexpr int MaxDrawCount = 16;
 
+// The number of batches in flight and of rasterizer clusters are chosen by the
+// Renderer from the scheduler's worker thread count, within these bounds.
+// Cluster counts are powers of two, which the pixel routines rely on.
+static constexpr int MinBatchCount = 16;
+static constexpr int MaxBatchCount = 256;
+static constexpr int MinClusterCount = 16;
+static constexpr int MaxClusterCount = 64;
+
+// Upper bound on the memory held by the batches of one Renderer, in bytes,
+// which limits the batch count on hosts with many worker threads.
+static constexpr size_t MaxBatchMemory = 64 << 20;
+
+// In tiled rasterization mode, primitives are binned into TileSize x TileSize
+// screen tiles after setup, and each cluster rasterizes the tiles it owns.
+// Otherwise each cluster rasterizes every other pair of rows of all primitives.
+// The mode is enabled by setting SWIFTSHADER_TILED_RASTERIZATION to 1.
+static constexpr int TileSize = 64;  // Must be even
+
+// When enabled, indexed draws spanning several batches shade each vertex they
+// reference once, in chunks of DeduplicationChunkSize vertices, before the
+// batches gather them for primitive assembly. Otherwise each batch shades its
+// own vertices through a small vertex cache, which draws referencing more than
+// MaxDeduplicatedVertices vertices, or a wider range of indices than
+// MaxDeduplicatedIndexRange or four times their vertex count, also fall back to.
+// Draw calls keep the buffers of up to MaxRetainedDeduplicatedVertices vertices
+// for the next draw, and free larger ones when done.
+static constexpr bool DeduplicateVertices = true;
+static constexpr unsigned int DeduplicationChunkSize = 1024;
+static constexpr unsigned int MaxDeduplicatedVertices = 1 << 16;
+static constexpr unsigned int MaxDeduplicatedIndexRange = 1 << 18;
+static constexpr unsigned int MaxRetainedDeduplicatedVertices = DeduplicationChunkSize;
+
+// Screen region rasterized by an invocation of the pixel routine.
+struct Tile
+{
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+};
+
+// Draw routines built ahead of the first draw, for the states a graphics
+// pipeline is expected to be drawn with. Renderer::draw() only uses them if
+// the states it computes match.
+struct PrecompiledRoutines
+{
+	VertexProcessor::State vertexState;
+	SetupProcessor::State setupState;
+	PixelProcessor::State pixelState;
+
+	VertexProcessor::RoutineType vertexRoutine;
+	SetupProcessor::RoutineType setupRoutine;
+	PixelProcessor::RoutineType pixelRoutine;
+};
+
 using TriangleBatch = std::array<Triangle, MaxBatchSize>;
 using PrimitiveBatch = std::array<Primitive, MaxBatchSize>;
 
+// Deferred clear of an attachment, see vk::ImageView::hasDeferredClear().
+struct DeferredClear
+{
+	unsigned char *cells;
+	int cellsPitchB;
+	int x1;  // No cells are pending beyond these pixel coordinates
+	int y1;
+	unsigned int pixel;
+};
+
 struct DrawData
 {
 	const Constants *constants;
@@ -97,6 +163,12 @@ struct DrawData
 	float *depthBuffer;
 	int depthPitchB;
 	int depthSliceB;
+	float *hiZ;
+	int hiZPitchB;
+	int hiZX1;  // Cells beyond these pixel coordinates are incomplete
+	int hiZY1;
+	DeferredClear colorClear[RENDERTARGETS];
+	DeferredClear depthClear;
 	unsigned char *stencilBuffer;
 	int stencilPitchB;
 	int stencilSliceB;
@@ -112,13 +184,15 @@ struct DrawData
 	float4 a2c3;
 
 	PushConstantStorage pushConstants;
+
+	void *samplingProfiles;  // SpirvShader::SamplingProfile[] of the pixel shader, or null
 };
 
 struct DrawCall
 {
 	struct BatchData
 	{
-		using Pool = marl::BoundedPool<BatchData, MaxBatchCount, marl::PoolPolicy::Preserve>;
+		using Pool = sw::BoundedPool<BatchData, marl::PoolPolicy::Preserve>;
 
 		TriangleBatch triangles;
 		PrimitiveBatch primitives;
@@ -131,24 +205,31 @@ struct DrawCall
 	};
 
 	using Pool = marl::BoundedPool<DrawCall, MaxDrawCount, marl::PoolPolicy::Preserve>;
+	using VertexTaskPool = sw::BoundedPool<VertexTask, marl::PoolPolicy::Preserve>;
 	using SetupFunction = int (*)(Triangle *triangles, Primitive *primitives, const DrawCall *drawCall, int count);
 
 	DrawCall();
 	~DrawCall();
 
 	static void run(const marl::Loan<DrawCall> &draw, marl::Ticket::Queue *tickets, marl::Ticket::Queue clusterQueues[MaxClusterCount]);
+	static void shadeUniqueVertices(DrawCall *draw);
 	static void processVertices(DrawCall *draw, BatchData *batch);
 	static void processPrimitives(DrawCall *draw, BatchData *batch);
 	static void processPixels(const marl::Loan<DrawCall> &draw, const marl::Loan<BatchData> &batch, const std::shared_ptr<marl::Finally> &finally);
+	static void processTiles(DrawCall *draw, BatchData *batch, int cluster);
+	static int tileCluster(int tileX, int tileY, int clusterCount);
 	void setup();
 	void teardown();
 
 	int id;
 
 	BatchData::Pool *batchDataPool;
+	VertexTaskPool *vertexTaskPool;  // Tasks of shadeUniqueVertices()
 	unsigned int numPrimitives;
 	unsigned int numPrimitivesPerBatch;
 	unsigned int numBatches;
+	int clusterCount;
+	bool tiledRasterization;
 
 	VkPrimitiveTopology topology;
 	VkProvokingVertexModeEXT provokingVertexMode;
@@ -171,6 +252,16 @@ struct DrawCall
 
 	DrawData *data;
 
+	// Vertices shaded ahead of the batches, see DeduplicateVertices.
+	bool deduplicateVertices = false;   // Whether shadeUniqueVertices() runs for this draw
+	bool verticesDeduplicated = false;  // Whether it succeeded, once verticesShaded is signaled
+	marl::Event verticesShaded = marl::Event(marl::Event::Mode::Manual);
+	std::vector<uint32_t> vertexSlots;  // Index into shadedVertices of each primitive vertex
+	std::vector<uint32_t> indexSlots;   // Index into shadedVertices of each vertex index, less the smallest
+	std::vector<uint32_t> uniqueIndices;
+	std::unique_ptr<Vertex[]> shadedVertices;  // Not initialized, written by the vertex routine
+	unsigned int shadedVertexCapacity = 0;
+
 	static void processPrimitiveVertices(
 	    unsigned int triangleIndicesOut[MaxBatchSize + 1][3],
 	    const void *primitiveIndices,
@@ -215,6 +306,11 @@ public:
 
 	void advanceInstanceAttributes(Stream *inputs);
 
+	// Returns the queue of tickets tracking asynchronous work, i.e. draw calls
+	// and compute dispatches, in submission order. synchronize() waits for all
+	// tickets taken before it.
+	marl::Ticket::Queue *getTicketQueue() { return &tickets; }
+
 	void synchronize();
 
 private:
@@ -223,12 +319,15 @@ private:
 
 	DrawCall::Pool drawCallPool;
 	DrawCall::BatchData::Pool batchDataPool;
+	DrawCall::VertexTaskPool vertexTaskPool;
 
 	std::atomic<int> nextDrawID = { 0 };
 
 	vk::Query *occlusionQuery = nullptr;
-	marl::Ticket::Queue drawTickets;
+	marl::Ticket::Queue tickets;
 	marl::Ticket::Queue clusterQueues[MaxClusterCount];
+	const int clusterCount;
+	const bool tiledRasterization;
 
 	VertexProcessor::State vertexState;
 	SetupProcessor::State setupState;
@@ -18,6 +18,7 @@
 #include "LRUCache.hpp"
 
 #include "Reactor/Reactor.hpp"
+#include "Vulkan/VkConfig.h"
 
 namespace sw {
 
@@ -29,6 +30,18 @@ using RoutineCache = LRUCache<State, std::shared_ptr<Routine>>;
 template<class State, class FunctionType>
 using RoutineCacheT = LRUCache<State, RoutineT<FunctionType>>;
 
+// Configuration to build draw routines with. Unless optimized is set, they are
+// built at a lower optimization level, see vk::TIERED_COMPILATION_THRESHOLD.
+inline Config::Edit drawRoutineConfig(bool optimized)
+{
+	if(optimized || (vk::TIERED_COMPILATION_THRESHOLD == 0))
+	{
+		return Config::Edit::None;
+	}
+
+	return Config::Edit().set(Optimization::Level::Less);
+}
+
 }  // namespace sw
 
 #endif  // sw_RoutineCache_hpp
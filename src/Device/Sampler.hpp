@@ -17,6 +17,7 @@
 
 #include "Device/Color.hpp"
 #include "Device/Config.hpp"
+#include "Device/Memset.hpp"
 #include "System/Types.hpp"
 #include "Vulkan/VkFormat.h"
 
@@ -90,10 +91,17 @@ enum AddressingMode ENUM_UNDERLYING_TYPE_UNSIGNED_INT
 	ADDRESSING_LAST = ADDRESSING_TEXELFETCH
 };
 
-struct Sampler
+// Cleared at construction, so sampler states with equal members compare equal
+// with memcmp(), including their padding.
+struct Sampler : Memset<Sampler>
 {
+	Sampler()
+	    : Memset(this, 0)
+	{}
+
 	VkImageViewType textureType;
 	vk::Format textureFormat;
+	vk::Format compressedFormat;  // Block compressed format decoded into textureFormat, if any
 	FilterType textureFilter;
 	AddressingMode addressingModeU;
 	AddressingMode addressingModeV;
@@ -108,6 +116,7 @@ struct Sampler
 	VkBorderColor border;
 	bool unnormalizedCoordinates;
 	bool largeTexture;
+	bool tiledTexture;  // Texels stored in 4x4 tiles, addressed like compressed blocks
 
 	VkSamplerYcbcrModelConversion ycbcrModel;
 	bool studioSwing;    // Narrow range
@@ -53,17 +53,13 @@ bool SetupProcessor::State::operator==(const State &state) const
 
 SetupProcessor::SetupProcessor()
 {
-	routineCache = nullptr;
-	setRoutineCacheSize(1024);
 }
 
 SetupProcessor::~SetupProcessor()
 {
-	delete routineCache;
-	routineCache = nullptr;
 }
 
-SetupProcessor::State SetupProcessor::update(const sw::Context *context) const
+SetupProcessor::State SetupProcessor::update(const sw::Context *context)
 {
 	State state;
 
@@ -99,25 +95,30 @@ SetupProcessor::State SetupProcessor::update(const sw::Context *context) const
 
 SetupProcessor::RoutineType SetupProcessor::routine(const State &state)
 {
-	auto routine = routineCache->query(state);
+	auto routine = RoutineCacheType::get().query(state);
 
 	if(!routine)
 	{
-		SetupRoutine *generator = new SetupRoutine(state);
-		generator->generate();
-		routine = generator->getRoutine();
-		delete generator;
-
-		routineCache->add(state, routine);
+		routine = generate(state);
+		RoutineCacheType::get().add(state, routine);
 	}
 
 	return routine;
 }
 
-void SetupProcessor::setRoutineCacheSize(int cacheSize)
+CacheStats SetupProcessor::getCacheStats()
+{
+	return RoutineCacheType::get().getStats();
+}
+
+SetupProcessor::RoutineType SetupProcessor::generate(const State &state)
 {
-	delete routineCache;
-	routineCache = new RoutineCacheType(clamp(cacheSize, 1, 65536));
+	SetupRoutine *generator = new SetupRoutine(state);
+	generator->generate();
+	auto routine = generator->getRoutine();
+	delete generator;
+
+	return routine;
 }
 
 }  // namespace sw
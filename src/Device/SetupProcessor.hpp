@@ -18,6 +18,7 @@
 #include "Context.hpp"
 #include "Memset.hpp"
 #include "RoutineCache.hpp"
+#include "SharedRoutineCache.hpp"
 #include "System/Types.hpp"
 #include <Pipeline/SpirvShader.hpp>
 
@@ -72,15 +73,20 @@ public:
 
 	~SetupProcessor();
 
+	static State update(const sw::Context *context);
+
+	// Builds a routine without consulting or populating the routine cache.
+	static RoutineType generate(const State &state);
+
+	// Queries of the process-wide routine cache.
+	static CacheStats getCacheStats();
+
 protected:
-	State update(const sw::Context *context) const;
 	RoutineType routine(const State &state);
 
-	void setRoutineCacheSize(int cacheSize);
 
 private:
-	using RoutineCacheType = RoutineCacheT<State, SetupFunction::CFunctionType>;
-	RoutineCacheType *routineCache;
+	using RoutineCacheType = SharedRoutineCache<State, SetupFunction::CFunctionType>;
 };
 
 }  // namespace sw
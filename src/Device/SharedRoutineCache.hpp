@@ -0,0 +1,220 @@
+// Copyright 2020 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_SharedRoutineCache_hpp
+#define sw_SharedRoutineCache_hpp
+
+#include "LRUCache.hpp"
+#include "Reactor/Routine.hpp"
+#include "System/Math.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace sw {
+
+// SharedRoutineCache is a process-wide routine cache, shared by all renderers
+// of all devices. States are indexed by their hash into an open addressed
+// table, probing at most ProbeCount consecutive slots.
+//
+// Queries do not take any lock. Insertions are serialized, and when all the
+// probed slots are occupied, the entry whose routine is no longer referenced
+// outside of the cache is evicted first. Evicted entries are only deleted
+// once no query is in flight.
+template<class State, class FunctionType>
+class SharedRoutineCache
+{
+public:
+	using RoutineType = rr::RoutineT<FunctionType>;
+
+	explicit SharedRoutineCache(int n);
+	~SharedRoutineCache();
+
+	RoutineType query(const State &state);
+	void add(const State &state, const RoutineType &routine);
+
+	CacheStats getStats() const;
+
+	// Returns the process-wide cache for this State type.
+	static SharedRoutineCache &get();
+
+private:
+	static constexpr int ProbeCount = 8;
+
+	struct Entry
+	{
+		State state;
+		RoutineType routine;
+	};
+
+	int slotIndex(const State &state, int probe) const;
+	void collectGarbage();  // Requires insertMutex
+
+	const int size;
+	std::atomic<Entry *> *const slots;
+
+	// Number of queries currently reading the table. Evicted entries can be
+	// deleted when this is observed to be zero after they were unlinked.
+	std::atomic<int> readers = { 0 };
+
+	std::mutex insertMutex;
+	std::vector<Entry *> retired;  // guarded by insertMutex
+
+	std::atomic<uint64_t> hits = { 0 };
+	std::atomic<uint64_t> misses = { 0 };
+	std::atomic<uint64_t> evictions = { 0 };
+};
+
+template<class State, class FunctionType>
+SharedRoutineCache<State, FunctionType>::SharedRoutineCache(int n)
+    : size(ceilPow2(n))
+    , slots(new std::atomic<Entry *>[size])
+{
+	for(int i = 0; i < size; i++)
+	{
+		slots[i] = nullptr;
+	}
+}
+
+template<class State, class FunctionType>
+SharedRoutineCache<State, FunctionType>::~SharedRoutineCache()
+{
+	for(int i = 0; i < size; i++)
+	{
+		delete slots[i].load();
+	}
+
+	delete[] slots;
+
+	for(auto entry : retired)
+	{
+		delete entry;
+	}
+}
+
+template<class State, class FunctionType>
+SharedRoutineCache<State, FunctionType> &SharedRoutineCache<State, FunctionType>::get()
+{
+	static SharedRoutineCache cache(4096);
+	return cache;
+}
+
+template<class State, class FunctionType>
+int SharedRoutineCache<State, FunctionType>::slotIndex(const State &state, int probe) const
+{
+	// The state hashes are XOR folds, so spread them before masking.
+	uint32_t h = state.hash * 0x9E3779B1u;
+	return (int)(((h >> 16) ^ h) + probe) & (size - 1);
+}
+
+template<class State, class FunctionType>
+typename SharedRoutineCache<State, FunctionType>::RoutineType SharedRoutineCache<State, FunctionType>::query(const State &state)
+{
+	RoutineType routine;
+
+	readers++;
+
+	for(int probe = 0; probe < ProbeCount; probe++)
+	{
+		const Entry *entry = slots[slotIndex(state, probe)].load();
+
+		if(entry && entry->state == state)
+		{
+			routine = entry->routine;
+			break;
+		}
+	}
+
+	readers--;
+
+	if(routine)
+	{
+		hits.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		misses.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return routine;
+}
+
+template<class State, class FunctionType>
+void SharedRoutineCache<State, FunctionType>::add(const State &state, const RoutineType &routine)
+{
+	std::unique_lock<std::mutex> lock(insertMutex);
+
+	int victim = -1;
+
+	for(int probe = 0; probe < ProbeCount; probe++)
+	{
+		int index = slotIndex(state, probe);
+		const Entry *entry = slots[index].load();
+
+		if(!entry)
+		{
+			victim = index;
+			break;
+		}
+
+		if(entry->state == state)
+		{
+			return;  // Another thread compiled the same routine first.
+		}
+
+		// Prefer evicting routines which no renderer or pipeline holds on to.
+		if((victim == -1) || (entry->routine.useCount() == 1))
+		{
+			victim = index;
+		}
+	}
+
+	Entry *evicted = slots[victim].exchange(new Entry{ state, routine });
+
+	if(evicted)
+	{
+		retired.push_back(evicted);
+		evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	collectGarbage();
+}
+
+template<class State, class FunctionType>
+void SharedRoutineCache<State, FunctionType>::collectGarbage()
+{
+	// Queries which started after the entries were unlinked cannot observe
+	// them, so they are safe to delete if no query is currently in flight.
+	if(!retired.empty() && (readers.load() == 0))
+	{
+		for(auto entry : retired)
+		{
+			delete entry;
+		}
+
+		retired.clear();
+	}
+}
+
+template<class State, class FunctionType>
+CacheStats SharedRoutineCache<State, FunctionType>::getStats() const
+{
+	return { hits.load(), misses.load(), evictions.load() };
+}
+
+}  // namespace sw
+
+#endif  // sw_SharedRoutineCache_hpp
@@ -83,20 +83,10 @@ bool VertexProcessor::State::operator==(const State &state) const
 
 VertexProcessor::VertexProcessor()
 {
-	routineCache = nullptr;
-	setRoutineCacheSize(1024);
 }
 
 VertexProcessor::~VertexProcessor()
 {
-	delete routineCache;
-	routineCache = nullptr;
-}
-
-void VertexProcessor::setRoutineCacheSize(int cacheSize)
-{
-	delete routineCache;
-	routineCache = new RoutineCacheType(clamp(cacheSize, 1, 65536));
 }
 
 const VertexProcessor::State VertexProcessor::update(const sw::Context *context)
@@ -127,18 +117,57 @@ VertexProcessor::RoutineType VertexProcessor::routine(const State &state,
                                                       SpirvShader const *vertexShader,
                                                       const vk::DescriptorSet::Bindings &descriptorSets)
 {
-	auto routine = routineCache->query(state);
+	auto routine = RoutineCacheType::get().query(state);
 
 	if(!routine)  // Create one
 	{
-		VertexRoutine *generator = new VertexProgram(state, pipelineLayout, vertexShader, descriptorSets);
-		generator->generate();
-		routine = (*generator)("VertexRoutine_%0.8X", state.shaderID);
-		delete generator;
+		routine = generate(state, pipelineLayout, vertexShader, descriptorSets);
+		RoutineCacheType::get().add(state, routine);
+	}
 
-		routineCache->add(state, routine);
+	return routine;
+}
+
+VertexProcessor::RoutineType VertexProcessor::optimizedRoutine(const State &state,
+                                                               vk::PipelineLayout const *pipelineLayout,
+                                                               SpirvShader const *vertexShader)
+{
+	if(state.optimized || !vertexShader->countDraw())
+	{
+		return {};
 	}
 
+	State optimized = state;
+	optimized.optimized = true;
+	optimized.hash = optimized.computeHash();
+
+	if(auto routine = RoutineCacheType::get().query(optimized))
+	{
+		return routine;
+	}
+
+	vertexShader->buildInBackground(optimized.hash, [=] {
+		RoutineCacheType::get().add(optimized, generate(optimized, pipelineLayout, vertexShader, {}));
+	});
+
+	return {};
+}
+
+CacheStats VertexProcessor::getCacheStats()
+{
+	return RoutineCacheType::get().getStats();
+}
+
+VertexProcessor::RoutineType VertexProcessor::generate(const State &state,
+                                                       vk::PipelineLayout const *pipelineLayout,
+                                                       SpirvShader const *vertexShader,
+                                                       const vk::DescriptorSet::Bindings &descriptorSets)
+{
+	VertexRoutine *generator = new VertexProgram(state, pipelineLayout, vertexShader, descriptorSets);
+	generator->generate();
+	auto routine = (*generator)(drawRoutineConfig(state.optimized), "VertexRoutine_%0.8X", state.shaderID);
+	delete generator;
+
 	return routine;
 }
 
@@ -18,6 +18,7 @@
 #include "Context.hpp"
 #include "Memset.hpp"
 #include "RoutineCache.hpp"
+#include "SharedRoutineCache.hpp"
 #include "Vertex.hpp"
 #include "Pipeline/SpirvShader.hpp"
 
@@ -47,6 +48,11 @@ struct VertexTask
 	unsigned int vertexCount;
 	unsigned int primitiveStart;
 	VertexCache vertexCache;
+
+	// When set, the batch holds positions in shadedVertices, of vertices which
+	// were already shaded, instead of vertex indices.
+	bool gatherShadedVertices = false;
+	const Vertex *shadedVertices = nullptr;
 };
 
 using VertexRoutineFunction = FunctionT<void(Vertex *output, unsigned int *batch, VertexTask *vertextask, DrawData *draw)>;
@@ -82,6 +88,7 @@ public:
 		Input input[MAX_INTERFACE_COMPONENTS / 4];
 		bool robustBufferAccess : 1;
 		bool isPoint : 1;
+		bool optimized : 1;  // See PixelProcessor::States::optimized
 	};
 
 	struct State : States
@@ -97,16 +104,26 @@ public:
 
 	virtual ~VertexProcessor();
 
+	static const State update(const sw::Context *context);
+
+	// Builds a routine without consulting or populating the routine cache.
+	static RoutineType generate(const State &state, vk::PipelineLayout const *pipelineLayout,
+	                            SpirvShader const *vertexShader, const vk::DescriptorSet::Bindings &descriptorSets);
+
+	// Queries of the process-wide routine cache.
+	static CacheStats getCacheStats();
+
+	// See PixelProcessor::optimizedRoutine().
+	static RoutineType optimizedRoutine(const State &state, vk::PipelineLayout const *pipelineLayout,
+	                                    SpirvShader const *vertexShader);
+
 protected:
-	const State update(const sw::Context *context);
 	RoutineType routine(const State &state, vk::PipelineLayout const *pipelineLayout,
 	                    SpirvShader const *vertexShader, const vk::DescriptorSet::Bindings &descriptorSets);
 
-	void setRoutineCacheSize(int cacheSize);
 
 private:
-	using RoutineCacheType = RoutineCacheT<State, VertexRoutineFunction::CFunctionType>;
-	RoutineCacheType *routineCache;
+	using RoutineCacheType = SharedRoutineCache<State, VertexRoutineFunction::CFunctionType>;
 };
 
 }  // namespace sw
@@ -18,11 +18,10 @@
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 
-#include "marl/defer.h"
+#include "marl/scheduler.h"
 #include "marl/trace.h"
-#include "marl/waitgroup.h"
 
-#include <queue>
+#include <algorithm>
 
 namespace {
 
@@ -192,8 +191,7 @@ void ComputeProgram::emit(SpirvRoutine *routine)
 	{
 		auto subgroupIndex = firstSubgroup + i;
 
-		// TODO: Replace SIMD::Int(0, 1, 2, 3) with SIMD-width equivalent
-		auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::Int(0, 1, 2, 3);
+		auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::LaneIndex();
 
 		// Disable lanes where (invocationIDs >= invocationsPerWorkgroup)
 		auto activeLaneMask = CmpLT(localInvocationIndex, SIMD::Int(invocationsPerWorkgroup));
@@ -209,7 +207,8 @@ void ComputeProgram::run(
     vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
     PushConstantStorage const &pushConstants,
     uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
-    uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+    uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+    marl::Ticket::Queue *tickets)
 {
 	auto &modes = shader->getModes();
 
@@ -217,7 +216,17 @@ void ComputeProgram::run(
 	auto invocationsPerWorkgroup = modes.WorkgroupSizeX * modes.WorkgroupSizeY * modes.WorkgroupSizeZ;
 	auto subgroupsPerWorkgroup = (invocationsPerWorkgroup + invocationsPerSubgroup - 1) / invocationsPerSubgroup;
 
-	Data data;
+	auto groupCount = groupCountX * groupCountY * groupCountZ;
+	if(groupCount == 0)
+	{
+		return;
+	}
+
+	// The dispatch state has to outlive this call, so it is borrowed from a
+	// pool, which also bounds the number of dispatches in flight.
+	auto dispatch = dispatchPool.borrow();
+
+	Data &data = dispatch->data;
 	data.descriptorSets = descriptorSets;
 	data.descriptorDynamicOffsets = descriptorDynamicOffsets;
 	data.numWorkgroups[X] = groupCountX;
@@ -234,69 +243,113 @@ void ComputeProgram::run(
 	data.pushConstants = pushConstants;
 	data.constants = &sw::constants;
 
-	marl::WaitGroup wg;
-	const uint32_t batchCount = 16;
+	dispatch->baseGroup[X] = baseGroupX;
+	dispatch->baseGroup[Y] = baseGroupY;
+	dispatch->baseGroup[Z] = baseGroupZ;
+	dispatch->groupCount[X] = groupCountX;
+	dispatch->groupCount[Y] = groupCountY;
+	dispatch->groupCount[Z] = groupCountZ;
+	dispatch->batchCount = getBatchCount(groupCount);
+
+	auto ticket = tickets->take();
+	auto finally = marl::make_shared_finally([ticket] {
+		ticket.done();
+	});
 
-	auto groupCount = groupCountX * groupCountY * groupCountZ;
+	for(uint32_t batchID = 0; batchID < dispatch->batchCount; batchID++)
+	{
+		auto batch = batchPool.borrow();
 
-	for(uint32_t batchID = 0; batchID < batchCount && batchID < groupCount; batchID++)
+		marl::schedule([this, dispatch, batch, batchID, finally] {
+			runBatch(dispatch.get(), batch.get(), batchID);
+		});
+	}
+}
+
+uint32_t ComputeProgram::getBatchCount(uint32_t groupCount) const
+{
+	auto &modes = shader->getModes();
+	uint32_t invocationsPerWorkgroup = modes.WorkgroupSizeX * modes.WorkgroupSizeY * modes.WorkgroupSizeZ;
+
+	uint32_t workerCount = 1;
+	if(auto scheduler = marl::Scheduler::get())
 	{
-		wg.add(1);
-		marl::schedule([=, &data] {
-			defer(wg.done());
-			std::vector<uint8_t> workgroupMemory(shader->workgroupMemory.size());
+		workerCount = std::max(scheduler->getWorkerThreadCount(), 1);
+	}
+
+	uint64_t invocationCount = uint64_t(groupCount) * invocationsPerWorkgroup;
+	uint64_t batchCount = std::min<uint64_t>(workerCount * BatchesPerWorker,
+	                                         (invocationCount + MinInvocationsPerBatch - 1) / MinInvocationsPerBatch);
+
+	return static_cast<uint32_t>(std::max<uint64_t>(std::min<uint64_t>({ batchCount, groupCount, MaxBatchCount }), 1));
+}
+
+void ComputeProgram::runBatch(Dispatch *dispatch, Batch *batch, uint32_t batchID)
+{
+	auto &modes = shader->getModes();
+	Data *data = &dispatch->data;
+
+	uint32_t groupCountX = dispatch->groupCount[X];
+	uint32_t groupCountY = dispatch->groupCount[Y];
+	uint32_t groupCount = groupCountX * groupCountY * dispatch->groupCount[Z];
+	uint32_t batchCount = dispatch->batchCount;
+	int subgroupsPerWorkgroup = data->subgroupsPerWorkgroup;
+
+	// Workgroup memory contents are undefined at the start of a workgroup,
+	// so the batch's storage is reused as is.
+	batch->workgroupMemory.resize(shader->workgroupMemory.size());
+	void *workgroupMemory = batch->workgroupMemory.data();
 
-			for(uint32_t groupIndex = batchID; groupIndex < groupCount; groupIndex += batchCount)
+	auto &coroutines = batch->coroutines;
+
+	for(uint32_t groupIndex = batchID; groupIndex < groupCount; groupIndex += batchCount)
+	{
+		auto modulo = groupIndex;
+		auto groupOffsetZ = modulo / (groupCountX * groupCountY);
+		modulo -= groupOffsetZ * (groupCountX * groupCountY);
+		auto groupOffsetY = modulo / groupCountX;
+		modulo -= groupOffsetY * groupCountX;
+		auto groupOffsetX = modulo;
+
+		auto groupZ = dispatch->baseGroup[Z] + groupOffsetZ;
+		auto groupY = dispatch->baseGroup[Y] + groupOffsetY;
+		auto groupX = dispatch->baseGroup[X] + groupOffsetX;
+		MARL_SCOPED_EVENT("groupX: %d, groupY: %d, groupZ: %d", groupX, groupY, groupZ);
+
+		if(modes.ContainsControlBarriers)
+		{
+			// Make a function call per subgroup so each subgroup
+			// can yield, bringing all subgroups to the barrier
+			// together.
+			for(int subgroupIndex = 0; subgroupIndex < subgroupsPerWorkgroup; subgroupIndex++)
 			{
-				auto modulo = groupIndex;
-				auto groupOffsetZ = modulo / (groupCountX * groupCountY);
-				modulo -= groupOffsetZ * (groupCountX * groupCountY);
-				auto groupOffsetY = modulo / groupCountX;
-				modulo -= groupOffsetY * groupCountX;
-				auto groupOffsetX = modulo;
-
-				auto groupZ = baseGroupZ + groupOffsetZ;
-				auto groupY = baseGroupY + groupOffsetY;
-				auto groupX = baseGroupX + groupOffsetX;
-				MARL_SCOPED_EVENT("groupX: %d, groupY: %d, groupZ: %d", groupX, groupY, groupZ);
-
-				using Coroutine = std::unique_ptr<rr::Stream<SpirvShader::YieldResult>>;
-				std::queue<Coroutine> coroutines;
-
-				if(modes.ContainsControlBarriers)
-				{
-					// Make a function call per subgroup so each subgroup
-					// can yield, bringing all subgroups to the barrier
-					// together.
-					for(int subgroupIndex = 0; subgroupIndex < subgroupsPerWorkgroup; subgroupIndex++)
-					{
-						auto coroutine = (*this)(&data, groupX, groupY, groupZ, workgroupMemory.data(), subgroupIndex, 1);
-						coroutines.push(std::move(coroutine));
-					}
-				}
-				else
-				{
-					auto coroutine = (*this)(&data, groupX, groupY, groupZ, workgroupMemory.data(), 0, subgroupsPerWorkgroup);
-					coroutines.push(std::move(coroutine));
-				}
+				coroutines.push_back((*this)(data, groupX, groupY, groupZ, workgroupMemory, subgroupIndex, 1));
+			}
+		}
+		else
+		{
+			coroutines.push_back((*this)(data, groupX, groupY, groupZ, workgroupMemory, 0, subgroupsPerWorkgroup));
+		}
+
+		// Resume the coroutines in round-robin order, until they have all
+		// completed, compacting the list in place.
+		while(!coroutines.empty())
+		{
+			size_t pending = 0;
 
-				while(coroutines.size() > 0)
+			for(auto &coroutine : coroutines)
+			{
+				SpirvShader::YieldResult result;
+				if(coroutine->await(result))
 				{
-					auto coroutine = std::move(coroutines.front());
-					coroutines.pop();
-
-					SpirvShader::YieldResult result;
-					if(coroutine->await(result))
-					{
-						// TODO: Consider result (when the enum is more than 1 entry).
-						coroutines.push(std::move(coroutine));
-					}
+					// TODO: Consider result (when the enum is more than 1 entry).
+					coroutines[pending++] = std::move(coroutine);
 				}
 			}
-		});
-	}
 
-	wg.wait();
+			coroutines.resize(pending);
+		}
+	}
 }
 
 }  // namespace sw
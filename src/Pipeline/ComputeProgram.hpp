@@ -21,7 +21,12 @@
 #include "Reactor/Coroutine.hpp"
 #include "Vulkan/VkDescriptorSet.hpp"
 
+#include "marl/pool.h"
+#include "marl/ticket.h"
+
 #include <functional>
+#include <memory>
+#include <vector>
 
 namespace vk {
 class PipelineLayout;
@@ -52,13 +57,16 @@ public:
 	// generate builds the shader program.
 	void generate();
 
-	// run executes the compute shader routine for all workgroups.
+	// run schedules the compute shader routine for all workgroups, and returns
+	// without waiting for them. A ticket is taken from the given queue, and is
+	// marked done once all workgroups have completed.
 	void run(
 	    vk::DescriptorSet::Bindings const &descriptorSetBindings,
 	    vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
 	    PushConstantStorage const &pushConstants,
 	    uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
-	    uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+	    uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+	    marl::Ticket::Queue *tickets);
 
 protected:
 	void emit(SpirvRoutine *routine);
@@ -78,6 +86,42 @@ protected:
 		const Constants *constants;
 	};
 
+	// Workgroups of a dispatch are distributed over batches, each executed by
+	// a single task. There are up to BatchesPerWorker batches per worker
+	// thread, for load balancing, but each batch has at least
+	// MinInvocationsPerBatch invocations, to amortize the scheduling cost.
+	static constexpr uint32_t MaxBatchCount = 64;
+	static constexpr uint32_t BatchesPerWorker = 4;
+	static constexpr uint32_t MinInvocationsPerBatch = 256;
+	static constexpr uint32_t MaxDispatchCount = 16;
+
+	using CoroutineHandle = std::unique_ptr<rr::Stream<SpirvShader::YieldResult>>;
+
+	struct Dispatch
+	{
+		using Pool = marl::BoundedPool<Dispatch, MaxDispatchCount, marl::PoolPolicy::Preserve>;
+
+		Data data;
+		uint32_t baseGroup[3];
+		uint32_t groupCount[3];
+		uint32_t batchCount;
+	};
+
+	// Working memory of a batch, preserved across dispatches.
+	struct Batch
+	{
+		using Pool = marl::BoundedPool<Batch, MaxBatchCount, marl::PoolPolicy::Preserve>;
+
+		std::vector<uint8_t> workgroupMemory;
+		std::vector<CoroutineHandle> coroutines;
+	};
+
+	uint32_t getBatchCount(uint32_t groupCount) const;
+	void runBatch(Dispatch *dispatch, Batch *batch, uint32_t batchID);
+
+	Dispatch::Pool dispatchPool;
+	Batch::Pool batchPool;
+
 	SpirvShader const *const shader;
 	vk::PipelineLayout const *const pipelineLayout;
 	const vk::DescriptorSet::Bindings &descriptorSets;
@@ -31,8 +31,8 @@ Int4 PixelProgram::maskAny(Int cMask[4]) const
 	}
 
 	// Convert to 4 booleans
-	Int4 laneBits = Int4(1, 2, 4, 8);
-	Int4 laneShiftsToMSB = Int4(31, 30, 29, 28);
+	Int4 laneBits = SIMD::LaneBit();
+	Int4 laneShiftsToMSB = Int4(31) - SIMD::LaneIndex();
 	Int4 mask(maskUnion);
 	mask = ((mask & laneBits) << laneShiftsToMSB) >> Int4(31);
 	return mask;
@@ -49,8 +49,8 @@ Int4 PixelProgram::maskAny(Int cMask[4], Int sMask[4], Int zMask[4]) const
 	}
 
 	// Convert to 4 booleans
-	Int4 laneBits = Int4(1, 2, 4, 8);
-	Int4 laneShiftsToMSB = Int4(31, 30, 29, 28);
+	Int4 laneBits = SIMD::LaneBit();
+	Int4 laneShiftsToMSB = Int4(31) - SIMD::LaneIndex();
 	Int4 mask(maskUnion);
 	mask = ((mask & laneBits) << laneShiftsToMSB) >> Int4(31);
 	return mask;
@@ -114,6 +114,7 @@ void PixelProgram::applyShader(Int cMask[4], Int sMask[4], Int zMask[4])
 	routine.descriptorDynamicOffsets = data + OFFSET(DrawData, descriptorDynamicOffsets);
 	routine.pushConstants = data + OFFSET(DrawData, pushConstants);
 	routine.constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, constants));
+	routine.samplingProfiles = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, samplingProfiles));
 
 	auto it = spirvShader->inputBuiltins.find(spv::BuiltInFrontFacing);
 	if(it != spirvShader->inputBuiltins.end())
@@ -126,8 +127,7 @@ void PixelProgram::applyShader(Int cMask[4], Int sMask[4], Int zMask[4])
 	it = spirvShader->inputBuiltins.find(spv::BuiltInSampleMask);
 	if(it != spirvShader->inputBuiltins.end())
 	{
-		static_assert(SIMD::Width == 4, "Expects SIMD width to be 4");
-		Int4 laneBits = Int4(1, 2, 4, 8);
+		Int4 laneBits = SIMD::LaneBit();
 
 		Int4 inputSampleMask = Int4(1) & CmpNEQ(Int4(cMask[0]) & laneBits, Int4(0));
 		for(auto i = 1u; i < state.multiSampleCount; i++)
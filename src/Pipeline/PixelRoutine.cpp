@@ -35,6 +35,7 @@ PixelRoutine::PixelRoutine(
 {
 	if(spirvShader)
 	{
+		routine.specializeSampling = (state.samplingVersion != 0);
 		spirvShader->emitProlog(&routine);
 
 		// Clearing inputs to 0 is not demanded by the spec,
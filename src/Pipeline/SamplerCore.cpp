@@ -994,7 +994,8 @@ Vector4f SamplerCore::sampleFloat2D(Pointer<Byte> &texture, Float4 &u, Float4 &v
 		address(cubeArrayCoord, cubeArrayId, cubeArrayId, fw, mipmap, offset.w, filter, OFFSET(Mipmap, depth), state.addressingModeY, function);
 	}
 
-	Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
+	// Compressed and tiled textures are addressed by block, so their rows are applied in computeIndices().
+	Int4 pitchP = hasBlockAddressing() ? Int4(1) : *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
 	y0 *= pitchP;
 	if(state.addressingModeW != ADDRESSING_UNUSED)
 	{
@@ -1385,6 +1386,15 @@ void SamplerCore::computeIndices(UInt index[4], Short4 uuuu, Short4 vvvv, Short4
 		                   texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeV);
 	}
 
+	// Compressed and tiled textures are indexed by block, with the texel's position within the block in the low bits.
+	Short4 texel;
+	if(hasBlockAddressing())
+	{
+		texel = ((vvvv & Short4(3)) << 2) | (uuuu & Short4(3));
+		uuuu = As<Short4>(As<UShort4>(uuuu) >> 2);
+		vvvv = As<Short4>(As<UShort4>(vvvv) >> 2);
+	}
+
 	Short4 uuu2 = uuuu;
 	uuuu = As<Short4>(UnpackLow(uuuu, vvvv));
 	uuu2 = As<Short4>(UnpackHigh(uuu2, vvvv));
@@ -1457,11 +1467,31 @@ void SamplerCore::computeIndices(UInt index[4], Short4 uuuu, Short4 vvvv, Short4
 			index[i] += Extract(cubeLayerOffset, i);
 		}
 	}
+
+	if(hasBlockAddressing())
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			index[i] = (index[i] << 4) | UInt(Int(Extract(texel, i)));
+		}
+	}
 }
 
 void SamplerCore::computeIndices(UInt index[4], Int4 uuuu, Int4 vvvv, Int4 wwww, Int4 valid, const Pointer<Byte> &mipmap, const Int4 &cubeArrayId, const Int4 &sampleId, SamplerFunction function)
 {
-	UInt4 indices = uuuu + vvvv;
+	UInt4 indices;
+	Int4 texel;
+
+	if(hasBlockAddressing())
+	{
+		// Compressed and tiled textures are indexed by block, with the texel's position within the block in the low bits.
+		texel = ((vvvv & Int4(3)) << 2) | (uuuu & Int4(3));
+		indices = As<UInt4>(uuuu >> 2) + As<UInt4>(vvvv >> 2) * *Pointer<UInt4>(mipmap + OFFSET(Mipmap, pitchP), 16);
+	}
+	else
+	{
+		indices = uuuu + vvvv;
+	}
 
 	if(state.addressingModeW != ADDRESSING_UNUSED)
 	{
@@ -1473,6 +1503,11 @@ void SamplerCore::computeIndices(UInt index[4], Int4 uuuu, Int4 vvvv, Int4 wwww,
 		// Texels out of range are still sampled before being replaced
 		// with the border color, so sample them at linear index 0.
 		indices &= As<UInt4>(valid);
+
+		if(hasBlockAddressing())
+		{
+			texel &= valid;
+		}
 	}
 
 	if(function.sample)
@@ -1486,6 +1521,11 @@ void SamplerCore::computeIndices(UInt index[4], Int4 uuuu, Int4 vvvv, Int4 wwww,
 		indices += As<UInt4>(cubeArrayId) * *Pointer<UInt4>(mipmap + OFFSET(Mipmap, sliceP)) * UInt4(6);
 	}
 
+	if(hasBlockAddressing())
+	{
+		indices = (indices << 4) | As<UInt4>(texel);
+	}
+
 	for(int i = 0; i < 4; i++)
 	{
 		index[i] = Extract(As<Int4>(indices), i);
@@ -1496,7 +1536,11 @@ Vector4s SamplerCore::sampleTexel(UInt index[4], Pointer<Byte> buffer)
 {
 	Vector4s c;
 
-	if(has16bitTextureFormat())
+	if(isCompressedFormat())
+	{
+		c = sampleBlockTexel(index, buffer);
+	}
+	else if(has16bitTextureFormat())
 	{
 		c.x = Insert(c.x, Pointer<Short>(buffer)[index[0]], 0);
 		c.x = Insert(c.x, Pointer<Short>(buffer)[index[1]], 1);
@@ -1754,6 +1798,184 @@ Vector4s SamplerCore::sampleTexel(UInt index[4], Pointer<Byte> buffer)
 	return c;
 }
 
+Vector4s SamplerCore::sampleBlockTexel(UInt index[4], Pointer<Byte> buffer)
+{
+	// The indices hold the block index in the upper bits, and the texel's position within the block in the lower 4 bits.
+	Pointer<Byte> block[4];
+	Int4 texel;
+	UInt blockBytes = state.compressedFormat.bytesPerBlock();
+
+	for(int i = 0; i < 4; i++)
+	{
+		block[i] = buffer + (index[i] >> 4) * blockBytes;
+		texel = Insert(texel, Int(index[i] & UInt(0xF)), i);
+	}
+
+	// The texels are produced like those of the decompressed format, with 8-bit components in the upper byte.
+	Vector4s c;
+
+	switch(state.compressedFormat)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			c = decodeBlockColor(block, 0, texel, false, false);
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			c = decodeBlockColor(block, 0, texel, true, false);
+			break;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+			c = decodeBlockColor(block, 8, texel, true, true);
+			c.w = decodeBlockAlpha(block, texel);
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			c = decodeBlockColor(block, 8, texel, true, true);
+			c.w = decodeBlockChannel(block, 0, texel, false);
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			c.x = decodeBlockChannel(block, 0, texel, state.compressedFormat == VK_FORMAT_BC4_SNORM_BLOCK);
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+			c.x = decodeBlockChannel(block, 0, texel, state.compressedFormat == VK_FORMAT_BC5_SNORM_BLOCK);
+			c.y = decodeBlockChannel(block, 8, texel, state.compressedFormat == VK_FORMAT_BC5_SNORM_BLOCK);
+			break;
+		default:
+			UNIMPLEMENTED("Format %d", VkFormat(state.compressedFormat));
+	}
+
+	return c;
+}
+
+// Decodes the 4 texels of BC1 color blocks, or the color part of BC2 and BC3 blocks.
+Vector4s SamplerCore::decodeBlockColor(Pointer<Byte> block[4], int offset, const Int4 &texel, bool hasAlphaChannel, bool hasSeparateAlpha)
+{
+	Int4 endpoints;
+	Int4 selectors;
+
+	for(int i = 0; i < 4; i++)
+	{
+		endpoints = Insert(endpoints, *Pointer<Int>(block[i] + offset), i);
+		selectors = Insert(selectors, *Pointer<Int>(block[i] + offset + 4), i);
+	}
+
+	Int4 c0 = endpoints & Int4(0xFFFF);
+	Int4 c1 = As<Int4>(As<UInt4>(endpoints) >> 16);
+	Int4 selector = (selectors >> (texel << 1)) & Int4(3);
+
+	// Four interpolated colors, or three and transparent black.
+	Int4 fourColors = Int4(-1);
+	if(!hasSeparateAlpha)
+	{
+		fourColors = CmpGT(c0, c1);
+	}
+
+	Int4 select0 = CmpEQ(selector, Int4(0));
+	Int4 select1 = CmpEQ(selector, Int4(1));
+	Int4 select2 = CmpEQ(selector, Int4(2));
+	Int4 select3 = CmpEQ(selector, Int4(3));
+
+	Vector4s c;
+
+	for(int component = 0; component < 3; component++)
+	{
+		// Expand the 5:6:5 bit red, green, and blue fields to 8 bits.
+		int shift = (component == 0) ? 11 : ((component == 1) ? 5 : 0);
+		int bits = (component == 1) ? 6 : 5;
+		Int4 e0 = (c0 >> shift) & Int4((1 << bits) - 1);
+		Int4 e1 = (c1 >> shift) & Int4((1 << bits) - 1);
+		e0 = (e0 << (8 - bits)) | (e0 >> (2 * bits - 8));
+		e1 = (e1 << (8 - bits)) | (e1 >> (2 * bits - 8));
+
+		// Division by 3 of values below 2^16, as (x * 0xAAAB) >> 17.
+		Int4 e2 = (((((e0 << 1) + e1) * Int4(0xAAAB)) >> 17) & fourColors) | (((e0 + e1) >> 1) & ~fourColors);
+		Int4 e3 = ((((e1 << 1) + e0) * Int4(0xAAAB)) >> 17) & fourColors;
+
+		Int4 e = (e0 & select0) | (e1 & select1) | (e2 & select2) | (e3 & select3);
+		c[component] = Short4(e << 8);
+	}
+
+	Int4 alpha = Int4(0xFF);
+	if(hasAlphaChannel && !hasSeparateAlpha)
+	{
+		alpha &= ~(select3 & ~fourColors);
+	}
+	c.w = Short4(alpha << 8);
+
+	return c;
+}
+
+// Decodes the 4-bit alpha of BC2 blocks.
+Short4 SamplerCore::decodeBlockAlpha(Pointer<Byte> block[4], const Int4 &texel)
+{
+	Int4 alphas;
+
+	for(int i = 0; i < 4; i++)
+	{
+		Int t = Extract(texel, i);
+		alphas = Insert(alphas, *Pointer<Int>(block[i] + ((t >> 3) << 2)), i);
+	}
+
+	Int4 alpha = (alphas >> ((texel & Int4(7)) << 2)) & Int4(0xF);
+
+	return Short4((alpha << 12) | (alpha << 8));
+}
+
+// Decodes the single channel blocks of BC4 and BC5, also used for the alpha of BC3.
+Short4 SamplerCore::decodeBlockChannel(Pointer<Byte> block[4], int offset, const Int4 &texel, bool isSigned)
+{
+	// 3-bit selectors follow the two 8-bit endpoints. Read them 16 bits at a time,
+	// without reading past the end of the 8 byte block.
+	Int4 bit = texel * Int4(3) + Int4(16);
+	Int4 byte = Min(bit >> 3, Int4(6));
+
+	Int4 e0, e1;
+	Int4 selectors;
+
+	for(int i = 0; i < 4; i++)
+	{
+		Pointer<Byte> data = block[i] + offset;
+
+		if(isSigned)
+		{
+			e0 = Insert(e0, Int(*Pointer<SByte>(data + 0)), i);
+			e1 = Insert(e1, Int(*Pointer<SByte>(data + 1)), i);
+		}
+		else
+		{
+			e0 = Insert(e0, Int(*Pointer<Byte>(data + 0)), i);
+			e1 = Insert(e1, Int(*Pointer<Byte>(data + 1)), i);
+		}
+
+		selectors = Insert(selectors, Int(*Pointer<UShort>(data + Extract(byte, i))), i);
+	}
+
+	Int4 selector = (selectors >> (bit - (byte << 3))) & Int4(7);
+
+	// Eight values interpolated between the endpoints, or six and the channel's minimum and maximum.
+	Int4 eightValues = CmpGT(e0, e1);
+	Int4 w0 = Int4(8) - selector;
+	Int4 w1 = selector - Int4(1);
+	Float4 eight = Float4(w0 * e0 + w1 * e1) / Float4(7.0f);
+	Float4 six = Float4((w0 - Int4(2)) * e0 + w1 * e1) / Float4(5.0f);
+	Int4 e = Int4(As<Float4>((As<Int4>(eight) & eightValues) | (As<Int4>(six) & ~eightValues)));  // Truncated like integer division
+
+	Int4 select0 = CmpEQ(selector, Int4(0));
+	Int4 select1 = CmpEQ(selector, Int4(1));
+	Int4 select6 = CmpEQ(selector, Int4(6)) & ~eightValues;
+	Int4 select7 = CmpEQ(selector, Int4(7)) & ~eightValues;
+	Int4 minimum = Int4(isSigned ? -128 : 0);
+	Int4 maximum = Int4(isSigned ? 127 : 255);
+
+	e = (e & ~(select0 | select1 | select6 | select7)) |
+	    (e0 & select0) | (e1 & select1) | (minimum & select6) | (maximum & select7);
+
+	return Short4(e << 8);
+}
+
 Vector4s SamplerCore::sampleTexel(Short4 &uuuu, Short4 &vvvv, Short4 &wwww, Vector4f &offset, Pointer<Byte> &mipmap, const Short4 &cubeArrayId, const Int4 &sampleId, Pointer<Byte> buffer, SamplerFunction function)
 {
 	Vector4s c;
@@ -2556,6 +2778,17 @@ bool SamplerCore::isYcbcrFormat() const
 	return state.textureFormat.isYcbcrFormat();
 }
 
+bool SamplerCore::isCompressedFormat() const
+{
+	return state.compressedFormat != VK_FORMAT_UNDEFINED;
+}
+
+bool SamplerCore::hasBlockAddressing() const
+{
+	// Tiled textures hold blocks of 4x4 uncompressed texels.
+	return isCompressedFormat() || state.tiledTexture;
+}
+
 bool SamplerCore::isRGBComponent(int component) const
 {
 	return state.textureFormat.isRGBComponent(component);
@@ -87,6 +87,10 @@ private:
 	void computeIndices(UInt index[4], Int4 uuuu, Int4 vvvv, Int4 wwww, Int4 valid, const Pointer<Byte> &mipmap, const Int4 &cubeArrayId, const Int4 &sampleId, SamplerFunction function);
 	Vector4s sampleTexel(Short4 &u, Short4 &v, Short4 &s, Vector4f &offset, Pointer<Byte> &mipmap, const Short4 &cubeArrayId, const Int4 &sampleId, Pointer<Byte> buffer, SamplerFunction function);
 	Vector4s sampleTexel(UInt index[4], Pointer<Byte> buffer);
+	Vector4s sampleBlockTexel(UInt index[4], Pointer<Byte> buffer);
+	Vector4s decodeBlockColor(Pointer<Byte> block[4], int offset, const Int4 &texel, bool hasAlphaChannel, bool hasSeparateAlpha);
+	Short4 decodeBlockAlpha(Pointer<Byte> block[4], const Int4 &texel);
+	Short4 decodeBlockChannel(Pointer<Byte> block[4], int offset, const Int4 &texel, bool isSigned);
 	Vector4f sampleTexel(Int4 &u, Int4 &v, Int4 &s, Float4 &z, Pointer<Byte> &mipmap, const Int4 &cubeArrayId, const Int4 &sampleId, Pointer<Byte> buffer, SamplerFunction function);
 	Vector4f replaceBorderTexel(const Vector4f &c, Int4 valid);
 	void selectMipmap(const Pointer<Byte> &texture, Pointer<Byte> &mipmap, Pointer<Byte> &buffer, const Float &lod, bool secondLOD);
@@ -108,6 +112,8 @@ private:
 	bool has16bitTextureComponents() const;
 	bool has32bitIntegerTextureComponents() const;
 	bool isYcbcrFormat() const;
+	bool isCompressedFormat() const;
+	bool hasBlockAddressing() const;
 	bool isRGBComponent(int component) const;
 	bool borderModeActive() const;
 	bool isCube() const;
@@ -147,9 +147,11 @@ void SetupRoutine::generate()
 			Until(i >= n);
 		}
 
-		// Vertical range
+		// Vertical and horizontal range
 		Int yMin = Y[0];
 		Int yMax = Y[0];
+		Int xMin = X[0];
+		Int xMax = X[0];
 
 		Int i = 1;
 
@@ -157,6 +159,8 @@ void SetupRoutine::generate()
 		{
 			yMin = Min(Y[i], yMin);
 			yMax = Max(Y[i], yMax);
+			xMin = Min(X[i], xMin);
+			xMax = Max(X[i], xMax);
 
 			i++;
 		}
@@ -166,6 +170,11 @@ void SetupRoutine::generate()
 		constexpr int subPixM = vk::SUBPIXEL_PRECISION_MASK;
 		constexpr float subPixF = vk::SUBPIXEL_PRECISION_FACTOR;
 
+		// The horizontal range is only used for binning, so it is widened by a
+		// pixel to account for sample offsets instead of being exact.
+		xMin = Max(xMin >> subPixB, *Pointer<Int>(data + OFFSET(DrawData, scissorX0)));
+		xMax = Min(((xMax + subPixM) >> subPixB) + 1, *Pointer<Int>(data + OFFSET(DrawData, scissorX1)));
+
 		if(state.multiSampleCount > 1)
 		{
 			yMin = (yMin + Constants::yMinMultiSampleOffset) >> subPixB;
@@ -188,6 +197,10 @@ void SetupRoutine::generate()
 			Return(0);
 		}
 
+		// Range of rows crossed by the edges of any sample
+		Int yTop = yMax;
+		Int yBottom = yMin;
+
 		For(Int q = 0, q < state.multiSampleCount, q++)
 		{
 			Array<Int> Xq(16);
@@ -210,64 +223,38 @@ void SetupRoutine::generate()
 			}
 			Until(i >= n);
 
-			Pointer<Byte> leftEdge = Pointer<Byte>(primitive + OFFSET(Primitive, outline->left)) + q * sizeof(Primitive);
-			Pointer<Byte> rightEdge = Pointer<Byte>(primitive + OFFSET(Primitive, outline->right)) + q * sizeof(Primitive);
-
-			if(state.multiSampleCount > 1)
-			{
-				Int xMin = *Pointer<Int>(data + OFFSET(DrawData, scissorX0));
-				Int xMax = *Pointer<Int>(data + OFFSET(DrawData, scissorX1));
-				Short x = Short(Clamp((X[0] + subPixM) >> subPixB, xMin, xMax));
-
-				For(Int y = yMin - 1, y < yMax + 1, y++)
-				{
-					*Pointer<Short>(leftEdge + y * sizeof(Primitive::Span)) = x;
-					*Pointer<Short>(rightEdge + y * sizeof(Primitive::Span)) = x;
-				}
-			}
-
 			Xq[n] = Xq[0];
 			Yq[n] = Yq[0];
 
 			// Rasterize
 			{
+				Int edgeCount = 0;
 				Int i = 0;
 
 				Do
 				{
-					edge(primitive, data, Xq[i + 1 - d], Yq[i + 1 - d], Xq[i + d], Yq[i + d], q);
+					edge(primitive, data, Xq[i + 1 - d], Yq[i + 1 - d], Xq[i + d], Yq[i + d], q, edgeCount, yTop, yBottom);
 
 					i++;
 				}
 				Until(i >= n);
-			}
-
-			if(state.multiSampleCount == 1)
-			{
-				For(, yMin < yMax && *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span)) == *Pointer<Short>(rightEdge + yMin * sizeof(Primitive::Span)), yMin++)
-				{
-					// Increments yMin
-				}
-
-				For(, yMax > yMin && *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span)) == *Pointer<Short>(rightEdge + (yMax - 1) * sizeof(Primitive::Span)), yMax--)
-				{
-					// Decrements yMax
-				}
 
-				If(yMin == yMax)
-				{
-					Return(0);
-				}
-
-				*Pointer<Short>(leftEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-				*Pointer<Short>(rightEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-				*Pointer<Short>(leftEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
-				*Pointer<Short>(rightEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
+				*Pointer<Int>(primitive + q * sizeof(Primitive) + OFFSET(Primitive, edgeCount)) = edgeCount;
 			}
 		}
 
+		If(yTop >= yBottom)
+		{
+			Return(0);
+		}
+
+		yMin = yTop;
+		yMax = yBottom;
+
 		*Pointer<Int>(primitive + OFFSET(Primitive, yMin)) = yMin;
 		*Pointer<Int>(primitive + OFFSET(Primitive, yMax)) = yMax;
+		*Pointer<Int>(primitive + OFFSET(Primitive, xMin)) = xMin;
+		*Pointer<Int>(primitive + OFFSET(Primitive, xMax)) = xMax;
 
 		// Sort by minimum y
 		if(triangle)
@@ -519,7 +506,7 @@ void SetupRoutine::setupGradient(Pointer<Byte> &primitive, Pointer<Byte> &triang
 	}
 }
 
-void SetupRoutine::edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &q)
+void SetupRoutine::edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &q, Int &edgeCount, Int &yTop, Int &yBottom)
 {
 	If(Ya != Yb)
 	{
@@ -538,12 +525,7 @@ void SetupRoutine::edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int
 
 		If(y1 < y2)
 		{
-			Int xMin = *Pointer<Int>(data + OFFSET(DrawData, scissorX0));
-			Int xMax = *Pointer<Int>(data + OFFSET(DrawData, scissorX1));
-
-			Pointer<Byte> leftEdge = primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline->left);
-			Pointer<Byte> rightEdge = primitive + q * sizeof(Primitive) + OFFSET(Primitive, outline->right);
-			Pointer<Byte> edge = IfThenElse(swap, rightEdge, leftEdge);
+			Pointer<Byte> edge = primitive + q * sizeof(Primitive) + OFFSET(Primitive, edge) + edgeCount * sizeof(Primitive::Edge);
 
 			// Deltas
 			Int DX12 = X2 - X1;
@@ -566,23 +548,20 @@ void SetupRoutine::edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int
 			R += floor & FDY12;
 
 			Int D = FDY12;  // Error-overflow
-			Int y = y1;
-
-			Do
-			{
-				*Pointer<Short>(edge + y * sizeof(Primitive::Span)) = Short(Clamp(x, xMin, xMax));
 
-				x += Q;
-				d += R;
-
-				Int overflow = -d >> 31;
-
-				d -= D & overflow;
-				x -= overflow;
-
-				y++;
-			}
-			Until(y >= y2);
+			// The rasterizer steps through the rows itself
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, yMin)) = y1;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, yMax)) = y2;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, x)) = x;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, d)) = d;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, Q)) = Q;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, R)) = R;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, D)) = D;
+			*Pointer<Int>(edge + OFFSET(Primitive::Edge, right)) = IfThenElse(swap, Int(1), Int(0));
+
+			edgeCount++;
+			yTop = Min(yTop, y1);
+			yBottom = Max(yBottom, y2);
 		}
 	}
 }
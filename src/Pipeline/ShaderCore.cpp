@@ -879,6 +879,18 @@ std::array<rr::RValue<sw::SIMD::Float>, 16> MatrixInverse(
 
 namespace SIMD {
 
+Int LaneIndex()
+{
+	static_assert(Width == 4, "Expects SIMD::Width to be 4");
+	return Int(0, 1, 2, 3);
+}
+
+Int LaneBit()
+{
+	static_assert(Width == 4, "Expects SIMD::Width to be 4");
+	return Int(1, 2, 4, 8);
+}
+
 Pointer::Pointer(rr::Pointer<Byte> base, rr::Int limit)
     : base(base)
     , dynamicLimit(limit)
@@ -887,6 +899,7 @@ Pointer::Pointer(rr::Pointer<Byte> base, rr::Int limit)
     , staticOffsets{}
     , hasDynamicLimit(true)
     , hasDynamicOffsets(false)
+    , hasUniformOffsets(false)
 {}
 
 Pointer::Pointer(rr::Pointer<Byte> base, unsigned int limit)
@@ -897,6 +910,7 @@ Pointer::Pointer(rr::Pointer<Byte> base, unsigned int limit)
     , staticOffsets{}
     , hasDynamicLimit(false)
     , hasDynamicOffsets(false)
+    , hasUniformOffsets(false)
 {}
 
 Pointer::Pointer(rr::Pointer<Byte> base, rr::Int limit, SIMD::Int offset)
@@ -907,6 +921,7 @@ Pointer::Pointer(rr::Pointer<Byte> base, rr::Int limit, SIMD::Int offset)
     , staticOffsets{}
     , hasDynamicLimit(true)
     , hasDynamicOffsets(true)
+    , hasUniformOffsets(false)
 {}
 
 Pointer::Pointer(rr::Pointer<Byte> base, unsigned int limit, SIMD::Int offset)
@@ -917,12 +932,14 @@ Pointer::Pointer(rr::Pointer<Byte> base, unsigned int limit, SIMD::Int offset)
     , staticOffsets{}
     , hasDynamicLimit(false)
     , hasDynamicOffsets(true)
+    , hasUniformOffsets(false)
 {}
 
 Pointer &Pointer::operator+=(Int i)
 {
 	dynamicOffsets += i;
 	hasDynamicOffsets = true;
+	hasUniformOffsets = false;
 	return *this;
 }
 
@@ -931,6 +948,7 @@ Pointer &Pointer::operator*=(Int i)
 	dynamicOffsets = offsets() * i;
 	staticOffsets = {};
 	hasDynamicOffsets = true;
+	hasUniformOffsets = false;
 	return *this;
 }
 
@@ -1077,6 +1095,10 @@ bool Pointer::hasStaticSequentialOffsets(unsigned int step) const
 // Returns true if all offsets are equal (N, N, N, N)
 rr::Bool Pointer::hasEqualOffsets() const
 {
+	if(hasUniformOffsets)
+	{
+		return true;
+	}
 	if(hasDynamicOffsets)
 	{
 		auto o = offsets();
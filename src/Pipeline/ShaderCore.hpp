@@ -80,6 +80,12 @@ using Float = rr::Float4;
 using Int = rr::Int4;
 using UInt = rr::UInt4;
 
+// Index of each lane, from 0 to Width - 1.
+Int LaneIndex();
+
+// Bit representing each lane in lane masks, 1 << LaneIndex().
+Int LaneBit();
+
 struct Pointer
 {
 	Pointer(rr::Pointer<Byte> base, rr::Int limit);
@@ -144,6 +150,7 @@ struct Pointer
 
 	bool hasDynamicLimit;    // True if dynamicLimit is non-zero.
 	bool hasDynamicOffsets;  // True if any dynamicOffsets are non-zero.
+	bool hasUniformOffsets;  // True if the offsets are known to be equal across lanes.
 };
 
 template<typename T>
@@ -352,6 +359,19 @@ inline T SIMD::Pointer::Load(OutOfBoundsBehavior robustness, Int mask, bool atom
 			return out;
 		}
 
+		if(hasUniformOffsets)
+		{
+			// Offsets are only known at run time, but are equal.
+			// Load one, replicate.
+			T out = T(0);
+			If(AnyTrue(mask))
+			{
+				EL el = *rr::Pointer<EL>(&base[Extract(offs, 0)], alignment);
+				out = T(el);
+			}
+			return out;
+		}
+
 		bool zeroMaskedLanes = true;
 		switch(robustness)
 		{
@@ -19,6 +19,7 @@
 #include "Vulkan/VkRenderPass.hpp"
 
 #include "marl/defer.h"
+#include "marl/scheduler.h"
 
 #include <spirv/unified1/spirv.hpp>
 
@@ -623,20 +624,8 @@ SpirvShader::SpirvShader(
 			case spv::OpAtomicExchange:
 			case spv::OpAtomicCompareExchange:
 			case spv::OpPhi:
-			case spv::OpImageSampleImplicitLod:
-			case spv::OpImageSampleExplicitLod:
-			case spv::OpImageSampleDrefImplicitLod:
-			case spv::OpImageSampleDrefExplicitLod:
-			case spv::OpImageSampleProjImplicitLod:
-			case spv::OpImageSampleProjExplicitLod:
-			case spv::OpImageSampleProjDrefImplicitLod:
-			case spv::OpImageSampleProjDrefExplicitLod:
-			case spv::OpImageGather:
-			case spv::OpImageDrefGather:
-			case spv::OpImageFetch:
 			case spv::OpImageQuerySizeLod:
 			case spv::OpImageQuerySize:
-			case spv::OpImageQueryLod:
 			case spv::OpImageQueryLevels:
 			case spv::OpImageQuerySamples:
 			case spv::OpImageRead:
@@ -679,6 +668,26 @@ SpirvShader::SpirvShader(
 				DefineResult(insn);
 				break;
 
+			case spv::OpImageSampleImplicitLod:
+			case spv::OpImageSampleExplicitLod:
+			case spv::OpImageSampleDrefImplicitLod:
+			case spv::OpImageSampleDrefExplicitLod:
+			case spv::OpImageSampleProjImplicitLod:
+			case spv::OpImageSampleProjExplicitLod:
+			case spv::OpImageSampleProjDrefImplicitLod:
+			case spv::OpImageSampleProjDrefExplicitLod:
+			case spv::OpImageGather:
+			case spv::OpImageDrefGather:
+			case spv::OpImageFetch:
+			case spv::OpImageQueryLod:
+			{
+				// Instructions that call getImageSampler()
+				auto index = static_cast<uint32_t>(samplingProfileIndices.size());
+				samplingProfileIndices.emplace(Object::ID(insn.word(2)), index);
+				DefineResult(insn);
+				break;
+			}
+
 			case spv::OpExtInst:
 				switch(getExtension(insn.word(3)).name)
 				{
@@ -732,14 +741,50 @@ SpirvShader::SpirvShader(
 		it.second.AssignBlockFields();
 	}
 
+	AnalyzeUniformity();
+
+	samplingProfiles.reset(new SamplingProfile[samplingProfileIndices.size()]);
+	for(size_t i = 0; i < samplingProfileIndices.size(); i++)
+	{
+		samplingProfiles[i].stableVersion = &stableSamplingVersion;
+	}
+
 	dbgCreateFile();
 }
 
 SpirvShader::~SpirvShader()
 {
+	pendingBackgroundBuilds.wait();
 	dbgTerm();
 }
 
+bool SpirvShader::countDraw() const
+{
+	if(drawCount.load(std::memory_order_relaxed) >= vk::TIERED_COMPILATION_THRESHOLD)
+	{
+		return true;
+	}
+
+	return ++drawCount >= vk::TIERED_COMPILATION_THRESHOLD;
+}
+
+void SpirvShader::buildInBackground(uint64_t key, const std::function<void()> &function) const
+{
+	{
+		std::unique_lock<std::mutex> lock(backgroundBuildsMutex);
+		if(!backgroundBuilds.emplace(key).second)
+		{
+			return;
+		}
+	}
+
+	pendingBackgroundBuilds.add();
+	marl::schedule([=] {
+		function();
+		pendingBackgroundBuilds.done();
+	});
+}
+
 void SpirvShader::DeclareType(InsnIterator insn)
 {
 	Type::ID resultId = insn.word(1);
@@ -2443,12 +2488,17 @@ void SpirvRoutine::setImmutableInputBuiltins(SpirvShader const *shader)
 {
 	setInputBuiltin(shader, spv::BuiltInSubgroupLocalInvocationId, [&](const SpirvShader::BuiltinMapping &builtin, Array<SIMD::Float> &value) {
 		ASSERT(builtin.SizeInComponents == 1);
-		value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 1, 2, 3));
+		value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::LaneIndex());
 	});
 
+	// Masks of the lanes relative to each lane. Only the first of their four
+	// components is used, as a subgroup has at most 32 invocations.
+	static_assert(SIMD::Width <= 32, "Subgroup masks expect at most 32 lanes");
+	const int laneMask = (1 << SIMD::Width) - 1;
+
 	setInputBuiltin(shader, spv::BuiltInSubgroupEqMask, [&](const SpirvShader::BuiltinMapping &builtin, Array<SIMD::Float> &value) {
 		ASSERT(builtin.SizeInComponents == 4);
-		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(1, 2, 4, 8));
+		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::LaneBit());
 		value[builtin.FirstComponent + 1] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 2] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 3] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
@@ -2456,7 +2506,7 @@ void SpirvRoutine::setImmutableInputBuiltins(SpirvShader const *shader)
 
 	setInputBuiltin(shader, spv::BuiltInSubgroupGeMask, [&](const SpirvShader::BuiltinMapping &builtin, Array<SIMD::Float> &value) {
 		ASSERT(builtin.SizeInComponents == 4);
-		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(15, 14, 12, 8));
+		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(laneMask) ^ (SIMD::LaneBit() - SIMD::Int(1)));
 		value[builtin.FirstComponent + 1] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 2] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 3] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
@@ -2464,7 +2514,7 @@ void SpirvRoutine::setImmutableInputBuiltins(SpirvShader const *shader)
 
 	setInputBuiltin(shader, spv::BuiltInSubgroupGtMask, [&](const SpirvShader::BuiltinMapping &builtin, Array<SIMD::Float> &value) {
 		ASSERT(builtin.SizeInComponents == 4);
-		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(14, 12, 8, 0));
+		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(laneMask) ^ (SIMD::LaneBit() | (SIMD::LaneBit() - SIMD::Int(1))));
 		value[builtin.FirstComponent + 1] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 2] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 3] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
@@ -2472,7 +2522,7 @@ void SpirvRoutine::setImmutableInputBuiltins(SpirvShader const *shader)
 
 	setInputBuiltin(shader, spv::BuiltInSubgroupLeMask, [&](const SpirvShader::BuiltinMapping &builtin, Array<SIMD::Float> &value) {
 		ASSERT(builtin.SizeInComponents == 4);
-		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(1, 3, 7, 15));
+		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::LaneBit() | (SIMD::LaneBit() - SIMD::Int(1)));
 		value[builtin.FirstComponent + 1] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 2] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 3] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
@@ -2480,7 +2530,7 @@ void SpirvRoutine::setImmutableInputBuiltins(SpirvShader const *shader)
 
 	setInputBuiltin(shader, spv::BuiltInSubgroupLtMask, [&](const SpirvShader::BuiltinMapping &builtin, Array<SIMD::Float> &value) {
 		ASSERT(builtin.SizeInComponents == 4);
-		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::Int(0, 1, 3, 7));
+		value[builtin.FirstComponent + 0] = As<SIMD::Float>(SIMD::LaneBit() - SIMD::Int(1));
 		value[builtin.FirstComponent + 1] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 2] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
 		value[builtin.FirstComponent + 3] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
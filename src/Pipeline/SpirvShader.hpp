@@ -25,6 +25,8 @@
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkDescriptorSet.hpp"
 
+#include "marl/waitgroup.h"
+
 #include <spirv/unified1/spirv.hpp>
 
 #include <array>
@@ -34,6 +36,7 @@
 #include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
@@ -279,6 +282,10 @@ public:
 		};
 
 		Kind kind = Kind::Unknown;
+
+		// True if the value is known to be the same in all lanes. For
+		// pointers, all lanes reference the same data.
+		bool uniform = false;
 	};
 
 	// Block is an interval of SPIR-V instructions, starting with the
@@ -500,6 +507,38 @@ public:
 
 	~SpirvShader();
 
+	// Descriptor seen by an image sampling instruction on its last calls to
+	// getImageSampler(), and the sampler state it resolves to. Once the same
+	// one has been seen SAMPLING_SPECIALIZATION_THRESHOLD times in a row,
+	// routines built with SpirvRoutine::specializeSampling inline the sampling
+	// code for it, behind a check that the descriptor is still the same.
+	struct SamplingProfile
+	{
+		std::atomic<uint64_t> descriptorIds = { 0 };  // Image view ID << 32 | sampler ID
+		std::atomic<uint32_t> count = { 0 };
+		std::mutex mutex;
+		Sampler samplerState;  // Guarded by mutex
+		std::atomic<uint32_t> *stableVersion = nullptr;  // SpirvShader::stableSamplingVersion
+	};
+
+	// Profiles of the image sampling instructions, passed to the routines at
+	// draw time, see SpirvRoutine::samplingProfiles.
+	SamplingProfile *getSamplingProfiles() const { return samplingProfiles.get(); }
+
+	// Changes each time the descriptor seen by one of the image sampling
+	// instructions becomes stable, up to MAX_SAMPLING_SPECIALIZATIONS times.
+	// Zero if none has been yet.
+	uint32_t getStableSamplingVersion() const { return stableSamplingVersion; }
+
+	// Counts a draw using this shader. Returns true once it has been used for
+	// TIERED_COMPILATION_THRESHOLD draws, from which point the draw routines
+	// should be rebuilt at the default optimization level.
+	bool countDraw() const;
+
+	// Calls function on a worker thread, unless it was already called for
+	// the same key. The shader is not destroyed before it has completed.
+	void buildInBackground(uint64_t key, const std::function<void()> &function) const;
+
 	struct Modes
 	{
 		bool EarlyFragmentTests : 1;
@@ -756,6 +795,16 @@ private:
 	const bool robustBufferAccess = true;
 	spv::ExecutionModel executionModel = spv::ExecutionModelMax;  // Invalid prior to OpEntryPoint parsing.
 
+	// Index of the profile of each image sampling instruction.
+	std::unordered_map<Object::ID, uint32_t> samplingProfileIndices;
+	std::unique_ptr<SamplingProfile[]> samplingProfiles;
+	mutable std::atomic<uint32_t> stableSamplingVersion = { 0 };
+	mutable std::atomic<uint32_t> drawCount = { 0 };
+
+	mutable std::mutex backgroundBuildsMutex;
+	mutable std::unordered_set<uint64_t> backgroundBuilds;  // Guarded by backgroundBuildsMutex
+	mutable marl::WaitGroup pendingBackgroundBuilds;
+
 	// DeclareType creates a Type for the given OpTypeX instruction, storing
 	// it into the types map. It is called from the analysis pass (constructor).
 	void DeclareType(InsnIterator insn);
@@ -774,6 +823,18 @@ private:
 	// pass of the SPIR-V.
 	void DefineOpenCLDebugInfo100(const InsnIterator &insn);
 
+	// Sets Object::uniform for the results which are known to hold the same
+	// value in all lanes. Must be called after the blocks have been assigned.
+	void AnalyzeUniformity();
+
+	// Returns true if the instruction's result is uniform whenever its
+	// operands are uniform.
+	bool PreservesUniformity(InsnIterator insn) const;
+
+	// Returns the blocks of the function whose phis may merge values from
+	// lanes which took different paths through a non-uniform branch.
+	Block::Set GetDivergentMergeBlocks(Function const &function) const;
+
 	// Returns true if data in the given storage class is word-interleaved
 	// by each SIMD vector lane, otherwise data is stored linerally.
 	//
@@ -1169,8 +1230,12 @@ private:
 	// Returns the pair <significand, exponent>
 	std::pair<SIMD::Float, SIMD::Int> Frexp(RValue<SIMD::Float> val) const;
 
-	static ImageSampler *getImageSampler(uint32_t instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler);
+	static ImageSampler *getImageSampler(uint32_t instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler, SamplingProfile *profiles, uint32_t profileIndex);
+	static Sampler getSamplerState(ImageInstruction instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler);
+	static void updateSamplingProfile(SamplingProfile &profile, ImageInstruction instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler);
 	static std::shared_ptr<rr::Routine> emitSamplerRoutine(ImageInstruction instruction, const Sampler &samplerState);
+	static void emitSamplerFunction(ImageInstruction instruction, const Sampler &samplerState, Pointer<Byte> texture, Pointer<Byte> sampler,
+	                                Pointer<SIMD::Float> in, Pointer<SIMD::Float> out, Pointer<Byte> constants);
 
 	// TODO(b/129523279): Eliminate conversion and use vk::Sampler members directly.
 	static sw::FilterType convertFilterMode(const vk::Sampler *sampler);
@@ -1250,6 +1315,10 @@ public:
 
 	vk::PipelineLayout const *const pipelineLayout;
 
+	// Inline the sampling code for the descriptors the image sampling
+	// instructions have been seeing, see SpirvShader::SamplingProfile.
+	bool specializeSampling = false;
+
 	std::unordered_map<SpirvShader::Object::ID, Variable> variables;
 	std::unordered_map<SpirvShader::Object::ID, SamplerCache> samplerCache;
 	Variable inputs = Variable{ MAX_INTERFACE_COMPONENTS };
@@ -1258,6 +1327,7 @@ public:
 	Pointer<Byte> workgroupMemory;
 	Pointer<Pointer<Byte>> descriptorSets;
 	Pointer<Int> descriptorDynamicOffsets;
+	Pointer<Byte> samplingProfiles = nullptr;  // SpirvShader::SamplingProfile[], or null to not profile
 	Pointer<Byte> pushConstants;
 	Pointer<Byte> constants;
 	Int killMask = Int{ 0 };
@@ -323,6 +323,22 @@ SpirvShader::EmitResult SpirvShader::EmitBinaryOp(InsnIterator insn, EmitState *
 	auto lhs = GenericValue(this, state, insn.word(3));
 	auto rhs = GenericValue(this, state, insn.word(4));
 
+	// Integer division has no vector instruction and is emitted per lane, so
+	// uniform operands are divided once and the result replicated.
+	bool uniform = getObject(insn.word(2)).uniform;
+	auto sdiv = [&](RValue<SIMD::Int> a, RValue<SIMD::Int> b) -> SIMD::Int {
+		return uniform ? SIMD::Int(Extract(a, 0) / Extract(b, 0)) : SIMD::Int(a / b);
+	};
+	auto srem = [&](RValue<SIMD::Int> a, RValue<SIMD::Int> b) -> SIMD::Int {
+		return uniform ? SIMD::Int(Extract(a, 0) % Extract(b, 0)) : SIMD::Int(a % b);
+	};
+	auto udiv = [&](RValue<SIMD::UInt> a, RValue<SIMD::UInt> b) -> SIMD::UInt {
+		return uniform ? SIMD::UInt(Extract(a, 0) / Extract(b, 0)) : SIMD::UInt(a / b);
+	};
+	auto urem = [&](RValue<SIMD::UInt> a, RValue<SIMD::UInt> b) -> SIMD::UInt {
+		return uniform ? SIMD::UInt(Extract(a, 0) % Extract(b, 0)) : SIMD::UInt(a % b);
+	};
+
 	for(auto i = 0u; i < lhsType.sizeInComponents; i++)
 	{
 		switch(insn.opcode())
@@ -342,13 +358,13 @@ SpirvShader::EmitResult SpirvShader::EmitBinaryOp(InsnIterator insn, EmitState *
 				SIMD::Int b = rhs.Int(i);
 				b = b | CmpEQ(b, SIMD::Int(0));                                       // prevent divide-by-zero
 				a = a | (CmpEQ(a, SIMD::Int(0x80000000)) & CmpEQ(b, SIMD::Int(-1)));  // prevent integer overflow
-				dst.move(i, a / b);
+				dst.move(i, sdiv(a, b));
 				break;
 			}
 			case spv::OpUDiv:
 			{
 				auto zeroMask = As<SIMD::UInt>(CmpEQ(rhs.Int(i), SIMD::Int(0)));
-				dst.move(i, lhs.UInt(i) / (rhs.UInt(i) | zeroMask));
+				dst.move(i, udiv(lhs.UInt(i), rhs.UInt(i) | zeroMask));
 				break;
 			}
 			case spv::OpSRem:
@@ -357,7 +373,7 @@ SpirvShader::EmitResult SpirvShader::EmitBinaryOp(InsnIterator insn, EmitState *
 				SIMD::Int b = rhs.Int(i);
 				b = b | CmpEQ(b, SIMD::Int(0));                                       // prevent divide-by-zero
 				a = a | (CmpEQ(a, SIMD::Int(0x80000000)) & CmpEQ(b, SIMD::Int(-1)));  // prevent integer overflow
-				dst.move(i, a % b);
+				dst.move(i, srem(a, b));
 				break;
 			}
 			case spv::OpSMod:
@@ -366,7 +382,7 @@ SpirvShader::EmitResult SpirvShader::EmitBinaryOp(InsnIterator insn, EmitState *
 				SIMD::Int b = rhs.Int(i);
 				b = b | CmpEQ(b, SIMD::Int(0));                                       // prevent divide-by-zero
 				a = a | (CmpEQ(a, SIMD::Int(0x80000000)) & CmpEQ(b, SIMD::Int(-1)));  // prevent integer overflow
-				auto mod = a % b;
+				auto mod = srem(a, b);
 				// If a and b have opposite signs, the remainder operation takes
 				// the sign from a but OpSMod is supposed to take the sign of b.
 				// Adding b will ensure that the result has the correct sign and
@@ -381,7 +397,7 @@ SpirvShader::EmitResult SpirvShader::EmitBinaryOp(InsnIterator insn, EmitState *
 			case spv::OpUMod:
 			{
 				auto zeroMask = As<SIMD::UInt>(CmpEQ(rhs.Int(i), SIMD::Int(0)));
-				dst.move(i, lhs.UInt(i) % (rhs.UInt(i) | zeroMask));
+				dst.move(i, urem(lhs.UInt(i), rhs.UInt(i) | zeroMask));
 				break;
 			}
 			case spv::OpIEqual:
@@ -18,6 +18,7 @@
 
 #include "ShaderCore.hpp"
 
+#include <spirv/unified1/GLSL.std.450.h>
 #include <spirv/unified1/spirv.hpp>
 
 #include <queue>
@@ -660,6 +661,7 @@ void SpirvShader::StorePhi(Block::ID currentBlock, InsnIterator insn, EmitState
 	auto typeId = Type::ID(insn.word(1));
 	auto type = getType(typeId);
 	auto objectId = Object::ID(insn.word(2));
+	bool uniform = getObject(objectId).uniform;
 
 	auto storageIt = state->routine->phis.find(objectId);
 	ASSERT(storageIt != state->routine->phis.end());
@@ -675,7 +677,14 @@ void SpirvShader::StorePhi(Block::ID currentBlock, InsnIterator insn, EmitState
 			continue;
 		}
 
-		auto mask = GetActiveLaneMaskEdge(state, blockId, currentBlock);
+		SIMD::Int mask = GetActiveLaneMaskEdge(state, blockId, currentBlock);
+		if(uniform)
+		{
+			// All active lanes take the same edge. Also update the inactive
+			// lanes, so that any lane holds the uniform value.
+			mask = OrAll<SIMD::Int>(mask);
+		}
+
 		auto in = GenericValue(this, state, varId);
 
 		for(uint32_t i = 0; i < type.sizeInComponents; i++)
@@ -705,4 +714,302 @@ void SpirvShader::SetActiveLaneMask(RValue<SIMD::Int> mask, EmitState *state) co
 	dbgUpdateActiveLaneMask(mask, state);
 }
 
-}  // namespace sw
\ No newline at end of file
+void SpirvShader::AnalyzeUniformity()
+{
+	// Constants, and variables which are not stored per lane, are uniform.
+	for(auto &it : defs)
+	{
+		auto &object = it.second;
+		if(object.kind == Object::Kind::Constant ||
+		   (object.opcode() == spv::OpVariable && !IsStorageInterleavedByLane(getType(object.type).storageClass)))
+		{
+			object.uniform = true;
+		}
+	}
+
+	// Optimistically assume every candidate result is uniform, then demote
+	// the ones with non-uniform operands until nothing changes. Starting
+	// optimistic lets loop phis fed by their own back edge stay uniform.
+	struct Candidate
+	{
+		InsnIterator insn;
+		Function const *function;
+		Block::ID block;
+	};
+	std::vector<Candidate> candidates;
+
+	for(auto &fit : functions)
+	{
+		for(auto &bit : fit.second.blocks)
+		{
+			for(auto insn : bit.second)
+			{
+				if(PreservesUniformity(insn))
+				{
+					candidates.push_back({ insn, &fit.second, bit.first });
+					defs[Object::ID(insn.word(2))].uniform = true;
+				}
+			}
+		}
+	}
+
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+
+		std::unordered_map<Function const *, Block::Set> divergentMergeBlocks;
+		for(auto &it : functions)
+		{
+			divergentMergeBlocks.emplace(&it.second, GetDivergentMergeBlocks(it.second));
+		}
+
+		for(auto &candidate : candidates)
+		{
+			auto &object = defs[Object::ID(candidate.insn.word(2))];
+			if(!object.uniform)
+			{
+				continue;
+			}
+
+			// Literal operands are looked up as well, which may only
+			// demote a result, never promote it.
+			bool uniform = true;
+			for(uint32_t w = 3; w < candidate.insn.wordCount() && uniform; w++)
+			{
+				auto it = defs.find(Object::ID(candidate.insn.word(w)));
+				uniform = (it == defs.end()) || it->second.uniform;
+			}
+
+			if(uniform && candidate.insn.opcode() == spv::OpPhi)
+			{
+				uniform = (divergentMergeBlocks[candidate.function].count(candidate.block) == 0);
+			}
+
+			if(!uniform)
+			{
+				object.uniform = false;
+				changed = true;
+			}
+		}
+	}
+}
+
+bool SpirvShader::PreservesUniformity(InsnIterator insn) const
+{
+	switch(insn.opcode())
+	{
+		case spv::OpLoad:
+		{
+			auto storageClass = getType(getObject(insn.word(3)).type).storageClass;
+			bool isVolatile = insn.wordCount() > 4 && (insn.word(4) & spv::MemoryAccessVolatileMask) != 0;
+			return storageClass != spv::StorageClassUniformConstant && !isVolatile;
+		}
+
+		case spv::OpExtInst:
+			if(getExtension(insn.word(3)).name != Extension::GLSLstd450)
+			{
+				return false;
+			}
+			switch(insn.word(4))
+			{
+				case GLSLstd450InterpolateAtCentroid:
+				case GLSLstd450InterpolateAtSample:
+				case GLSLstd450InterpolateAtOffset:
+					return false;
+				default:
+					return true;
+			}
+
+		case spv::OpAccessChain:
+		case spv::OpInBoundsAccessChain:
+		case spv::OpPhi:
+		case spv::OpCopyObject:
+		case spv::OpCompositeConstruct:
+		case spv::OpCompositeInsert:
+		case spv::OpCompositeExtract:
+		case spv::OpVectorShuffle:
+		case spv::OpVectorTimesScalar:
+		case spv::OpMatrixTimesScalar:
+		case spv::OpMatrixTimesVector:
+		case spv::OpVectorTimesMatrix:
+		case spv::OpMatrixTimesMatrix:
+		case spv::OpOuterProduct:
+		case spv::OpTranspose:
+		case spv::OpVectorExtractDynamic:
+		case spv::OpVectorInsertDynamic:
+		case spv::OpNot:
+		case spv::OpBitFieldInsert:
+		case spv::OpBitFieldSExtract:
+		case spv::OpBitFieldUExtract:
+		case spv::OpBitReverse:
+		case spv::OpBitCount:
+		case spv::OpSNegate:
+		case spv::OpFNegate:
+		case spv::OpLogicalNot:
+		case spv::OpQuantizeToF16:
+		case spv::OpIAdd:
+		case spv::OpISub:
+		case spv::OpIMul:
+		case spv::OpSDiv:
+		case spv::OpUDiv:
+		case spv::OpFAdd:
+		case spv::OpFSub:
+		case spv::OpFMul:
+		case spv::OpFDiv:
+		case spv::OpFMod:
+		case spv::OpFRem:
+		case spv::OpFOrdEqual:
+		case spv::OpFUnordEqual:
+		case spv::OpFOrdNotEqual:
+		case spv::OpFUnordNotEqual:
+		case spv::OpFOrdLessThan:
+		case spv::OpFUnordLessThan:
+		case spv::OpFOrdGreaterThan:
+		case spv::OpFUnordGreaterThan:
+		case spv::OpFOrdLessThanEqual:
+		case spv::OpFUnordLessThanEqual:
+		case spv::OpFOrdGreaterThanEqual:
+		case spv::OpFUnordGreaterThanEqual:
+		case spv::OpSMod:
+		case spv::OpSRem:
+		case spv::OpUMod:
+		case spv::OpIEqual:
+		case spv::OpINotEqual:
+		case spv::OpUGreaterThan:
+		case spv::OpSGreaterThan:
+		case spv::OpUGreaterThanEqual:
+		case spv::OpSGreaterThanEqual:
+		case spv::OpULessThan:
+		case spv::OpSLessThan:
+		case spv::OpULessThanEqual:
+		case spv::OpSLessThanEqual:
+		case spv::OpShiftRightLogical:
+		case spv::OpShiftRightArithmetic:
+		case spv::OpShiftLeftLogical:
+		case spv::OpBitwiseOr:
+		case spv::OpBitwiseXor:
+		case spv::OpBitwiseAnd:
+		case spv::OpLogicalOr:
+		case spv::OpLogicalAnd:
+		case spv::OpLogicalEqual:
+		case spv::OpLogicalNotEqual:
+		case spv::OpUMulExtended:
+		case spv::OpSMulExtended:
+		case spv::OpIAddCarry:
+		case spv::OpISubBorrow:
+		case spv::OpDot:
+		case spv::OpConvertFToU:
+		case spv::OpConvertFToS:
+		case spv::OpConvertSToF:
+		case spv::OpConvertUToF:
+		case spv::OpBitcast:
+		case spv::OpSelect:
+		case spv::OpIsInf:
+		case spv::OpIsNan:
+		case spv::OpAny:
+		case spv::OpAll:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+SpirvShader::Block::Set SpirvShader::GetDivergentMergeBlocks(Function const &function) const
+{
+	// Returns the blocks reachable from 'from' without passing through
+	// 'notPassingThrough'.
+	auto reachable = [&](Block::ID from, Block::ID notPassingThrough) {
+		Block::Set seen;
+		std::queue<Block::ID> pending;
+		pending.emplace(from);
+		while(pending.size() > 0)
+		{
+			auto id = pending.front();
+			pending.pop();
+			for(auto out : function.getBlock(id).outs)
+			{
+				if(out != notPassingThrough && seen.emplace(out).second)
+				{
+					pending.emplace(out);
+				}
+			}
+		}
+		return seen;
+	};
+
+	Block::Set divergent;
+
+	// Lanes which diverge at a non-uniform branch reconverge at its merge
+	// block. Loop headers are included, as they branch to their merge
+	// block.
+	std::unordered_map<Block::ID, Block::Set> divergentBranches;
+	for(auto &it : function.blocks)
+	{
+		auto &block = it.second;
+		switch(block.kind)
+		{
+			case Block::StructuredBranchConditional:
+			case Block::UnstructuredBranchConditional:
+			case Block::StructuredSwitch:
+			case Block::UnstructuredSwitch:
+				break;
+			case Block::Loop:
+				if(block.branchInstruction.opcode() != spv::OpBranchConditional) { continue; }
+				break;
+			default:
+				continue;
+		}
+
+		if(getObject(block.branchInstruction.word(1)).uniform)
+		{
+			continue;
+		}
+
+		auto blocks = reachable(it.first, block.mergeBlock);
+		divergent.insert(blocks.begin(), blocks.end());
+		divergent.emplace(block.mergeBlock);
+		divergentBranches.emplace(it.first, std::move(blocks));
+	}
+
+	// Lanes which leave a loop on different iterations stop updating its
+	// phis at different values, so a loop with a non-uniform exit, return
+	// or kill has no uniform phis.
+	for(auto &it : function.blocks)
+	{
+		auto &loop = it.second;
+		if(loop.kind != Block::Loop)
+		{
+			continue;
+		}
+
+		auto loopBlocks = reachable(it.first, loop.mergeBlock);
+		loopBlocks.emplace(it.first);
+
+		for(auto &branch : divergentBranches)
+		{
+			if(loopBlocks.count(branch.first) == 0)
+			{
+				continue;
+			}
+
+			bool exits = (branch.second.count(loop.mergeBlock) != 0) ||
+			             (function.getBlock(branch.first).mergeBlock == loop.mergeBlock);
+			for(auto id : branch.second)
+			{
+				exits = exits || function.getBlock(id).outs.empty();
+			}
+
+			if(exits)
+			{
+				divergent.insert(loopBlocks.begin(), loopBlocks.end());
+				break;
+			}
+		}
+	}
+
+	return divergent;
+}
+
+}  // namespace sw
@@ -141,7 +141,7 @@ SpirvShader::EmitResult SpirvShader::EmitGroupNonUniform(InsnIterator insn, Emit
 			auto valueId = Object::ID(insn.word(4));
 			auto id = SIMD::Int(GetConstScalarInt(insn.word(5)));
 			GenericValue value(this, state, valueId);
-			auto mask = CmpEQ(id, SIMD::Int(0, 1, 2, 3));
+			auto mask = CmpEQ(id, SIMD::LaneIndex());
 			for(auto i = 0u; i < type.sizeInComponents; i++)
 			{
 				dst.move(i, OrAll(value.Int(i) & mask));
@@ -184,7 +184,7 @@ SpirvShader::EmitResult SpirvShader::EmitGroupNonUniform(InsnIterator insn, Emit
 			ASSERT(type.sizeInComponents == 1);
 			ASSERT(getType(getObject(valueId).type).sizeInComponents == 4);
 			GenericValue value(this, state, valueId);
-			auto bit = (value.Int(0) >> SIMD::Int(0, 1, 2, 3)) & SIMD::Int(1);
+			auto bit = (value.Int(0) >> SIMD::LaneIndex()) & SIMD::Int(1);
 			dst.move(0, -bit);
 			break;
 		}
@@ -272,10 +272,10 @@ SpirvShader::EmitResult SpirvShader::EmitGroupNonUniform(InsnIterator insn, Emit
 		{
 			GenericValue value(this, state, insn.word(4));
 			GenericValue mask(this, state, insn.word(5));
-			auto x = CmpEQ(SIMD::Int(0), SIMD::Int(0, 1, 2, 3) ^ mask.Int(0));
-			auto y = CmpEQ(SIMD::Int(1), SIMD::Int(0, 1, 2, 3) ^ mask.Int(0));
-			auto z = CmpEQ(SIMD::Int(2), SIMD::Int(0, 1, 2, 3) ^ mask.Int(0));
-			auto w = CmpEQ(SIMD::Int(3), SIMD::Int(0, 1, 2, 3) ^ mask.Int(0));
+			auto x = CmpEQ(SIMD::Int(0), SIMD::LaneIndex() ^ mask.Int(0));
+			auto y = CmpEQ(SIMD::Int(1), SIMD::LaneIndex() ^ mask.Int(0));
+			auto z = CmpEQ(SIMD::Int(2), SIMD::LaneIndex() ^ mask.Int(0));
+			auto w = CmpEQ(SIMD::Int(3), SIMD::LaneIndex() ^ mask.Int(0));
 			for(auto i = 0u; i < type.sizeInComponents; i++)
 			{
 				SIMD::Int v = value.Int(i);
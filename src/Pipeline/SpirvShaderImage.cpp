@@ -128,7 +128,8 @@ SpirvShader::EmitResult SpirvShader::EmitImageSample(ImageInstruction instructio
 	// Above we assumed that if the SampledImage operand is not the result of an OpSampledImage,
 	// it must be a combined image sampler loaded straight from the descriptor set. For OpImageFetch
 	// it's just an Image operand, so there's no sampler descriptor data.
-	if(getType(sampledImage.type).opcode() != spv::OpTypeSampledImage)
+	bool hasSampler = (getType(sampledImage.type).opcode() == spv::OpTypeSampledImage);
+	if(!hasSampler)
 	{
 		sampler = Pointer<Byte>(nullptr);
 	}
@@ -290,20 +291,65 @@ SpirvShader::EmitResult SpirvShader::EmitImageSample(ImageInstruction instructio
 		in[i] = As<SIMD::Float>(sampleValue.Int(0));
 	}
 
+	auto profileIt = samplingProfileIndices.find(resultId);
+	ASSERT(profileIt != samplingProfileIndices.end());
+	uint32_t profileIndex = profileIt->second;
+
+	// Descriptor which this instruction has been seeing, if it has been stable.
+	uint64_t stableIds = 0;
+	Sampler stableState;
+	if(state->routine->specializeSampling)
+	{
+		SamplingProfile &profile = samplingProfiles[profileIndex];
+		std::unique_lock<std::mutex> lock(profile.mutex);
+		if(profile.count >= vk::SAMPLING_SPECIALIZATION_THRESHOLD)
+		{
+			stableIds = profile.descriptorIds;
+			stableState = profile.samplerState;
+		}
+	}
+
 	auto cacheIt = state->routine->samplerCache.find(resultId);
 	ASSERT(cacheIt != state->routine->samplerCache.end());
 	auto &cache = cacheIt->second;
-	auto cacheHit = cache.imageDescriptor == imageDescriptor && cache.sampler == sampler;
 
-	If(!cacheHit)
+	Array<SIMD::Float> out(4);
+
+	auto callImageSampler = [&] {
+		auto cacheHit = cache.imageDescriptor == imageDescriptor && cache.sampler == sampler;
+
+		If(!cacheHit)
+		{
+			cache.function = Call(getImageSampler, instruction.parameters, imageDescriptor, sampler, state->routine->samplingProfiles, profileIndex);
+			cache.imageDescriptor = imageDescriptor;
+			cache.sampler = sampler;
+		}
+
+		Call<ImageSampler>(cache.function, texture, sampler, &in[0], &out[0], state->routine->constants);
+	};
+
+	if(stableIds != 0)
 	{
-		cache.function = Call(getImageSampler, instruction.parameters, imageDescriptor, sampler);
-		cache.imageDescriptor = imageDescriptor;
-		cache.sampler = sampler;
-	}
+		UInt imageViewId = *Pointer<UInt>(imageDescriptor + OFFSET(vk::SampledImageDescriptor, imageViewId));
+		UInt samplerId = 0;
+		if(hasSampler)
+		{
+			samplerId = *Pointer<UInt>(sampler + OFFSET(vk::Sampler, id));
+		}
 
-	Array<SIMD::Float> out(4);
-	Call<ImageSampler>(cache.function, texture, sampler, &in[0], &out[0], state->routine->constants);
+		If(imageViewId == UInt(static_cast<uint32_t>(stableIds >> 32)) && samplerId == UInt(static_cast<uint32_t>(stableIds)))
+		{
+			emitSamplerFunction(instruction, stableState, texture, sampler, &in[0], &out[0], state->routine->constants);
+		}
+		Else
+		{
+			callImageSampler();
+		}
+	}
+	else
+	{
+		callImageSampler();
+	}
 
 	for(auto i = 0u; i < resultType.sizeInComponents; i++) { result.move(i, out[i]); }
 
@@ -57,6 +57,11 @@ SpirvShader::EmitResult SpirvShader::EmitLoad(InsnIterator insn, EmitState *stat
 	auto &dst = state->createIntermediate(resultId, resultTy.sizeInComponents);
 	auto robustness = state->getOutOfBoundsBehavior(pointerTy.storageClass);
 
+	if(pointer.uniform && !interleavedByLane)
+	{
+		ptr.hasUniformOffsets = true;
+	}
+
 	VisitMemoryObject(pointerId, [&](const MemoryElement &el) {
 		auto p = ptr + el.offset;
 		if(interleavedByLane) { p = InterleaveByLane(p); }  // TODO: Interleave once, then add offset?
@@ -486,6 +491,7 @@ sw::SIMD::Pointer SpirvShader::InterleaveByLane(sw::SIMD::Pointer p)
 	p.staticOffsets[1] += 1 * sizeof(float);
 	p.staticOffsets[2] += 2 * sizeof(float);
 	p.staticOffsets[3] += 3 * sizeof(float);
+	p.hasUniformOffsets = false;
 	return p;
 }
 
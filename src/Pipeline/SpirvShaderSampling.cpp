@@ -30,12 +30,17 @@
 
 namespace sw {
 
-SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler)
+SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler, SamplingProfile *profiles, uint32_t profileIndex)
 {
 	ImageInstruction instruction(inst);
 	const auto samplerId = sampler ? sampler->id : 0;
 	ASSERT(imageDescriptor->imageViewId != 0 && (samplerId != 0 || instruction.samplerMethod == Fetch));
 
+	if(profiles)
+	{
+		updateSamplingProfile(profiles[profileIndex], instruction, imageDescriptor, sampler);
+	}
+
 	vk::Device::SamplingRoutineCache::Key key = { inst, imageDescriptor->imageViewId, samplerId };
 
 	ASSERT(imageDescriptor->device);
@@ -54,12 +59,35 @@ SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::Sampl
 		return (ImageSampler *)(routine->getEntry());
 	}
 
+	Sampler samplerState = getSamplerState(instruction, imageDescriptor, sampler);
+
+	vk::Device::SamplingRoutineCache::StateKey stateKey;
+	stateKey.instruction = inst;
+	stateKey.samplerState = samplerState;
+
+	routine = cache->getOrCreate(lock, stateKey, [&] {
+		return emitSamplerRoutine(instruction, samplerState);
+	});
+
+	cache->add(key, routine);
+	return (ImageSampler *)(routine->getEntry());
+}
+
+Sampler SpirvShader::getSamplerState(ImageInstruction instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler)
+{
 	auto type = imageDescriptor->type;
 
-	Sampler samplerState = {};
+	Sampler samplerState;
 	samplerState.textureType = type;
 	samplerState.textureFormat = imageDescriptor->format;
 
+	if(samplerState.textureFormat.isCompressed())
+	{
+		// Blocks are decoded into texels of the format the image would otherwise be decompressed to.
+		samplerState.compressedFormat = samplerState.textureFormat;
+		samplerState.textureFormat = samplerState.compressedFormat.getDecompressedFormat();
+	}
+
 	samplerState.addressingModeU = convertAddressingMode(0, sampler, type);
 	samplerState.addressingModeV = convertAddressingMode(1, sampler, type);
 	samplerState.addressingModeW = convertAddressingMode(2, sampler, type);
@@ -72,6 +100,7 @@ SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::Sampl
 	samplerState.largeTexture = (imageDescriptor->extent.width > SHRT_MAX) ||
 	                            (imageDescriptor->extent.height > SHRT_MAX) ||
 	                            (imageDescriptor->extent.depth > SHRT_MAX);
+	samplerState.tiledTexture = imageDescriptor->tiled;
 
 	if(sampler)
 	{
@@ -92,15 +121,39 @@ SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::Sampl
 		}
 	}
 
-	routine = emitSamplerRoutine(instruction, samplerState);
+	return samplerState;
+}
 
-	cache->add(key, routine);
-	return (ImageSampler *)(routine->getEntry());
+void SpirvShader::updateSamplingProfile(SamplingProfile &profile, ImageInstruction instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler)
+{
+	const uint64_t samplerId = sampler ? sampler->id : 0;
+	const uint64_t descriptorIds = (uint64_t(imageDescriptor->imageViewId) << 32) | samplerId;
+
+	if(profile.descriptorIds.load(std::memory_order_relaxed) != descriptorIds)
+	{
+		std::unique_lock<std::mutex> lock(profile.mutex);
+		if(profile.descriptorIds != descriptorIds)
+		{
+			profile.samplerState = getSamplerState(instruction, imageDescriptor, sampler);
+			profile.descriptorIds = descriptorIds;
+			profile.count = 0;
+		}
+	}
+
+	// Stop counting once stable, so the workers don't keep contending for the counter.
+	if(profile.count.load(std::memory_order_relaxed) < vk::SAMPLING_SPECIALIZATION_THRESHOLD &&
+	   ++profile.count == vk::SAMPLING_SPECIALIZATION_THRESHOLD)
+	{
+		uint32_t version = profile.stableVersion->load();
+		while(version < vk::MAX_SAMPLING_SPECIALIZATIONS &&
+		      !profile.stableVersion->compare_exchange_weak(version, version + 1))
+		{
+		}
+	}
 }
 
 std::shared_ptr<rr::Routine> SpirvShader::emitSamplerRoutine(ImageInstruction instruction, const Sampler &samplerState)
 {
-	// TODO(b/129523279): Hold a separate mutex lock for the sampler being built.
 	rr::Function<Void(Pointer<Byte>, Pointer<Byte>, Pointer<SIMD::Float>, Pointer<SIMD::Float>, Pointer<Byte>)> function;
 	{
 		Pointer<Byte> texture = function.Arg<0>();
@@ -109,117 +162,123 @@ std::shared_ptr<rr::Routine> SpirvShader::emitSamplerRoutine(ImageInstruction in
 		Pointer<SIMD::Float> out = function.Arg<3>();
 		Pointer<Byte> constants = function.Arg<4>();
 
-		SIMD::Float uvw[4] = { 0, 0, 0, 0 };
-		SIMD::Float q = 0;
-		SIMD::Float lodOrBias = 0;  // Explicit level-of-detail, or bias added to the implicit level-of-detail (depending on samplerMethod).
-		Vector4f dsx = { 0, 0, 0, 0 };
-		Vector4f dsy = { 0, 0, 0, 0 };
-		Vector4f offset = { 0, 0, 0, 0 };
-		SIMD::Int sampleId = 0;
-		SamplerFunction samplerFunction = instruction.getSamplerFunction();
-
-		uint32_t i = 0;
-		for(; i < instruction.coordinates; i++)
-		{
-			uvw[i] = in[i];
-		}
+		emitSamplerFunction(instruction, samplerState, texture, sampler, in, out, constants);
+	}
 
-		if(instruction.isDref())
-		{
-			q = in[i];
-			i++;
-		}
+	return function("sampler");
+}
 
-		// TODO(b/134669567): Currently 1D textures are treated as 2D by setting the second coordinate to 0.
-		// Implement optimized 1D sampling.
-		if(samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D)
-		{
-			uvw[1] = SIMD::Float(0);
-		}
-		else if(samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D_ARRAY)
-		{
-			uvw[1] = SIMD::Float(0);
-			uvw[2] = in[1];  // Move 1D layer coordinate to 2D layer coordinate index.
-		}
+void SpirvShader::emitSamplerFunction(ImageInstruction instruction, const Sampler &samplerState, Pointer<Byte> texture, Pointer<Byte> sampler,
+                                      Pointer<SIMD::Float> in, Pointer<SIMD::Float> out, Pointer<Byte> constants)
+{
+	SIMD::Float uvw[4] = { 0, 0, 0, 0 };
+	SIMD::Float q = 0;
+	SIMD::Float lodOrBias = 0;  // Explicit level-of-detail, or bias added to the implicit level-of-detail (depending on samplerMethod).
+	Vector4f dsx = { 0, 0, 0, 0 };
+	Vector4f dsy = { 0, 0, 0, 0 };
+	Vector4f offset = { 0, 0, 0, 0 };
+	SIMD::Int sampleId = 0;
+	SamplerFunction samplerFunction = instruction.getSamplerFunction();
+
+	uint32_t i = 0;
+	for(; i < instruction.coordinates; i++)
+	{
+		uvw[i] = in[i];
+	}
 
-		if(instruction.samplerMethod == Lod || instruction.samplerMethod == Bias || instruction.samplerMethod == Fetch)
-		{
-			lodOrBias = in[i];
-			i++;
-		}
-		else if(instruction.samplerMethod == Grad)
-		{
-			for(uint32_t j = 0; j < instruction.grad; j++, i++)
-			{
-				dsx[j] = in[i];
-			}
+	if(instruction.isDref())
+	{
+		q = in[i];
+		i++;
+	}
 
-			for(uint32_t j = 0; j < instruction.grad; j++, i++)
-			{
-				dsy[j] = in[i];
-			}
-		}
+	// TODO(b/134669567): Currently 1D textures are treated as 2D by setting the second coordinate to 0.
+	// Implement optimized 1D sampling.
+	if(samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D)
+	{
+		uvw[1] = SIMD::Float(0);
+	}
+	else if(samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D_ARRAY)
+	{
+		uvw[1] = SIMD::Float(0);
+		uvw[2] = in[1];  // Move 1D layer coordinate to 2D layer coordinate index.
+	}
 
-		for(uint32_t j = 0; j < instruction.offset; j++, i++)
+	if(instruction.samplerMethod == Lod || instruction.samplerMethod == Bias || instruction.samplerMethod == Fetch)
+	{
+		lodOrBias = in[i];
+		i++;
+	}
+	else if(instruction.samplerMethod == Grad)
+	{
+		for(uint32_t j = 0; j < instruction.grad; j++, i++)
 		{
-			offset[j] = in[i];
+			dsx[j] = in[i];
 		}
 
-		if(instruction.sample)
+		for(uint32_t j = 0; j < instruction.grad; j++, i++)
 		{
-			sampleId = As<SIMD::Int>(in[i]);
+			dsy[j] = in[i];
 		}
+	}
+
+	for(uint32_t j = 0; j < instruction.offset; j++, i++)
+	{
+		offset[j] = in[i];
+	}
 
-		SamplerCore s(constants, samplerState);
+	if(instruction.sample)
+	{
+		sampleId = As<SIMD::Int>(in[i]);
+	}
 
-		// For explicit-lod instructions the LOD can be different per SIMD lane. SamplerCore currently assumes
-		// a single LOD per four elements, so we sample the image again for each LOD separately.
-		if(samplerFunction.method == Lod || samplerFunction.method == Grad)  // TODO(b/133868964): Also handle divergent Bias and Fetch with Lod.
+	SamplerCore s(constants, samplerState);
+
+	// For explicit-lod instructions the LOD can be different per SIMD lane. SamplerCore currently assumes
+	// a single LOD per four elements, so we sample the image again for each LOD separately.
+	if(samplerFunction.method == Lod || samplerFunction.method == Grad)  // TODO(b/133868964): Also handle divergent Bias and Fetch with Lod.
+	{
+		auto lod = Pointer<Float>(&lodOrBias);
+
+		For(Int i = 0, i < SIMD::Width, i++)
 		{
-			auto lod = Pointer<Float>(&lodOrBias);
+			SIMD::Float dPdx;
+			SIMD::Float dPdy;
+
+			dPdx.x = Pointer<Float>(&dsx.x)[i];
+			dPdx.y = Pointer<Float>(&dsx.y)[i];
+			dPdx.z = Pointer<Float>(&dsx.z)[i];
+
+			dPdy.x = Pointer<Float>(&dsy.x)[i];
+			dPdy.y = Pointer<Float>(&dsy.y)[i];
+			dPdy.z = Pointer<Float>(&dsy.z)[i];
 
-			For(Int i = 0, i < SIMD::Width, i++)
+			// 1D textures are treated as 2D texture with second coordinate 0, so we also need to zero out the second grad component. TODO(b/134669567)
+			if(samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D || samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D_ARRAY)
 			{
-				SIMD::Float dPdx;
-				SIMD::Float dPdy;
-
-				dPdx.x = Pointer<Float>(&dsx.x)[i];
-				dPdx.y = Pointer<Float>(&dsx.y)[i];
-				dPdx.z = Pointer<Float>(&dsx.z)[i];
-
-				dPdy.x = Pointer<Float>(&dsy.x)[i];
-				dPdy.y = Pointer<Float>(&dsy.y)[i];
-				dPdy.z = Pointer<Float>(&dsy.z)[i];
-
-				// 1D textures are treated as 2D texture with second coordinate 0, so we also need to zero out the second grad component. TODO(b/134669567)
-				if(samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D || samplerState.textureType == VK_IMAGE_VIEW_TYPE_1D_ARRAY)
-				{
-					dPdx.y = Float(0.0f);
-					dPdy.y = Float(0.0f);
-				}
-
-				Vector4f sample = s.sampleTexture(texture, sampler, uvw, q, lod[i], dPdx, dPdy, offset, sampleId, samplerFunction);
-
-				Pointer<Float> rgba = out;
-				rgba[0 * SIMD::Width + i] = Pointer<Float>(&sample.x)[i];
-				rgba[1 * SIMD::Width + i] = Pointer<Float>(&sample.y)[i];
-				rgba[2 * SIMD::Width + i] = Pointer<Float>(&sample.z)[i];
-				rgba[3 * SIMD::Width + i] = Pointer<Float>(&sample.w)[i];
+				dPdx.y = Float(0.0f);
+				dPdy.y = Float(0.0f);
 			}
-		}
-		else
-		{
-			Vector4f sample = s.sampleTexture(texture, sampler, uvw, q, lodOrBias.x, (dsx.x), (dsy.x), offset, sampleId, samplerFunction);
 
-			Pointer<SIMD::Float> rgba = out;
-			rgba[0] = sample.x;
-			rgba[1] = sample.y;
-			rgba[2] = sample.z;
-			rgba[3] = sample.w;
+			Vector4f sample = s.sampleTexture(texture, sampler, uvw, q, lod[i], dPdx, dPdy, offset, sampleId, samplerFunction);
+
+			Pointer<Float> rgba = out;
+			rgba[0 * SIMD::Width + i] = Pointer<Float>(&sample.x)[i];
+			rgba[1 * SIMD::Width + i] = Pointer<Float>(&sample.y)[i];
+			rgba[2 * SIMD::Width + i] = Pointer<Float>(&sample.z)[i];
+			rgba[3 * SIMD::Width + i] = Pointer<Float>(&sample.w)[i];
 		}
 	}
+	else
+	{
+		Vector4f sample = s.sampleTexture(texture, sampler, uvw, q, lodOrBias.x, (dsx.x), (dsy.x), offset, sampleId, samplerFunction);
 
-	return function("sampler");
+		Pointer<SIMD::Float> rgba = out;
+		rgba[0] = sample.x;
+		rgba[1] = sample.y;
+		rgba[2] = sample.z;
+		rgba[3] = sample.w;
+	}
 }
 
 sw::FilterType SpirvShader::convertFilterMode(const vk::Sampler *sampler)
@@ -48,6 +48,24 @@ void VertexRoutine::generate()
 
 	constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, constants));
 
+	If(*Pointer<Byte>(task + OFFSET(VertexTask, gatherShadedVertices)) != Byte(0))
+	{
+		Pointer<Byte> shadedVertices = *Pointer<Pointer<Byte>>(task + OFFSET(VertexTask, shadedVertices));
+
+		Do
+		{
+			Pointer<Byte> shadedVertex = shadedVertices + *batch * UInt((int)sizeof(Vertex));
+			writeVertex(vertex, shadedVertex);
+			vertex += sizeof(Vertex);
+
+			batch = Pointer<UInt>(Pointer<Byte>(batch) + sizeof(uint32_t));
+			vertexCount--;
+		}
+		Until(vertexCount == 0);
+
+		Return();
+	}
+
 	// Check the cache one vertex index at a time. If a hit occurs, copy from the cache to the 'vertex' output buffer.
 	// On a cache miss, process a SIMD width of consecutive indices from the input batch. They're written to the cache
 	// in reverse order to guarantee that the first one doesn't get evicted and can be written out.
@@ -33,7 +33,9 @@
 #	include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <memory.h>
+#include <mutex>
 
 #undef allocate
 #undef deallocate
@@ -42,6 +44,12 @@
 #	define __x86__
 #endif
 
+// Code memory regions are backed by a memfd, mapped both writable and
+// executable.
+#if defined(__linux__) && !defined(__ANDROID__)
+#	define DUAL_MAPPED_CODE_MEMORY
+#endif
+
 namespace rr {
 namespace {
 
@@ -128,7 +136,7 @@ int permissionsToMmapProt(int permissions)
 }
 #endif  // !defined(_WIN32) && !defined(__Fuchsia__)
 
-#if defined(LINUX_ENABLE_NAMED_MMAP)
+#if defined(LINUX_ENABLE_NAMED_MMAP) || defined(DUAL_MAPPED_CODE_MEMORY)
 // Create a file descriptor for anonymous memory with the given
 // name. Returns -1 on failure.
 // TODO: remove once libc wrapper exists.
@@ -153,7 +161,9 @@ int memfd_create(const char *name, unsigned int flags)
 	return -1;
 #	endif
 }
+#endif  // defined(LINUX_ENABLE_NAMED_MMAP) || defined(DUAL_MAPPED_CODE_MEMORY)
 
+#if defined(LINUX_ENABLE_NAMED_MMAP)
 // Returns a file descriptor for use with an anonymous mmap, if
 // memfd_create fails, -1 is returned. Note, the mappings should be
 // MAP_PRIVATE so that underlying pages aren't shared.
@@ -164,9 +174,14 @@ int anonymousFd()
 }
 
 // Ensure there is enough space in the "anonymous" fd for length.
+// Routines may be allocated from multiple threads concurrently, and the file
+// must never shrink under an existing mapping.
 void ensureAnonFileSize(int anonFd, size_t length)
 {
+	static std::mutex mutex;
 	static size_t fileSize = 0;
+
+	std::unique_lock<std::mutex> lock(mutex);
 	if(length > fileSize)
 	{
 		ftruncate(anonFd, length);
@@ -195,22 +210,86 @@ zx_vm_option_t permissionsToZxVmOptions(int permissions)
 }
 #endif  // defined(__Fuchsia__)
 
-}  // anonymous namespace
+// Rounds |x| up to a multiple of |m|, where |m| is a power of 2.
+inline uintptr_t roundUp(uintptr_t x, uintptr_t m)
+{
+	ASSERT(m > 0 && (m & (m - 1)) == 0);  // |m| must be a power of 2.
+	return (x + m - 1) & ~(m - 1);
+}
 
-size_t memoryPageSize()
+#if defined(DUAL_MAPPED_CODE_MEMORY)
+// Region of code memory which routines are bump allocated from.
+struct CodeRegion
 {
-	static int pageSize = 0;
+	uint8_t *writable;
+	uint8_t *executable;
+	size_t size;
+	size_t used;
+	int allocations;  // Not yet released
+};
+
+constexpr size_t CodeRegionSize = 1 << 20;
+
+CodeRegion *createCodeRegion(size_t size)
+{
+	int fd = memfd_create("SwiftShader JIT", 0);
+	if(fd == -1)
+	{
+		return nullptr;
+	}
+
+	CodeRegion *region = nullptr;
 
-	if(pageSize == 0)
+	if(ftruncate(fd, size) == 0)
 	{
+		void *writable = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		void *executable = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+
+		if(writable != MAP_FAILED && executable != MAP_FAILED)
+		{
+			region = new CodeRegion{ (uint8_t *)writable, (uint8_t *)executable, size, 0, 0 };
+		}
+		else
+		{
+			if(writable != MAP_FAILED) munmap(writable, size);
+			if(executable != MAP_FAILED) munmap(executable, size);
+		}
+	}
+
+	close(fd);  // The mappings keep the memory alive.
+
+	return region;
+}
+
+void destroyCodeRegion(CodeRegion *region)
+{
+	munmap(region->writable, region->size);
+	munmap(region->executable, region->size);
+	delete region;
+}
+
+// Falls back to allocating pages per routine if creating a region fails.
+bool dualMappedCodeMemory = true;
+CodeRegion *currentCodeRegion = nullptr;
+#endif  // defined(DUAL_MAPPED_CODE_MEMORY)
+
+std::mutex codeMemoryMutex;
+size_t codeBytesUsed = 0;      // Guarded by codeMemoryMutex
+size_t codeBytesReserved = 0;  // Guarded by codeMemoryMutex
+
+}  // anonymous namespace
+
+size_t memoryPageSize()
+{
+	static int pageSize = [] {
 #if defined(_WIN32)
 		SYSTEM_INFO systemInfo;
 		GetSystemInfo(&systemInfo);
-		pageSize = systemInfo.dwPageSize;
+		return static_cast<int>(systemInfo.dwPageSize);
 #else
-		pageSize = sysconf(_SC_PAGESIZE);
+		return static_cast<int>(sysconf(_SC_PAGESIZE));
 #endif
-	}
+	}();
 
 	return pageSize;
 }
@@ -242,13 +321,6 @@ void deallocate(void *memory)
 #endif
 }
 
-// Rounds |x| up to a multiple of |m|, where |m| is a power of 2.
-inline uintptr_t roundUp(uintptr_t x, uintptr_t m)
-{
-	ASSERT(m > 0 && (m & (m - 1)) == 0);  // |m| must be a power of 2.
-	return (x + m - 1) & ~(m - 1);
-}
-
 void *allocateMemoryPages(size_t bytes, int permissions, bool need_exec)
 {
 	size_t pageSize = memoryPageSize();
@@ -379,4 +451,131 @@ void deallocateMemoryPages(void *memory, size_t bytes)
 #endif
 }
 
+CodeMemory allocateCodeMemory(size_t bytes)
+{
+	CodeMemory memory;
+	memory.bytes = bytes;
+
+	std::unique_lock<std::mutex> lock(codeMemoryMutex);
+
+#if defined(DUAL_MAPPED_CODE_MEMORY)
+	if(dualMappedCodeMemory)
+	{
+		size_t size = roundUp(bytes, CodeMemoryAlignment);
+		CodeRegion *region = currentCodeRegion;
+
+		if(!region || (region->used + size > region->size))
+		{
+			// Routines larger than a region get one of their own, and don't
+			// replace the current one.
+			size_t regionSize = std::max(CodeRegionSize, size_t(roundUp(size, memoryPageSize())));
+			region = createCodeRegion(regionSize);
+
+			if(region)
+			{
+				codeBytesReserved += regionSize;
+
+				if(size <= CodeRegionSize)
+				{
+					if(currentCodeRegion && (currentCodeRegion->allocations == 0))
+					{
+						codeBytesReserved -= currentCodeRegion->size;
+						destroyCodeRegion(currentCodeRegion);
+					}
+
+					currentCodeRegion = region;
+				}
+			}
+			else
+			{
+				dualMappedCodeMemory = false;
+			}
+		}
+
+		if(region)
+		{
+			memory.writable = region->writable + region->used;
+			memory.executable = region->executable + region->used;
+			memory.region = region;
+
+			region->used += size;
+			region->allocations++;
+			codeBytesUsed += size;
+
+			return memory;
+		}
+	}
+#endif  // defined(DUAL_MAPPED_CODE_MEMORY)
+
+	memory.writable = allocateMemoryPages(bytes, PERMISSION_READ | PERMISSION_WRITE, true);
+	memory.executable = memory.writable;
+
+	if(memory.writable)
+	{
+		codeBytesUsed += bytes;
+		codeBytesReserved += roundUp(bytes, memoryPageSize());
+	}
+
+	return memory;
+}
+
+void finalizeCodeMemory(const CodeMemory &memory)
+{
+	if(!memory.region)
+	{
+		protectMemoryPages(memory.writable, memory.bytes, PERMISSION_READ | PERMISSION_EXECUTE);
+	}
+
+#if defined(_WIN32)
+	FlushInstructionCache(GetCurrentProcess(), memory.executable, memory.bytes);
+#else
+	char *executable = (char *)memory.executable;
+	__builtin___clear_cache(executable, executable + memory.bytes);
+#endif
+}
+
+void deallocateCodeMemory(const CodeMemory &memory)
+{
+	if(!memory.writable)
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(codeMemoryMutex);
+
+#if defined(DUAL_MAPPED_CODE_MEMORY)
+	if(memory.region)
+	{
+		CodeRegion *region = reinterpret_cast<CodeRegion *>(memory.region);
+		codeBytesUsed -= roundUp(memory.bytes, CodeMemoryAlignment);
+
+		if(--region->allocations == 0)
+		{
+			if(region == currentCodeRegion)
+			{
+				region->used = 0;  // Reuse it from the start.
+			}
+			else
+			{
+				codeBytesReserved -= region->size;
+				destroyCodeRegion(region);
+			}
+		}
+
+		return;
+	}
+#endif  // defined(DUAL_MAPPED_CODE_MEMORY)
+
+	deallocateMemoryPages(memory.writable, memory.bytes);
+
+	codeBytesUsed -= memory.bytes;
+	codeBytesReserved -= roundUp(memory.bytes, memoryPageSize());
+}
+
+CodeMemoryStats codeMemoryStats()
+{
+	std::unique_lock<std::mutex> lock(codeMemoryMutex);
+	return { codeBytesUsed, codeBytesReserved };
+}
+
 }  // namespace rr
@@ -40,6 +40,39 @@ void protectMemoryPages(void *memory, size_t bytes, int permissions);
 // Releases memory allocated with allocateMemoryPages().
 void deallocateMemoryPages(void *memory, size_t bytes);
 
+// Memory for the code of a routine. Where supported, it is suballocated from
+// large regions shared by many routines, which are mapped twice: once
+// writable and once executable, so code can be written without changing the
+// protection of the other routines' pages.
+struct CodeMemory
+{
+	void *writable = nullptr;
+	const void *executable = nullptr;
+	size_t bytes = 0;
+	void *region = nullptr;
+};
+
+// Allocates bytes of code memory aligned to CodeMemoryAlignment. Returns
+// memory with null addresses on failure.
+CodeMemory allocateCodeMemory(size_t bytes);
+
+// Makes the code written to memory.writable executable from memory.executable.
+void finalizeCodeMemory(const CodeMemory &memory);
+
+// Releases memory allocated with allocateCodeMemory(). Regions are unmapped
+// once all of their allocations are released.
+void deallocateCodeMemory(const CodeMemory &memory);
+
+constexpr size_t CodeMemoryAlignment = 64;
+
+struct CodeMemoryStats
+{
+	size_t bytesUsed;      // Allocated to routines which haven't been released
+	size_t bytesReserved;  // Mapped for code, including unused space
+};
+
+CodeMemoryStats codeMemoryStats();
+
 template<typename P>
 P unaligned_read(P *address)
 {
@@ -84,6 +84,8 @@ __pragma(warning(push))
 
 #include <unordered_map>
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <mutex>
@@ -130,48 +132,11 @@ rr::Config &defaultConfig()
 	return config;
 }
 
-// Cache provides a simple, thread-safe key-value store.
-template<typename KEY, typename VALUE>
-class Cache
-{
-public:
-	Cache() = default;
-	Cache(const Cache &other);
-	VALUE getOrCreate(KEY key, std::function<VALUE()> create);
-
-private:
-	mutable std::mutex mutex;  // mutable required for copy constructor.
-	std::unordered_map<KEY, VALUE> map;
-};
-
-template<typename KEY, typename VALUE>
-Cache<KEY, VALUE>::Cache(const Cache &other)
-{
-	std::unique_lock<std::mutex> lock(other.mutex);
-	map = other.map;
-}
-
-template<typename KEY, typename VALUE>
-VALUE Cache<KEY, VALUE>::getOrCreate(KEY key, std::function<VALUE()> create)
-{
-	std::unique_lock<std::mutex> lock(mutex);
-	auto it = map.find(key);
-	if(it != map.end())
-	{
-		return it->second;
-	}
-	auto value = create();
-	map.emplace(key, value);
-	return value;
-}
-
 // JITGlobals is a singleton that holds all the immutable machine specific
-// information for the host device.
+// information for the host device. It is safe to use from multiple threads.
 class JITGlobals
 {
 public:
-	using TargetMachineSPtr = std::shared_ptr<llvm::TargetMachine>;
-
 	static JITGlobals *get();
 
 	const std::string mcpu;
@@ -180,7 +145,11 @@ public:
 	const llvm::TargetOptions targetOptions;
 	const llvm::DataLayout dataLayout;
 
-	TargetMachineSPtr getTargetMachine(rr::Optimization::Level optlevel);
+	// createTargetMachine() returns a new llvm::TargetMachine for the given
+	// optimization level. llvm::TargetMachine lazily caches subtarget state
+	// and is not safe to share between concurrent compilations, so each
+	// routine gets its own.
+	std::unique_ptr<llvm::TargetMachine> createTargetMachine(rr::Optimization::Level optlevel);
 
 private:
 	static JITGlobals create();
@@ -191,8 +160,6 @@ private:
 	           const llvm::TargetOptions &targetOptions,
 	           const llvm::DataLayout &dataLayout);
 	JITGlobals(const JITGlobals &) = default;
-
-	Cache<rr::Optimization::Level, TargetMachineSPtr> targetMachines;
 };
 
 JITGlobals *JITGlobals::get()
@@ -201,7 +168,7 @@ JITGlobals *JITGlobals::get()
 	return &instance;
 }
 
-JITGlobals::TargetMachineSPtr JITGlobals::getTargetMachine(rr::Optimization::Level optlevel)
+std::unique_ptr<llvm::TargetMachine> JITGlobals::createTargetMachine(rr::Optimization::Level optlevel)
 {
 #ifdef ENABLE_RR_DEBUG_INFO
 	auto llvmOptLevel = toLLVM(rr::Optimization::Level::None);
@@ -209,15 +176,14 @@ JITGlobals::TargetMachineSPtr JITGlobals::getTargetMachine(rr::Optimization::Lev
 	auto llvmOptLevel = toLLVM(optlevel);
 #endif  // ENABLE_RR_DEBUG_INFO
 
-	return targetMachines.getOrCreate(optlevel, [&]() {
-		return TargetMachineSPtr(llvm::EngineBuilder()
-		                             .setOptLevel(llvmOptLevel)
-		                             .setMCPU(mcpu)
-		                             .setMArch(march)
-		                             .setMAttrs(mattrs)
-		                             .setTargetOptions(targetOptions)
-		                             .selectTarget());
-	});
+	return std::unique_ptr<llvm::TargetMachine>(
+	    llvm::EngineBuilder()
+	        .setOptLevel(llvmOptLevel)
+	        .setMCPU(mcpu)
+	        .setMArch(march)
+	        .setMAttrs(mattrs)
+	        .setTargetOptions(targetOptions)
+	        .selectTarget());
 }
 
 JITGlobals JITGlobals::create()
@@ -338,6 +304,8 @@ public:
 		    numBytes, flagsToPermissions(flags), need_exec);
 		if(!addr)
 			return llvm::sys::MemoryBlock();
+		if(need_exec)
+			codeBytes += numBytes;
 		return llvm::sys::MemoryBlock(addr, numBytes);
 	}
 
@@ -364,6 +332,8 @@ public:
 		return std::error_code();
 	}
 
+	size_t codeBytes = 0;  // Allocated for code, in pages
+
 private:
 	int flagsToPermissions(unsigned flags)
 	{
@@ -421,7 +391,7 @@ public:
 			          return;
 		          }
 	          }))
-	    , targetMachine(JITGlobals::get()->getTargetMachine(config.getOptimization().getLevel()))
+	    , targetMachine(JITGlobals::get()->createTargetMachine(config.getOptimization().getLevel()))
 	    , compileLayer(objLayer, llvm::orc::SimpleCompiler(*targetMachine))
 	    , objLayer(
 	          session,
@@ -445,7 +415,7 @@ public:
 		for(size_t i = 0; i < count; i++)
 		{
 			auto func = funcs[i];
-			static size_t numEmittedFunctions = 0;
+			static std::atomic<size_t> numEmittedFunctions = { 0 };
 			std::string name = "f" + llvm::Twine(numEmittedFunctions++).str();
 			func->setName(name);
 			func->setLinkage(llvm::GlobalValue::ExternalLinkage);
@@ -480,9 +450,14 @@ public:
 		return addresses[index];
 	}
 
+	size_t getCodeSize() const
+	{
+		return memoryMapper.codeBytes;
+	}
+
 private:
 	std::shared_ptr<llvm::orc::SymbolResolver> resolver;
-	std::shared_ptr<llvm::TargetMachine> targetMachine;
+	std::unique_ptr<llvm::TargetMachine> targetMachine;
 	llvm::orc::ExecutionSession session;
 	CompileLayer compileLayer;
 	MemoryMapper memoryMapper;
@@ -490,7 +465,8 @@ private:
 	std::vector<const void *> addresses;
 };
 
-// JITBuilder holds all the LLVM state for building routines.
+// JITBuilder holds all the LLVM state for building routines. Each thread
+// building a routine has its own JITBuilder, see Nucleus::Nucleus().
 class JITBuilder
 {
 public:
@@ -538,7 +514,7 @@ public:
 		passManager->run(*module);
 	}
 
-	std::shared_ptr<rr::Routine> acquireRoutine(llvm::Function **funcs, size_t count, const rr::Config &cfg)
+	std::shared_ptr<JITRoutine> acquireRoutine(llvm::Function **funcs, size_t count, const rr::Config &cfg)
 	{
 		ASSERT(module);
 		return std::make_shared<JITRoutine>(std::move(module), funcs, count, cfg);
@@ -570,8 +546,7 @@ public:
 #endif
 };
 
-std::unique_ptr<JITBuilder> jit;
-std::mutex codegenMutex;
+thread_local std::unique_ptr<JITBuilder> jit;
 
 #ifdef ENABLE_RR_PRINT
 std::string replace(std::string str, const std::string &substr, const std::string &replacement)
@@ -1367,8 +1342,6 @@ static ::llvm::Function *createFunction(const char *name, ::llvm::Type *retTy, c
 
 Nucleus::Nucleus()
 {
-	::codegenMutex.lock();  // Reactor and LLVM are currently not thread safe
-
 	ASSERT(jit == nullptr);
 	jit.reset(new JITBuilder(Nucleus::getDefaultConfig()));
 }
@@ -1376,7 +1349,6 @@ Nucleus::Nucleus()
 Nucleus::~Nucleus()
 {
 	jit.reset();
-	::codegenMutex.unlock();
 }
 
 void Nucleus::setDefaultConfig(const Config &cfg)
@@ -1400,6 +1372,7 @@ Config Nucleus::getDefaultConfig()
 
 std::shared_ptr<Routine> Nucleus::acquireRoutine(const char *name, const Config::Edit &cfgEdit /* = Config::Edit::None */)
 {
+	auto start = std::chrono::steady_clock::now();
 	auto cfg = cfgEdit.apply(jit->config);
 
 	if(jit->builder->GetInsertBlock()->empty() || !jit->builder->GetInsertBlock()->back().isTerminator())
@@ -1450,6 +1423,9 @@ std::shared_ptr<Routine> Nucleus::acquireRoutine(const char *name, const Config:
 	auto routine = jit->acquireRoutine(&jit->function, 1, cfg);
 	jit.reset();
 
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	recordCompile(name, elapsed.count(), routine->getCodeSize());
+
 	return routine;
 }
 
@@ -5031,6 +5007,8 @@ void Nucleus::yield(Value *val)
 
 std::shared_ptr<Routine> Nucleus::acquireCoroutine(const char *name, const Config::Edit &cfgEdit /* = Config::Edit::None */)
 {
+	auto start = std::chrono::steady_clock::now();
+
 	bool isCoroutine = jit->coroutine.id != nullptr;
 	if(isCoroutine)
 	{
@@ -5101,6 +5079,9 @@ std::shared_ptr<Routine> Nucleus::acquireCoroutine(const char *name, const Confi
 	auto routine = jit->acquireRoutine(funcs, Nucleus::CoroutineEntryCount, cfg);
 	jit.reset();
 
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	recordCompile(name, elapsed.count(), routine->getCodeSize());
+
 	return routine;
 }
 
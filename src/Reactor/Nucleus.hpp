@@ -20,6 +20,7 @@
 #include <cstdarg>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #ifdef None
@@ -151,6 +152,26 @@ private:
 	Optimization optimization;
 };
 
+// Statistics of the routines built by Reactor, grouped by name, without the
+// hexadecimal suffix of names like "PixelRoutine_%0.8X".
+struct CompileStats
+{
+	std::string name;
+	uint64_t count;       // Number of routines built
+	double totalMs;       // Time spent in Nucleus::acquireRoutine()
+	double p50Ms;         // Percentiles of the build time, rounded up to a
+	double p99Ms;         // power of two microseconds
+	uint64_t codeBytes;   // Total size of the code emitted
+	std::string slowest;  // Full name of the slowest routine
+	double slowestMs;
+};
+
+// Records a routine built by the backend in ms milliseconds.
+void recordCompile(const char *name, double ms, size_t codeBytes);
+
+// Returns the statistics of the routines built so far, sorted by name.
+std::vector<CompileStats> getCompileStats();
+
 class Nucleus
 {
 public:
@@ -16,6 +16,8 @@
 #include "Debug.hpp"
 
 #include <cmath>
+#include <map>
+#include <mutex>
 
 // Define REACTOR_MATERIALIZE_LVALUES_ON_DEFINITION to non-zero to ensure all
 // variables have a stack location obtained throuch alloca().
@@ -79,8 +81,92 @@ void rr::Config::Edit::apply(const std::vector<std::pair<ListEdit, T>> &edits, s
 	}
 }
 
+namespace {
+
+struct CompileHistory
+{
+	uint64_t count = 0;
+	double totalMs = 0.0;
+	uint64_t codeBytes = 0;
+	std::string slowest;
+	double slowestMs = 0.0;
+
+	// Number of routines which took [2^i, 2^(i+1)) microseconds to build.
+	uint64_t histogram[32] = {};
+
+	double percentile(double p) const
+	{
+		uint64_t rank = static_cast<uint64_t>(std::ceil(count * p));
+		uint64_t seen = 0;
+
+		for(int i = 0; i < 32; i++)
+		{
+			seen += histogram[i];
+			if(seen >= rank)
+			{
+				return static_cast<double>(2ull << i) / 1000.0;
+			}
+		}
+
+		return slowestMs;
+	}
+};
+
+std::mutex compileHistoryMutex;
+std::map<std::string, CompileHistory> compileHistory;  // Guarded by compileHistoryMutex
+
+}  // anonymous namespace
+
+void recordCompile(const char *name, double ms, size_t codeBytes)
+{
+	// Group routines by the name they were given without a hash suffix.
+	std::string group = name;
+	size_t suffix = group.find_last_of('_');
+	if(suffix != std::string::npos && suffix + 1 < group.size() &&
+	   group.find_first_not_of("0123456789ABCDEFabcdef", suffix + 1) == std::string::npos)
+	{
+		group.resize(suffix);
+	}
+
+	int bucket = 0;
+	for(double us = ms * 1000.0; us >= 2.0 && bucket < 31; us /= 2.0)
+	{
+		bucket++;
+	}
+
+	std::unique_lock<std::mutex> lock(compileHistoryMutex);
+	CompileHistory &history = compileHistory[group];
+
+	history.count++;
+	history.totalMs += ms;
+	history.codeBytes += codeBytes;
+	history.histogram[bucket]++;
+
+	if(ms > history.slowestMs)
+	{
+		history.slowest = name;
+		history.slowestMs = ms;
+	}
+}
+
+std::vector<CompileStats> getCompileStats()
+{
+	std::unique_lock<std::mutex> lock(compileHistoryMutex);
+	std::vector<CompileStats> stats;
+
+	for(auto &it : compileHistory)
+	{
+		const CompileHistory &history = it.second;
+		stats.push_back({ it.first, history.count, history.totalMs, history.percentile(0.5), history.percentile(0.99),
+		                  history.codeBytes, history.slowest, history.slowestMs });
+	}
+
+	return stats;
+}
+
 // Set of variables that do not have a stack location yet.
-std::unordered_set<Variable *> Variable::unmaterializedVariables;
+// Routines may be built concurrently on separate threads, so this is per-thread.
+thread_local std::unordered_set<Variable *> Variable::unmaterializedVariables;
 
 Variable::Variable(Type *type, int arraySize)
     : arraySize(arraySize)
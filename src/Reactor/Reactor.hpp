@@ -133,7 +133,7 @@ private:
 	static void materializeAll();
 	static void killUnmaterialized();
 
-	static std::unordered_set<Variable *> unmaterializedVariables;
+	static thread_local std::unordered_set<Variable *> unmaterializedVariables;
 
 	Type *const type;
 	mutable Value *rvalue = nullptr;
@@ -2576,12 +2576,26 @@ public:
 
 	RoutineType operator()(const char *name, ...)
 	{
-		return RoutineType(BaseType::operator()(name));
+		char fullName[1024 + 1];
+
+		va_list vararg;
+		va_start(vararg, name);
+		vsnprintf(fullName, 1024, name, vararg);
+		va_end(vararg);
+
+		return RoutineType(BaseType::operator()("%s", fullName));
 	}
 
 	RoutineType operator()(const Config::Edit &cfg, const char *name, ...)
 	{
-		return RoutineType(BaseType::operator()(cfg, name));
+		char fullName[1024 + 1];
+
+		va_list vararg;
+		va_start(vararg, name);
+		vsnprintf(fullName, 1024, name, vararg);
+		va_end(vararg);
+
+		return RoutineType(BaseType::operator()(cfg, "%s", fullName));
 	}
 };
 
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include "Coroutine.hpp"
+#include "ExecutableMemory.hpp"
 #include "Reactor.hpp"
 
 #include "gtest/gtest.h"
 
+#include <chrono>
 #include <cmath>
+#include <thread>
 #include <tuple>
 
 using namespace rr;
@@ -124,6 +127,115 @@ TEST(ReactorUnitTests, Sample)
 	}
 }
 
+// Builds a routine that is moderately expensive to compile, returning
+// reference(p, y) + seed.
+static FunctionT<int(int *, int)>::RoutineType buildSampleRoutine(int seed)
+{
+	FunctionT<int(int *, int)> function;
+	{
+		Pointer<Int> p = function.Arg<0>();
+		Int x = p[-1];
+		Int y = function.Arg<1>();
+		Int z = 4;
+
+		For(Int i = 0, i < 10, i++)
+		{
+			z += (2 << i) - (i / 3);
+		}
+
+		Float4 v = Float4(As<Float>(z));
+		for(int i = 0; i < 64; i++)
+		{
+			v = Max(v * Float4(1.0f), Float4(-1.0f)) + Float4(0.0f);
+			v = v.yxwz;
+		}
+		z = As<Int>(Float(v.x));
+
+		Int sum = x + y + z + Int(seed);
+
+		Return(sum);
+	}
+
+	return function("seed");
+}
+
+TEST(ReactorUnitTests, MultiThreadedCompile)
+{
+	const int threadCount = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+	const int routinesPerThread = 8;
+
+	auto verify = [](FunctionT<int(int *, int)>::RoutineType &routine, int seed) {
+		int one[2] = { 1, 0 };
+		EXPECT_EQ(routine(&one[1], 2), reference(&one[1], 2) + seed);
+	};
+
+	// Compile all routines on this thread.
+	auto serialStart = std::chrono::steady_clock::now();
+	for(int i = 0; i < threadCount * routinesPerThread; i++)
+	{
+		auto routine = buildSampleRoutine(i);
+		verify(routine, i);
+	}
+	auto serialTime = std::chrono::steady_clock::now() - serialStart;
+
+	// Compile the same routines spread across threadCount threads.
+	std::vector<std::thread> threads;
+	auto parallelStart = std::chrono::steady_clock::now();
+	for(int t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([=] {
+			for(int i = 0; i < routinesPerThread; i++)
+			{
+				int seed = t * routinesPerThread + i;
+				auto routine = buildSampleRoutine(seed);
+				verify(routine, seed);
+			}
+		});
+	}
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+	auto parallelTime = std::chrono::steady_clock::now() - parallelStart;
+
+	// Timing depends on the host, so only report it.
+	using ms = std::chrono::duration<double, std::milli>;
+	printf("%d routines: serial compile %.1f ms, %d threads %.1f ms\n",
+	       threadCount * routinesPerThread,
+	       ms(serialTime).count(), threadCount, ms(parallelTime).count());
+}
+
+TEST(ReactorUnitTests, SharedCodeMemory)
+{
+	const CodeMemoryStats before = codeMemoryStats();
+
+	// Routines may be packed into the same code memory region. Each must
+	// remain intact as others are added and released.
+	{
+		std::vector<std::pair<int, FunctionT<int(int *, int)>::RoutineType>> routines;
+		for(int i = 0; i < 64; i++)
+		{
+			routines.emplace_back(i, buildSampleRoutine(i));
+
+			if(i % 3 == 0)
+			{
+				routines.erase(routines.begin());
+			}
+		}
+
+		const CodeMemoryStats stats = codeMemoryStats();
+		EXPECT_GE(stats.bytesReserved, stats.bytesUsed);
+
+		for(auto &routine : routines)
+		{
+			int one[2] = { 1, 0 };
+			EXPECT_EQ(routine.second(&one[1], 2), reference(&one[1], 2) + routine.first);
+		}
+	}
+
+	EXPECT_EQ(codeMemoryStats().bytesUsed, before.bytesUsed);
+}
+
 TEST(ReactorUnitTests, Uninitialized)
 {
 	FunctionT<int()> function;
@@ -63,6 +63,12 @@ public:
 		return reinterpret_cast<void *>(callable);
 	}
 
+	// Returns the number of references to the underlying routine.
+	long useCount() const
+	{
+		return routine.use_count();
+	}
+
 private:
 	std::shared_ptr<Routine> routine;
 	using CallableType = Return (*)(Arguments...);
@@ -45,6 +45,7 @@
 #	include <Windows.h>
 #endif
 
+#include <chrono>
 #include <iostream>
 #include <limits>
 #include <mutex>
@@ -66,16 +67,21 @@ rr::Config &defaultConfig()
 	return config;
 }
 
-Ice::GlobalContext *context = nullptr;
-Ice::Cfg *function = nullptr;
-Ice::CfgNode *basicBlock = nullptr;
-Ice::CfgLocalAllocatorScope *allocator = nullptr;
-rr::ELFMemoryStreamer *routine = nullptr;
+// Routines may be built concurrently on separate threads. Each thread has its
+// own Subzero context and function under construction.
+thread_local Ice::GlobalContext *context = nullptr;
+thread_local Ice::Cfg *function = nullptr;
+thread_local Ice::CfgNode *basicBlock = nullptr;
+thread_local Ice::CfgLocalAllocatorScope *allocator = nullptr;
+thread_local rr::ELFMemoryStreamer *routine = nullptr;
 
-std::mutex codegenMutex;
+thread_local Ice::ELFFileStreamer *elfFile = nullptr;
+thread_local Ice::Fdstream *out = nullptr;
 
-Ice::ELFFileStreamer *elfFile = nullptr;
-Ice::Fdstream *out = nullptr;
+// Subzero's command line flags are process-wide, and constructing an
+// Ice::GlobalContext performs one-time unsynchronized initialization of the
+// target lowering. Both must be done under this lock.
+std::mutex contextInitLock;
 
 }  // Anonymous namespace
 
@@ -260,7 +266,9 @@ inline const SectionHeader *elfSection(const ElfHeader *elfHeader, int index)
 	return &sectionHeader(elfHeader)[index];
 }
 
-static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocation, const SectionHeader &relocationTable)
+// Relocations are applied to the image at elfHeader, for it to be executed
+// once its sections have been copied to loadAddress.
+static void *relocateSymbol(const ElfHeader *elfHeader, intptr_t loadAddress, const Elf32_Rel &relocation, const SectionHeader &relocationTable)
 {
 	const SectionHeader *target = elfSection(elfHeader, relocationTable.sh_info);
 
@@ -287,7 +295,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 		if(section != SHN_UNDEF && section < SHN_LORESERVE)
 		{
 			const SectionHeader *target = elfSection(elfHeader, symbol.st_shndx);
-			symbolValue = reinterpret_cast<void *>((intptr_t)elfHeader + symbol.st_value + target->sh_offset);
+			symbolValue = reinterpret_cast<void *>(loadAddress + symbol.st_value + target->sh_offset);
 		}
 		else
 		{
@@ -297,6 +305,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 
 	intptr_t address = (intptr_t)elfHeader + target->sh_offset;
 	unaligned_ptr<int32_t> patchSite = (int32_t *)(address + relocation.r_offset);
+	intptr_t loadedPatchSite = loadAddress + target->sh_offset + relocation.r_offset;
 
 	if(CPUID::ARM)
 	{
@@ -334,7 +343,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 				*patchSite = (int32_t)((intptr_t)symbolValue + *patchSite);
 				break;
 			case R_386_PC32:
-				*patchSite = (int32_t)((intptr_t)symbolValue + *patchSite - (intptr_t)patchSite);
+				*patchSite = (int32_t)((intptr_t)symbolValue + *patchSite - loadedPatchSite);
 				break;
 			default:
 				ASSERT(false && "Unsupported relocation type");
@@ -345,7 +354,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf32_Rel &relocat
 	return symbolValue;
 }
 
-static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &relocation, const SectionHeader &relocationTable)
+static void *relocateSymbol(const ElfHeader *elfHeader, intptr_t loadAddress, const Elf64_Rela &relocation, const SectionHeader &relocationTable)
 {
 	const SectionHeader *target = elfSection(elfHeader, relocationTable.sh_info);
 
@@ -372,7 +381,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 		if(section != SHN_UNDEF && section < SHN_LORESERVE)
 		{
 			const SectionHeader *target = elfSection(elfHeader, symbol.st_shndx);
-			symbolValue = reinterpret_cast<void *>((intptr_t)elfHeader + symbol.st_value + target->sh_offset);
+			symbolValue = reinterpret_cast<void *>(loadAddress + symbol.st_value + target->sh_offset);
 		}
 		else
 		{
@@ -383,6 +392,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 	intptr_t address = (intptr_t)elfHeader + target->sh_offset;
 	unaligned_ptr<int32_t> patchSite32 = (int32_t *)(address + relocation.r_offset);
 	unaligned_ptr<int64_t> patchSite64 = (int64_t *)(address + relocation.r_offset);
+	intptr_t loadedPatchSite = loadAddress + target->sh_offset + relocation.r_offset;
 
 	switch(relocation.getType())
 	{
@@ -393,7 +403,7 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 			*patchSite64 = (int64_t)((intptr_t)symbolValue + *patchSite64 + relocation.r_addend);
 			break;
 		case R_X86_64_PC32:
-			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 - (intptr_t)patchSite32 + relocation.r_addend);
+			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 - loadedPatchSite + relocation.r_addend);
 			break;
 		case R_X86_64_32S:
 			*patchSite32 = (int32_t)((intptr_t)symbolValue + *patchSite32 + relocation.r_addend);
@@ -406,7 +416,28 @@ static void *relocateSymbol(const ElfHeader *elfHeader, const Elf64_Rela &reloca
 	return symbolValue;
 }
 
-void *loadImage(uint8_t *const elfImage, size_t &codeSize)
+// Returns the range of the image holding sections which are loaded in memory.
+static void loadedRange(const uint8_t *elfImage, size_t &begin, size_t &end)
+{
+	const ElfHeader *elfHeader = (const ElfHeader *)elfImage;
+	const SectionHeader *sectionHeader = (const SectionHeader *)(elfImage + elfHeader->e_shoff);
+
+	begin = ~size_t(0);
+	end = 0;
+
+	for(int i = 0; i < elfHeader->e_shnum; i++)
+	{
+		if((sectionHeader[i].sh_type == SHT_PROGBITS) && (sectionHeader[i].sh_flags & SHF_ALLOC))
+		{
+			begin = std::min(begin, size_t(sectionHeader[i].sh_offset));
+			end = std::max(end, size_t(sectionHeader[i].sh_offset + sectionHeader[i].sh_size));
+		}
+	}
+}
+
+// Relocates the image for its loaded sections to be executed at loadAddress,
+// and returns the address of its entry point there.
+void *loadImage(uint8_t *const elfImage, intptr_t loadAddress)
 {
 	ElfHeader *elfHeader = (ElfHeader *)elfImage;
 
@@ -440,8 +471,7 @@ void *loadImage(uint8_t *const elfImage, size_t &codeSize)
 		{
 			if(sectionHeader[i].sh_flags & SHF_EXECINSTR)
 			{
-				entry = elfImage + sectionHeader[i].sh_offset;
-				codeSize = sectionHeader[i].sh_size;
+				entry = reinterpret_cast<void *>(loadAddress + sectionHeader[i].sh_offset);
 			}
 		}
 		else if(sectionHeader[i].sh_type == SHT_REL)
@@ -451,7 +481,7 @@ void *loadImage(uint8_t *const elfImage, size_t &codeSize)
 			for(Elf32_Word index = 0; index < sectionHeader[i].sh_size / sectionHeader[i].sh_entsize; index++)
 			{
 				const Elf32_Rel &relocation = ((const Elf32_Rel *)(elfImage + sectionHeader[i].sh_offset))[index];
-				relocateSymbol(elfHeader, relocation, sectionHeader[i]);
+				relocateSymbol(elfHeader, loadAddress, relocation, sectionHeader[i]);
 			}
 		}
 		else if(sectionHeader[i].sh_type == SHT_RELA)
@@ -461,7 +491,7 @@ void *loadImage(uint8_t *const elfImage, size_t &codeSize)
 			for(Elf32_Word index = 0; index < sectionHeader[i].sh_size / sectionHeader[i].sh_entsize; index++)
 			{
 				const Elf64_Rela &relocation = ((const Elf64_Rela *)(elfImage + sectionHeader[i].sh_offset))[index];
-				relocateSymbol(elfHeader, relocation, sectionHeader[i]);
+				relocateSymbol(elfHeader, loadAddress, relocation, sectionHeader[i]);
 			}
 		}
 	}
@@ -469,29 +499,6 @@ void *loadImage(uint8_t *const elfImage, size_t &codeSize)
 	return entry;
 }
 
-template<typename T>
-struct ExecutableAllocator
-{
-	ExecutableAllocator() {}
-	template<class U>
-	ExecutableAllocator(const ExecutableAllocator<U> &other)
-	{}
-
-	using value_type = T;
-	using size_type = std::size_t;
-
-	T *allocate(size_type n)
-	{
-		return (T *)allocateMemoryPages(
-		    sizeof(T) * n, PERMISSION_READ | PERMISSION_WRITE, true);
-	}
-
-	void deallocate(T *p, size_type n)
-	{
-		deallocateMemoryPages(p, sizeof(T) * n);
-	}
-};
-
 class ELFMemoryStreamer : public Ice::ELFStreamer, public Routine
 {
 	ELFMemoryStreamer(const ELFMemoryStreamer &) = delete;
@@ -507,6 +514,7 @@ public:
 
 	~ELFMemoryStreamer() override
 	{
+		deallocateCodeMemory(code);
 	}
 
 	void write8(uint8_t Value) override
@@ -541,18 +549,32 @@ public:
 	{
 		position = std::numeric_limits<std::size_t>::max();  // Can't stream more data after this
 
-		size_t codeSize = 0;
-		const void *entry = loadImage(&buffer[0], codeSize);
+		// Only the loaded sections are copied to code memory, shared with other
+		// routines. They keep their offsets modulo the alignment of the latter.
+		size_t begin = 0;
+		size_t end = 0;
+		loadedRange(&buffer[0], begin, end);
+		begin &= ~(CodeMemoryAlignment - 1);
+
+		code = allocateCodeMemory(end - begin);
+		ASSERT(code.writable);
+
+		const void *entry = loadImage(&buffer[0], (intptr_t)code.executable - begin);
+
+		memcpy(code.writable, &buffer[begin], end - begin);
+		finalizeCodeMemory(code);
+
+		// The routine lives on in code memory, so the ELF image is no longer needed.
+		std::vector<uint8_t>().swap(buffer);
 
-		protectMemoryPages(&buffer[0], buffer.size(), PERMISSION_READ | PERMISSION_EXECUTE);
-#if defined(_WIN32)
-		FlushInstructionCache(GetCurrentProcess(), NULL, 0);
-#else
-		__builtin___clear_cache((char *)entry, (char *)entry + codeSize);
-#endif
 		return entry;
 	}
 
+	size_t getCodeSize() const
+	{
+		return code.bytes;
+	}
+
 	void setEntry(int index, const void *func)
 	{
 		ASSERT(func);
@@ -576,15 +598,14 @@ public:
 
 private:
 	std::array<const void *, Nucleus::CoroutineEntryCount> funcs = {};
-	std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
+	std::vector<uint8_t> buffer;  // ELF image
+	CodeMemory code;
 	std::size_t position;
 	std::vector<std::unique_ptr<uint8_t[]>> constantData;
 };
 
-Nucleus::Nucleus()
+static void initializeFlags()
 {
-	::codegenMutex.lock();  // Reactor is currently not thread safe
-
 	Ice::ClFlags &Flags = Ice::ClFlags::Flags;
 	Ice::ClFlags::getParsedClFlags(Flags);
 
@@ -599,19 +620,32 @@ Nucleus::Nucleus()
 	Flags.setTargetInstructionSet(CPUID::SSE4_1 ? Ice::X86InstructionSet_SSE4_1 : Ice::X86InstructionSet_SSE2);
 #endif
 	Flags.setOutFileType(Ice::FT_Elf);
-	Flags.setOptLevel(toIce(getDefaultConfig().getOptimization().getLevel()));
 	Flags.setApplicationBinaryInterface(Ice::ABI_Platform);
 	Flags.setVerbose(subzeroDumpEnabled ? Ice::IceV_Most : Ice::IceV_None);
 	Flags.setDisableHybridAssembly(true);
 
-	static llvm::raw_os_ostream cout(std::cout);
-	static llvm::raw_os_ostream cerr(std::cerr);
-
 	if(subzeroEmitTextAsm)
 	{
 		// Decorate text asm with liveness info
 		Flags.setDecorateAsm(true);
 	}
+}
+
+Nucleus::Nucleus()
+{
+	ASSERT(::context == nullptr);
+
+	static llvm::raw_os_ostream cout(std::cout);
+	static llvm::raw_os_ostream cerr(std::cerr);
+
+	std::unique_lock<std::mutex> lock(::contextInitLock);
+
+	static bool flagsInitialized = false;
+	if(!flagsInitialized)
+	{
+		initializeFlags();
+		flagsInitialized = true;
+	}
 
 	if(false)  // Write out to a file
 	{
@@ -639,7 +673,13 @@ Nucleus::~Nucleus()
 	delete ::elfFile;
 	delete ::out;
 
-	::codegenMutex.unlock();
+	::routine = nullptr;
+	::allocator = nullptr;
+	::function = nullptr;
+	::basicBlock = nullptr;
+	::context = nullptr;
+	::elfFile = nullptr;
+	::out = nullptr;
 }
 
 void Nucleus::setDefaultConfig(const Config &cfg)
@@ -663,6 +703,8 @@ Config Nucleus::getDefaultConfig()
 
 std::shared_ptr<Routine> Nucleus::acquireRoutine(const char *name, const Config::Edit &cfgEdit /* = Config::Edit::None */)
 {
+	auto start = std::chrono::steady_clock::now();
+
 	if(subzeroDumpEnabled)
 	{
 		// Output dump strings immediately, rather than once buffer is full. Useful for debugging.
@@ -681,6 +723,11 @@ std::shared_ptr<Routine> Nucleus::acquireRoutine(const char *name, const Config:
 	::function->computeInOutEdges();
 	ASSERT(!::function->hasError());
 
+	// The optimization level is set per function rather than through the
+	// process-wide flags, as routines may be translated concurrently.
+	auto cfg = cfgEdit.apply(getDefaultConfig());
+	::function->setOptLevel(toIce(cfg.getOptimization().getLevel()));
+
 	::function->translate();
 	ASSERT(!::function->hasError());
 
@@ -712,6 +759,9 @@ std::shared_ptr<Routine> Nucleus::acquireRoutine(const char *name, const Config:
 	const void *entryBegin = ::routine->finalizeEntryBegin();
 	::routine->setEntry(Nucleus::CoroutineEntryBegin, entryBegin);
 
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	recordCompile(name, elapsed.count(), ::routine->getCodeSize());
+
 	Routine *handoffRoutine = ::routine;
 	::routine = nullptr;
 
@@ -27,6 +27,15 @@
 #	include <sys/types.h>
 #endif
 
+#if defined(__linux__)
+#	include <dirent.h>
+#	include <algorithm>
+#	include <cstdio>
+#	include <cstring>
+#	include <utility>
+#	include <vector>
+#endif
+
 namespace sw {
 
 bool CPUID::MMX = detectMMX();
@@ -287,6 +296,78 @@ int CPUID::detectAffinity()
 	return cores;
 }
 
+#if defined(__linux__)
+// Returns the NUMA node of a CPU, or 0 if unknown.
+static int cpuNode(int cpu)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+
+	int node = 0;
+	if(DIR *dir = opendir(path))
+	{
+		while(dirent *entry = readdir(dir))
+		{
+			if(sscanf(entry->d_name, "node%d", &node) == 1)
+			{
+				break;
+			}
+		}
+
+		closedir(dir);
+	}
+
+	return node;
+}
+
+// Returns the CPUs of the process's affinity mask, ordered by NUMA node.
+static std::vector<int> nodeOrderedCPUs()
+{
+	std::vector<std::pair<int, int>> cpus;  // Node, CPU
+
+	cpu_set_t set;
+	if(sched_getaffinity(0, sizeof(set), &set) == 0)
+	{
+		for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if(CPU_ISSET(cpu, &set))
+			{
+				cpus.push_back({ cpuNode(cpu), cpu });
+			}
+		}
+	}
+
+	std::stable_sort(cpus.begin(), cpus.end());
+
+	std::vector<int> ordered;
+	for(auto &cpu : cpus)
+	{
+		ordered.push_back(cpu.second);
+	}
+
+	return ordered;
+}
+#endif
+
+void CPUID::pinCurrentThread(int index)
+{
+#if defined(__linux__)
+	// Computed on first use, before any thread is pinned, so it reflects the
+	// affinity of the process rather than of a pinned thread.
+	static const std::vector<int> cpus = nodeOrderedCPUs();
+
+	if(cpus.empty())
+	{
+		return;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpus[index % cpus.size()], &set);
+	sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
 void CPUID::setFlushToZero(bool enable)
 {
 #if defined(_MSC_VER)
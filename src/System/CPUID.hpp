@@ -50,6 +50,11 @@ public:
 	static void setFlushToZero(bool enable);       // Denormal results are written as zero
 	static void setDenormalsAreZero(bool enable);  // Denormal inputs are read as zero
 
+	// Pins the calling thread to one of the CPUs the process may run on. CPUs
+	// are ordered by NUMA node, so consecutive indices share a node when
+	// possible. Only implemented on Linux.
+	static void pinCurrentThread(int index);
+
 private:
 	static bool MMX;
 	static bool CMOV;
@@ -50,6 +50,7 @@ struct Allocation
 	unsigned char *block;
 };
 
+// Returns zero-initialized memory.
 void *allocateRaw(size_t bytes, size_t alignment)
 {
 	ASSERT((alignment & (alignment - 1)) == 0);  // Power of 2 alignment.
@@ -57,7 +58,7 @@ void *allocateRaw(size_t bytes, size_t alignment)
 #if defined(LINUX_ENABLE_NAMED_MMAP)
 	if(alignment < sizeof(void *))
 	{
-		return malloc(bytes);
+		return calloc(1, bytes);
 	}
 	else
 	{
@@ -68,10 +69,18 @@ void *allocateRaw(size_t bytes, size_t alignment)
 			errno = result;
 			allocation = nullptr;
 		}
+		else
+		{
+			memset(allocation, 0, bytes);
+		}
 		return allocation;
 	}
 #else
-	unsigned char *block = (unsigned char *)malloc(bytes + sizeof(Allocation) + alignment);
+	// Unlike malloc() and memset(), calloc() leaves the pages of large blocks
+	// untouched, as the system provides them zeroed. They then get placed on
+	// the NUMA node of the thread which first writes them, e.g. the worker
+	// threads rendering into an image, instead of the allocating thread's.
+	unsigned char *block = (unsigned char *)calloc(1, bytes + sizeof(Allocation) + alignment);
 	unsigned char *aligned = nullptr;
 
 	if(block)
@@ -109,14 +118,7 @@ size_t memoryPageSize()
 
 void *allocate(size_t bytes, size_t alignment)
 {
-	void *memory = allocateRaw(bytes, alignment);
-
-	if(memory)
-	{
-		memset(memory, 0, bytes);
-	}
-
-	return memory;
+	return allocateRaw(bytes, alignment);
 }
 
 void deallocate(void *memory)
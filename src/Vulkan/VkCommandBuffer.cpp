@@ -14,6 +14,7 @@
 
 #include "VkCommandBuffer.hpp"
 #include "VkBuffer.hpp"
+#include "VkCommandPool.hpp"
 #include "VkEvent.hpp"
 #include "VkFence.hpp"
 #include "VkFramebuffer.hpp"
@@ -31,15 +32,71 @@
 
 #include "marl/defer.h"
 
+#include <algorithm>
 #include <cstring>
-
+#include <type_traits>
+
+// All command classes, named Cmd<Type>.
+#define COMMAND_TYPES(X)      \
+	X(BeginRenderPass)        \
+	X(NextSubpass)            \
+	X(EndRenderPass)          \
+	X(ExecuteCommands)        \
+	X(PipelineBind)           \
+	X(Dispatch)               \
+	X(DispatchIndirect)       \
+	X(VertexBufferBind)       \
+	X(IndexBufferBind)        \
+	X(SetViewport)            \
+	X(SetScissor)             \
+	X(SetDepthBias)           \
+	X(SetBlendConstants)      \
+	X(SetDepthBounds)         \
+	X(SetStencilCompareMask)  \
+	X(SetStencilWriteMask)    \
+	X(SetStencilReference)    \
+	X(Draw)                   \
+	X(DrawIndexed)            \
+	X(DrawIndirect)           \
+	X(DrawIndexedIndirect)    \
+	X(ImageToImageCopy)       \
+	X(BufferToBufferCopy)     \
+	X(ImageToBufferCopy)      \
+	X(BufferToImageCopy)      \
+	X(FillBuffer)             \
+	X(UpdateBuffer)           \
+	X(ClearColorImage)        \
+	X(ClearDepthStencilImage) \
+	X(ClearAttachment)        \
+	X(BlitImage)              \
+	X(ResolveImage)           \
+	X(PipelineBarrier)        \
+	X(SignalEvent)            \
+	X(ResetEvent)             \
+	X(WaitEvent)              \
+	X(BindDescriptorSet)      \
+	X(SetPushConstants)       \
+	X(BeginQuery)             \
+	X(EndQuery)               \
+	X(ResetQueryPool)         \
+	X(WriteTimeStamp)         \
+	X(CopyQueryPoolResults)
+
+// Commands are recorded into memory blocks owned by the command pool, as a
+// singly linked list of tagged records. They are replayed by switching on the
+// tag, rather than through virtual calls, and are never destroyed individually.
 class vk::CommandBuffer::Command
 {
 public:
-	// FIXME (b/119421344): change the commandBuffer argument to a CommandBuffer state
-	virtual void play(vk::CommandBuffer::ExecutionState &executionState) = 0;
-	virtual std::string description() = 0;
-	virtual ~Command() {}
+	enum Type : uint32_t
+	{
+#define COMMAND_TYPE(name) name,
+		COMMAND_TYPES(COMMAND_TYPE)
+#undef COMMAND_TYPE
+	};
+
+	Type type;
+	Command *next = nullptr;
 };
 
 namespace {
@@ -53,18 +110,11 @@ public:
 	    , framebuffer(framebuffer)
 	    , renderArea(renderArea)
 	    , clearValueCount(clearValueCount)
+	    , clearValues(pClearValues)
 	{
-		// FIXME (b/119409619): use an allocator here so we can control all memory allocations
-		clearValues = new VkClearValue[clearValueCount];
-		memcpy(clearValues, pClearValues, clearValueCount * sizeof(VkClearValue));
-	}
-
-	~CmdBeginRenderPass() override
-	{
-		delete[] clearValues;
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.renderPass = renderPass;
 		executionState.renderPassFramebuffer = framebuffer;
@@ -72,20 +122,20 @@ public:
 		framebuffer->clear(executionState.renderPass, clearValueCount, clearValues, renderArea);
 	}
 
-	std::string description() override { return "vkCmdBeginRenderPass()"; }
+	std::string description() { return "vkCmdBeginRenderPass()"; }
 
 private:
 	vk::RenderPass *renderPass;
 	vk::Framebuffer *framebuffer;
 	VkRect2D renderArea;
 	uint32_t clearValueCount;
-	VkClearValue *clearValues;
+	const VkClearValue *clearValues;  // Stored in the command stream
 };
 
 class CmdNextSubpass : public vk::CommandBuffer::Command
 {
 public:
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		bool hasResolveAttachments = (executionState.renderPass->getSubpass(executionState.subpassIndex).pResolveAttachments != nullptr);
 		if(hasResolveAttachments)
@@ -98,15 +148,24 @@ public:
 		}
 
 		++executionState.subpassIndex;
+
+		// Input attachments are read through descriptors, which don't know about
+		// deferred clears.
+		bool hasInputAttachments = (executionState.renderPass->getSubpass(executionState.subpassIndex).inputAttachmentCount > 0);
+		if(hasInputAttachments && executionState.renderPassFramebuffer->hasDeferredClears())
+		{
+			executionState.renderer->synchronize();
+			executionState.renderPassFramebuffer->resolveDeferredClears();
+		}
 	}
 
-	std::string description() override { return "vkCmdNextSubpass()"; }
+	std::string description() { return "vkCmdNextSubpass()"; }
 };
 
 class CmdEndRenderPass : public vk::CommandBuffer::Command
 {
 public:
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		// Execute (implicit or explicit) VkSubpassDependency to VK_SUBPASS_EXTERNAL
 		// This is somewhat heavier than the actual ordering required.
@@ -116,11 +175,12 @@ public:
 		//               for a Draw command or after the last command of the current subpass
 		//               which modifies pixels.
 		executionState.renderPassFramebuffer->resolve(executionState.renderPass, executionState.subpassIndex);
+		executionState.renderPassFramebuffer->finishDeferredClears(executionState.renderPass);
 		executionState.renderPass = nullptr;
 		executionState.renderPassFramebuffer = nullptr;
 	}
 
-	std::string description() override { return "vkCmdEndRenderPass()"; }
+	std::string description() { return "vkCmdEndRenderPass()"; }
 };
 
 class CmdExecuteCommands : public vk::CommandBuffer::Command
@@ -131,12 +191,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		commandBuffer->submitSecondary(executionState);
 	}
 
-	std::string description() override { return "vkCmdExecuteCommands()"; }
+	std::string description() { return "vkCmdExecuteCommands()"; }
 
 private:
 	const vk::CommandBuffer *commandBuffer;
@@ -151,12 +211,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.pipelineState[pipelineBindPoint].pipeline = pipeline;
 	}
 
-	std::string description() override { return "vkCmdPipelineBind()"; }
+	std::string description() { return "vkCmdPipelineBind()"; }
 
 private:
 	VkPipelineBindPoint pipelineBindPoint;
@@ -176,7 +236,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		auto const &pipelineState = executionState.pipelineState[VK_PIPELINE_BIND_POINT_COMPUTE];
 
@@ -185,10 +245,11 @@ public:
 		              groupCountX, groupCountY, groupCountZ,
 		              pipelineState.descriptorSets,
 		              pipelineState.descriptorDynamicOffsets,
-		              executionState.pushConstants);
+		              executionState.pushConstants,
+		              executionState.renderer->getTicketQueue());
 	}
 
-	std::string description() override { return "vkCmdDispatch()"; }
+	std::string description() { return "vkCmdDispatch()"; }
 
 private:
 	uint32_t baseGroupX;
@@ -208,7 +269,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		auto cmd = reinterpret_cast<VkDispatchIndirectCommand const *>(buffer->getOffsetPointer(offset));
 
@@ -218,10 +279,11 @@ public:
 		pipeline->run(0, 0, 0, cmd->x, cmd->y, cmd->z,
 		              pipelineState.descriptorSets,
 		              pipelineState.descriptorDynamicOffsets,
-		              executionState.pushConstants);
+		              executionState.pushConstants,
+		              executionState.renderer->getTicketQueue());
 	}
 
-	std::string description() override { return "vkCmdDispatchIndirect()"; }
+	std::string description() { return "vkCmdDispatchIndirect()"; }
 
 private:
 	const vk::Buffer *buffer;
@@ -238,12 +300,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.vertexInputBindings[binding] = { buffer, offset };
 	}
 
-	std::string description() override { return "vkCmdVertexBufferBind()"; }
+	std::string description() { return "vkCmdVertexBufferBind()"; }
 
 private:
 	uint32_t binding;
@@ -261,13 +323,13 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.indexBufferBinding = { buffer, offset };
 		executionState.indexType = indexType;
 	}
 
-	std::string description() override { return "vkCmdIndexBufferBind()"; }
+	std::string description() { return "vkCmdIndexBufferBind()"; }
 
 private:
 	vk::Buffer *buffer;
@@ -284,12 +346,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.dynamicState.viewport = viewport;
 	}
 
-	std::string description() override { return "vkCmdSetViewport()"; }
+	std::string description() { return "vkCmdSetViewport()"; }
 
 private:
 	const VkViewport viewport;
@@ -305,12 +367,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.dynamicState.scissor = scissor;
 	}
 
-	std::string description() override { return "vkCmdSetScissor()"; }
+	std::string description() { return "vkCmdSetScissor()"; }
 
 private:
 	const VkRect2D scissor;
@@ -327,14 +389,14 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.dynamicState.depthBiasConstantFactor = depthBiasConstantFactor;
 		executionState.dynamicState.depthBiasClamp = depthBiasClamp;
 		executionState.dynamicState.depthBiasSlopeFactor = depthBiasSlopeFactor;
 	}
 
-	std::string description() override { return "vkCmdSetDepthBias()"; }
+	std::string description() { return "vkCmdSetDepthBias()"; }
 
 private:
 	float depthBiasConstantFactor;
@@ -350,12 +412,12 @@ public:
 		memcpy(this->blendConstants, blendConstants, sizeof(this->blendConstants));
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		memcpy(&(executionState.dynamicState.blendConstants[0]), blendConstants, sizeof(blendConstants));
 	}
 
-	std::string description() override { return "vkCmdSetBlendConstants()"; }
+	std::string description() { return "vkCmdSetBlendConstants()"; }
 
 private:
 	float blendConstants[4];
@@ -370,13 +432,13 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.dynamicState.minDepthBounds = minDepthBounds;
 		executionState.dynamicState.maxDepthBounds = maxDepthBounds;
 	}
 
-	std::string description() override { return "vkCmdSetDepthBounds()"; }
+	std::string description() { return "vkCmdSetDepthBounds()"; }
 
 private:
 	float minDepthBounds;
@@ -392,7 +454,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		if(faceMask & VK_STENCIL_FACE_FRONT_BIT)
 		{
@@ -404,7 +466,7 @@ public:
 		}
 	}
 
-	std::string description() override { return "vkCmdSetStencilCompareMask()"; }
+	std::string description() { return "vkCmdSetStencilCompareMask()"; }
 
 private:
 	VkStencilFaceFlags faceMask;
@@ -420,7 +482,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		if(faceMask & VK_STENCIL_FACE_FRONT_BIT)
 		{
@@ -432,7 +494,7 @@ public:
 		}
 	}
 
-	std::string description() override { return "vkCmdSetStencilWriteMask()"; }
+	std::string description() { return "vkCmdSetStencilWriteMask()"; }
 
 private:
 	VkStencilFaceFlags faceMask;
@@ -448,7 +510,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		if(faceMask & VK_STENCIL_FACE_FRONT_BIT)
 		{
@@ -460,7 +522,7 @@ public:
 		}
 	}
 
-	std::string description() override { return "vkCmdSetStencilReference()"; }
+	std::string description() { return "vkCmdSetStencilReference()"; }
 
 private:
 	VkStencilFaceFlags faceMask;
@@ -640,12 +702,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		draw(executionState, false, vertexCount, instanceCount, 0, firstVertex, firstInstance);
 	}
 
-	std::string description() override { return "vkCmdDraw()"; }
+	std::string description() { return "vkCmdDraw()"; }
 
 private:
 	uint32_t vertexCount;
@@ -666,12 +728,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		draw(executionState, true, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 	}
 
-	std::string description() override { return "vkCmdDrawIndexed()"; }
+	std::string description() { return "vkCmdDrawIndexed()"; }
 
 private:
 	uint32_t indexCount;
@@ -692,7 +754,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		for(auto drawId = 0u; drawId < drawCount; drawId++)
 		{
@@ -701,7 +763,7 @@ public:
 		}
 	}
 
-	std::string description() override { return "vkCmdDrawIndirect()"; }
+	std::string description() { return "vkCmdDrawIndirect()"; }
 
 private:
 	const vk::Buffer *buffer;
@@ -721,7 +783,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		for(auto drawId = 0u; drawId < drawCount; drawId++)
 		{
@@ -730,7 +792,7 @@ public:
 		}
 	}
 
-	std::string description() override { return "vkCmdDrawIndexedIndirect()"; }
+	std::string description() { return "vkCmdDrawIndexedIndirect()"; }
 
 private:
 	const vk::Buffer *buffer;
@@ -749,12 +811,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		srcImage->copyTo(dstImage, region);
 	}
 
-	std::string description() override { return "vkCmdImageToImageCopy()"; }
+	std::string description() { return "vkCmdImageToImageCopy()"; }
 
 private:
 	const vk::Image *srcImage;
@@ -772,12 +834,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		srcBuffer->copyTo(dstBuffer, region);
 	}
 
-	std::string description() override { return "vkCmdBufferToBufferCopy()"; }
+	std::string description() { return "vkCmdBufferToBufferCopy()"; }
 
 private:
 	const vk::Buffer *srcBuffer;
@@ -795,12 +857,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		srcImage->copyTo(dstBuffer, region);
 	}
 
-	std::string description() override { return "vkCmdImageToBufferCopy()"; }
+	std::string description() { return "vkCmdImageToBufferCopy()"; }
 
 private:
 	vk::Image *srcImage;
@@ -818,12 +880,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		dstImage->copyFrom(srcBuffer, region);
 	}
 
-	std::string description() override { return "vkCmdBufferToImageCopy()"; }
+	std::string description() { return "vkCmdBufferToImageCopy()"; }
 
 private:
 	vk::Buffer *srcBuffer;
@@ -842,12 +904,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		dstBuffer->fill(dstOffset, size, data);
 	}
 
-	std::string description() override { return "vkCmdFillBuffer()"; }
+	std::string description() { return "vkCmdFillBuffer()"; }
 
 private:
 	vk::Buffer *dstBuffer;
@@ -862,21 +924,23 @@ public:
 	CmdUpdateBuffer(vk::Buffer *dstBuffer, VkDeviceSize dstOffset, VkDeviceSize dataSize, const uint8_t *pData)
 	    : dstBuffer(dstBuffer)
 	    , dstOffset(dstOffset)
-	    , data(pData, &pData[dataSize])
+	    , dataSize(dataSize)
+	    , data(pData)
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
-		dstBuffer->update(dstOffset, data.size(), data.data());
+		dstBuffer->update(dstOffset, dataSize, data);
 	}
 
-	std::string description() override { return "vkCmdUpdateBuffer()"; }
+	std::string description() { return "vkCmdUpdateBuffer()"; }
 
 private:
 	vk::Buffer *dstBuffer;
 	VkDeviceSize dstOffset;
-	std::vector<uint8_t> data;  // FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
+	VkDeviceSize dataSize;
+	const uint8_t *data;  // Stored in the command stream
 };
 
 class CmdClearColorImage : public vk::CommandBuffer::Command
@@ -889,12 +953,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		image->clear(color, range);
 	}
 
-	std::string description() override { return "vkCmdClearColorImage()"; }
+	std::string description() { return "vkCmdClearColorImage()"; }
 
 private:
 	vk::Image *image;
@@ -912,12 +976,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		image->clear(depthStencil, range);
 	}
 
-	std::string description() override { return "vkCmdClearDepthStencilImage()"; }
+	std::string description() { return "vkCmdClearDepthStencilImage()"; }
 
 private:
 	vk::Image *image;
@@ -934,7 +998,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		// attachment clears are drawing operations, and so have rasterization-order guarantees.
 		// however, we don't do the clear through the rasterizer, so need to ensure prior drawing
@@ -943,7 +1007,7 @@ public:
 		executionState.renderPassFramebuffer->clearAttachment(executionState.renderPass, executionState.subpassIndex, attachment, rect);
 	}
 
-	std::string description() override { return "vkCmdClearAttachment()"; }
+	std::string description() { return "vkCmdClearAttachment()"; }
 
 private:
 	const VkClearAttachment attachment;
@@ -961,12 +1025,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		srcImage->blit(dstImage, region, filter);
 	}
 
-	std::string description() override { return "vkCmdBlitImage()"; }
+	std::string description() { return "vkCmdBlitImage()"; }
 
 private:
 	const vk::Image *srcImage;
@@ -985,12 +1049,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		srcImage->resolve(dstImage, region);
 	}
 
-	std::string description() override { return "vkCmdBlitImage()"; }
+	std::string description() { return "vkCmdBlitImage()"; }
 
 private:
 	const vk::Image *srcImage;
@@ -998,22 +1062,78 @@ private:
 	VkImageResolve region;
 };
 
+// Pipeline stages of the work which is complete by the time its command has
+// been played: transfers run on the queue thread, and indirect draw and
+// dispatch parameters are read when the command is played. All other stages,
+// including any unknown to this implementation, are treated as being executed
+// asynchronously by the renderer's draw calls or by compute dispatches.
+constexpr VkPipelineStageFlags SynchronousStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT |
+                                                   VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                                                   VK_PIPELINE_STAGE_TRANSFER_BIT |
+                                                   VK_PIPELINE_STAGE_HOST_BIT;
+
+// Pipeline stages which, within a subpass, only access the framebuffer region
+// of the pixel being processed. Pixel processing of consecutive draws is
+// ordered per rasterizer cluster, and a pixel is always processed by the same
+// cluster, so by-region dependencies between these stages are implicit.
+constexpr VkPipelineStageFlags FramebufferSpaceStages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                                        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                                                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+// Returns whether an execution dependency requires the in-flight draw calls
+// and compute dispatches to be complete.
+bool DependsOnAsyncWork(const vk::CommandBuffer::ExecutionState &executionState, VkPipelineStageFlags srcStageMask,
+                        VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags)
+{
+	if((srcStageMask & ~SynchronousStages) == 0)
+	{
+		return false;
+	}
+
+	if(executionState.renderPass &&
+	   (dependencyFlags & VK_DEPENDENCY_BY_REGION_BIT) &&
+	   ((srcStageMask & ~FramebufferSpaceStages) == 0) &&
+	   ((dstStageMask & ~FramebufferSpaceStages) == 0))
+	{
+		return false;
+	}
+
+	return true;
+}
+
 class CmdPipelineBarrier : public vk::CommandBuffer::Command
 {
 public:
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	CmdPipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags)
+	    : srcStageMask(srcStageMask)
+	    , dstStageMask(dstStageMask)
+	    , dependencyFlags(dependencyFlags)
 	{
-		// This is a very simple implementation that simply calls sw::Renderer::synchronize(),
-		// since the driver is free to move the source stage towards the bottom of the pipe
-		// and the target stage towards the top, so a full pipeline sync is spec compliant.
-		executionState.renderer->synchronize();
+	}
 
-		// Right now all buffers are read-only in drawcalls but a similar mechanism will be required once we support SSBOs.
+	void play(vk::CommandBuffer::ExecutionState &executionState)
+	{
+		// Only draw calls and compute dispatches execute asynchronously, so this
+		// barrier only has to wait for them when its first synchronization scope
+		// includes their stages. The driver is free to move the source stage
+		// towards the bottom of the pipe and the target stage towards the top, so
+		// waiting for all in-flight work, rather than for specific stages or
+		// resources, is spec compliant.
+		if(DependsOnAsyncWork(executionState, srcStageMask, dstStageMask, dependencyFlags))
+		{
+			executionState.renderer->synchronize();
+		}
 
 		// Also note that this would be a good moment to update cube map borders or decompress compressed textures, if necessary.
 	}
 
-	std::string description() override { return "vkCmdPipelineBarrier()"; }
+	std::string description() { return "vkCmdPipelineBarrier()"; }
+
+private:
+	VkPipelineStageFlags srcStageMask;
+	VkPipelineStageFlags dstStageMask;
+	VkDependencyFlags dependencyFlags;
 };
 
 class CmdSignalEvent : public vk::CommandBuffer::Command
@@ -1025,17 +1145,21 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
-		executionState.renderer->synchronize();
+		if((stageMask & ~SynchronousStages) != 0)
+		{
+			executionState.renderer->synchronize();
+		}
+
 		ev->signal();
 	}
 
-	std::string description() override { return "vkCmdSignalEvent()"; }
+	std::string description() { return "vkCmdSignalEvent()"; }
 
 private:
 	vk::Event *ev;
-	VkPipelineStageFlags stageMask;  // FIXME(b/117835459) : We currently ignore the flags and signal the event at the last stage
+	VkPipelineStageFlags stageMask;  // FIXME(b/117835459) : Draw stages are signaled once all in-flight draws have completed
 };
 
 class CmdResetEvent : public vk::CommandBuffer::Command
@@ -1047,12 +1171,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		ev->reset();
 	}
 
-	std::string description() override { return "vkCmdResetEvent()"; }
+	std::string description() { return "vkCmdResetEvent()"; }
 
 private:
 	vk::Event *ev;
@@ -1067,13 +1191,13 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.renderer->synchronize();
 		ev->wait();
 	}
 
-	std::string description() override { return "vkCmdWaitEvent()"; }
+	std::string description() { return "vkCmdWaitEvent()"; }
 
 private:
 	vk::Event *ev;
@@ -1096,7 +1220,7 @@ public:
 		}
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		ASSERT_OR_RETURN((pipelineBindPoint < VK_PIPELINE_BIND_POINT_RANGE_SIZE) && (set < vk::MAX_BOUND_DESCRIPTOR_SETS));
 		auto &pipelineState = executionState.pipelineState[pipelineBindPoint];
@@ -1110,7 +1234,7 @@ public:
 		}
 	}
 
-	std::string description() override { return "vkCmdBindDescriptorSet()"; }
+	std::string description() { return "vkCmdBindDescriptorSet()"; }
 
 private:
 	VkPipelineBindPoint pipelineBindPoint;
@@ -1134,12 +1258,12 @@ public:
 		memcpy(data, pValues, size);
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		memcpy(&executionState.pushConstants.data[offset], data, size);
 	}
 
-	std::string description() override { return "vkCmdSetPushConstants()"; }
+	std::string description() { return "vkCmdSetPushConstants()"; }
 
 private:
 	uint32_t offset;
@@ -1157,13 +1281,13 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		queryPool->begin(query, flags);
 		executionState.renderer->addQuery(queryPool->getQuery(query));
 	}
 
-	std::string description() override { return "vkCmdBeginQuery()"; }
+	std::string description() { return "vkCmdBeginQuery()"; }
 
 private:
 	vk::QueryPool *queryPool;
@@ -1180,13 +1304,13 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		executionState.renderer->removeQuery(queryPool->getQuery(query));
 		queryPool->end(query);
 	}
 
-	std::string description() override { return "vkCmdEndQuery()"; }
+	std::string description() { return "vkCmdEndQuery()"; }
 
 private:
 	vk::QueryPool *queryPool;
@@ -1203,12 +1327,12 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		queryPool->reset(firstQuery, queryCount);
 	}
 
-	std::string description() override { return "vkCmdResetQueryPool()"; }
+	std::string description() { return "vkCmdResetQueryPool()"; }
 
 private:
 	vk::QueryPool *queryPool;
@@ -1226,7 +1350,7 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		if(stage & ~(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT))
 		{
@@ -1242,7 +1366,7 @@ public:
 		queryPool->writeTimestamp(query);
 	}
 
-	std::string description() override { return "vkCmdWriteTimeStamp()"; }
+	std::string description() { return "vkCmdWriteTimeStamp()"; }
 
 private:
 	vk::QueryPool *queryPool;
@@ -1265,13 +1389,13 @@ public:
 	{
 	}
 
-	void play(vk::CommandBuffer::ExecutionState &executionState) override
+	void play(vk::CommandBuffer::ExecutionState &executionState)
 	{
 		queryPool->getResults(firstQuery, queryCount, dstBuffer->getSize() - dstOffset,
 		                      dstBuffer->getOffsetPointer(dstOffset), stride, flags);
 	}
 
-	std::string description() override { return "vkCmdCopyQueryPoolResults()"; }
+	std::string description() { return "vkCmdCopyQueryPoolResults()"; }
 
 private:
 	const vk::QueryPool *queryPool;
@@ -1283,31 +1407,123 @@ private:
 	VkQueryResultFlags flags;
 };
 
+template<typename T>
+struct CommandTypeOf;
+
+#define COMMAND_TYPE_OF(name)                                                                       \
+	template<>                                                                                      \
+	struct CommandTypeOf<Cmd##name>                                                                 \
+	{                                                                                               \
+		static constexpr vk::CommandBuffer::Command::Type value = vk::CommandBuffer::Command::name; \
+	};
+COMMAND_TYPES(COMMAND_TYPE_OF)
+#undef COMMAND_TYPE_OF
+
+void Play(vk::CommandBuffer::Command *command, vk::CommandBuffer::ExecutionState &executionState)
+{
+	switch(command->type)
+	{
+#define PLAY_COMMAND(name)                                       \
+	case vk::CommandBuffer::Command::name:                       \
+		static_cast<Cmd##name *>(command)->play(executionState); \
+		break;
+		COMMAND_TYPES(PLAY_COMMAND)
+#undef PLAY_COMMAND
+		default:
+			UNREACHABLE("Command type %d", int(command->type));
+	}
+}
+
+#ifdef ENABLE_VK_DEBUGGER
+std::string Describe(vk::CommandBuffer::Command *command)
+{
+	switch(command->type)
+	{
+#define DESCRIBE_COMMAND(name)             \
+	case vk::CommandBuffer::Command::name: \
+		return static_cast<Cmd##name *>(command)->description();
+		COMMAND_TYPES(DESCRIBE_COMMAND)
+#undef DESCRIBE_COMMAND
+		default:
+			UNREACHABLE("Command type %d", int(command->type));
+			return "";
+	}
+}
+#endif  // ENABLE_VK_DEBUGGER
+
 }  // anonymous namespace
 
 namespace vk {
 
-CommandBuffer::CommandBuffer(Device *device, VkCommandBufferLevel pLevel)
+CommandBuffer::CommandBuffer(Device *device, VkCommandBufferLevel pLevel, CommandPool *pool)
     : device(device)
+    , pool(pool)
     , level(pLevel)
 {
-	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
-	commands = new std::vector<std::unique_ptr<Command>>();
 }
 
 void CommandBuffer::destroy(const VkAllocationCallbacks *pAllocator)
 {
-	delete commands;
+	releaseCommandBlocks();
 }
 
 void CommandBuffer::resetState()
 {
-	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
-	commands->clear();
+	releaseCommandBlocks();
 
 	state = INITIAL;
 }
 
+void CommandBuffer::releaseCommandBlocks()
+{
+	for(auto &block : commandBlocks)
+	{
+		pool->releaseCommandBlock(block.first, block.second);
+	}
+
+	commandBlocks.clear();
+	blockCursor = nullptr;
+	blockEnd = nullptr;
+
+	firstCommand = nullptr;
+	lastCommand = nullptr;
+}
+
+void *CommandBuffer::allocate(size_t size)
+{
+	size = (size + REQUIRED_MEMORY_ALIGNMENT - 1) & ~static_cast<size_t>(REQUIRED_MEMORY_ALIGNMENT - 1);
+
+	if(size > static_cast<size_t>(blockEnd - blockCursor))
+	{
+		size_t blockSize = std::max(size, CommandPool::CommandBlockSize);
+		uint8_t *block = reinterpret_cast<uint8_t *>(pool->allocateCommandBlock(blockSize));
+		ASSERT(block);
+
+		commandBlocks.push_back({ block, blockSize });
+		blockCursor = block;
+		blockEnd = block + blockSize;
+	}
+
+	void *memory = blockCursor;
+	blockCursor += size;
+
+	return memory;
+}
+
+template<typename T>
+const T *CommandBuffer::copyToStream(const T *data, size_t count)
+{
+	if(count == 0)
+	{
+		return nullptr;
+	}
+
+	T *copy = reinterpret_cast<T *>(allocate(count * sizeof(T)));
+	memcpy(copy, data, count * sizeof(T));
+
+	return copy;
+}
+
 VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo *pInheritanceInfo)
 {
 	ASSERT((state != RECORDING) && (state != PENDING));
@@ -1341,9 +1557,9 @@ VkResult CommandBuffer::end()
 	if(debuggerContext)
 	{
 		std::string source;
-		for(auto &command : *commands)
+		for(Command *command = firstCommand; command; command = command->next)
 		{
-			source += command->description() + "\n";
+			source += Describe(command) + "\n";
 		}
 		debuggerFile = debuggerContext->lock().createVirtualFile("VkCommandBuffer", source.c_str());
 	}
@@ -1364,8 +1580,21 @@ VkResult CommandBuffer::reset(VkCommandPoolResetFlags flags)
 template<typename T, typename... Args>
 void CommandBuffer::addCommand(Args &&... args)
 {
-	// FIXME (b/119409619): use an allocator here so we can control all memory allocations
-	commands->push_back(std::make_unique<T>(std::forward<Args>(args)...));
+	static_assert(std::is_trivially_destructible<T>::value, "commands are released along with their memory blocks");
+
+	T *command = new(allocate(sizeof(T))) T(std::forward<Args>(args)...);
+	command->type = CommandTypeOf<T>::value;
+
+	if(lastCommand)
+	{
+		lastCommand->next = command;
+	}
+	else
+	{
+		firstCommand = command;
+	}
+
+	lastCommand = command;
 }
 
 void CommandBuffer::beginRenderPass(RenderPass *renderPass, Framebuffer *framebuffer, VkRect2D renderArea,
@@ -1373,7 +1602,7 @@ void CommandBuffer::beginRenderPass(RenderPass *renderPass, Framebuffer *framebu
 {
 	ASSERT(state == RECORDING);
 
-	addCommand<::CmdBeginRenderPass>(renderPass, framebuffer, renderArea, clearValueCount, clearValues);
+	addCommand<::CmdBeginRenderPass>(renderPass, framebuffer, renderArea, clearValueCount, copyToStream(clearValues, clearValueCount));
 }
 
 void CommandBuffer::nextSubpass(VkSubpassContents contents)
@@ -1415,7 +1644,7 @@ void CommandBuffer::pipelineBarrier(VkPipelineStageFlags srcStageMask, VkPipelin
                                     uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers,
                                     uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
 {
-	addCommand<::CmdPipelineBarrier>();
+	addCommand<::CmdPipelineBarrier>(srcStageMask, dstStageMask, dependencyFlags);
 }
 
 void CommandBuffer::bindPipeline(VkPipelineBindPoint pipelineBindPoint, Pipeline *pipeline)
@@ -1649,7 +1878,7 @@ void CommandBuffer::updateBuffer(Buffer *dstBuffer, VkDeviceSize dstOffset, VkDe
 {
 	ASSERT(state == RECORDING);
 
-	addCommand<::CmdUpdateBuffer>(dstBuffer, dstOffset, dataSize, reinterpret_cast<const uint8_t *>(pData));
+	addCommand<::CmdUpdateBuffer>(dstBuffer, dstOffset, dataSize, copyToStream(reinterpret_cast<const uint8_t *>(pData), dataSize));
 }
 
 void CommandBuffer::fillBuffer(Buffer *dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
@@ -1780,7 +2009,7 @@ void CommandBuffer::submit(CommandBuffer::ExecutionState &executionState)
 	int line = 1;
 #endif  // ENABLE_VK_DEBUGGER
 
-	for(auto &command : *commands)
+	for(Command *command = firstCommand; command; command = command->next)
 	{
 #ifdef ENABLE_VK_DEBUGGER
 		if(debuggerThread)
@@ -1791,7 +2020,7 @@ void CommandBuffer::submit(CommandBuffer::ExecutionState &executionState)
 		}
 #endif  // ENABLE_VK_DEBUGGER
 
-		command->play(executionState);
+		Play(command, executionState);
 	}
 
 	// After work is completed
@@ -1800,9 +2029,9 @@ void CommandBuffer::submit(CommandBuffer::ExecutionState &executionState)
 
 void CommandBuffer::submitSecondary(CommandBuffer::ExecutionState &executionState) const
 {
-	for(auto &command : *commands)
+	for(Command *command = firstCommand; command; command = command->next)
 	{
-		command->play(executionState);
+		Play(command, executionState);
 	}
 }
 
@@ -1839,6 +2068,7 @@ void CommandBuffer::ExecutionState::bindAttachments(sw::Context &context)
 		if(attachmentReference.attachment != VK_ATTACHMENT_UNUSED)
 		{
 			context.renderTarget[i] = renderPassFramebuffer->getAttachment(attachmentReference.attachment);
+			context.renderTargetFormat[i] = context.renderTarget[i]->getFormat();
 		}
 	}
 
@@ -1849,10 +2079,12 @@ void CommandBuffer::ExecutionState::bindAttachments(sw::Context &context)
 		if(attachment->hasDepthAspect())
 		{
 			context.depthBuffer = attachment;
+			context.depthBufferFormat = attachment->getFormat();
 		}
 		if(attachment->hasStencilAspect())
 		{
 			context.stencilBuffer = attachment;
+			context.stencilBufferFormat = attachment->getFormat();
 		}
 	}
 }
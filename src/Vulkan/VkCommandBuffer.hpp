@@ -40,6 +40,7 @@ class File;
 
 class Device;
 class Buffer;
+class CommandPool;
 class Event;
 class Framebuffer;
 class Image;
@@ -53,7 +54,7 @@ class CommandBuffer
 public:
 	static constexpr VkSystemAllocationScope GetAllocationScope() { return VK_SYSTEM_ALLOCATION_SCOPE_OBJECT; }
 
-	CommandBuffer(Device *device, VkCommandBufferLevel pLevel);
+	CommandBuffer(Device *device, VkCommandBufferLevel pLevel, CommandPool *pool);
 
 	static inline CommandBuffer *Cast(VkCommandBuffer object)
 	{
@@ -196,6 +197,10 @@ public:
 
 private:
 	void resetState();
+	void releaseCommandBlocks();
+	void *allocate(size_t size);
+	template<typename T>
+	const T *copyToStream(const T *data, size_t count);
 	template<typename T, typename... Args>
 	void addCommand(Args &&... args);
 
@@ -209,11 +214,17 @@ private:
 	};
 
 	Device *const device;
+	CommandPool *const pool;
 	State state = INITIAL;
 	VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-	// FIXME (b/119409619): replace this vector by an allocator so we can control all memory allocations
-	std::vector<std::unique_ptr<Command>> *commands;
+	// Memory blocks obtained from the pool, and the free space in the last one.
+	std::vector<std::pair<void *, size_t>> commandBlocks;
+	uint8_t *blockCursor = nullptr;
+	uint8_t *blockEnd = nullptr;
+
+	Command *firstCommand = nullptr;
+	Command *lastCommand = nullptr;
 
 #ifdef ENABLE_VK_DEBUGGER
 	std::shared_ptr<vk::dbg::File> debuggerFile;
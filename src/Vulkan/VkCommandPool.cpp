@@ -27,6 +27,11 @@ CommandPool::CommandPool(const VkCommandPoolCreateInfo *pCreateInfo, void *mem)
 	                                  DEVICE_MEMORY, GetAllocationScope());
 	ASSERT(deviceMemory);
 	commandBuffers = new(deviceMemory) std::set<VkCommandBuffer>();
+
+	deviceMemory = vk::allocate(sizeof(std::vector<void *>), REQUIRED_MEMORY_ALIGNMENT,
+	                            DEVICE_MEMORY, GetAllocationScope());
+	ASSERT(deviceMemory);
+	unusedCommandBlocks = new(deviceMemory) std::vector<void *>();
 }
 
 void CommandPool::destroy(const VkAllocationCallbacks *pAllocator)
@@ -38,7 +43,12 @@ void CommandPool::destroy(const VkAllocationCallbacks *pAllocator)
 	}
 
 	// FIXME (b/119409619): use an allocator here so we can control all memory allocations
+	commandBuffers->~set();
 	vk::deallocate(commandBuffers, DEVICE_MEMORY);
+
+	freeCommandBlocks();
+	unusedCommandBlocks->~vector();
+	vk::deallocate(unusedCommandBlocks, DEVICE_MEMORY);
 }
 
 size_t CommandPool::ComputeRequiredAllocationSize(const VkCommandPoolCreateInfo *pCreateInfo)
@@ -54,7 +64,7 @@ VkResult CommandPool::allocateCommandBuffers(Device *device, VkCommandBufferLeve
 		void *deviceMemory = vk::allocate(sizeof(DispatchableCommandBuffer), REQUIRED_MEMORY_ALIGNMENT,
 		                                  DEVICE_MEMORY, DispatchableCommandBuffer::GetAllocationScope());
 		ASSERT(deviceMemory);
-		DispatchableCommandBuffer *commandBuffer = new(deviceMemory) DispatchableCommandBuffer(device, level);
+		DispatchableCommandBuffer *commandBuffer = new(deviceMemory) DispatchableCommandBuffer(device, level, this);
 		if(commandBuffer)
 		{
 			pCommandBuffers[i] = *commandBuffer;
@@ -101,14 +111,52 @@ VkResult CommandPool::reset(VkCommandPoolResetFlags flags)
 	// "Resetting a command pool recycles all of the
 	//  resources from all of the command buffers allocated
 	//  from the command pool back to the command pool."
-	commandBuffers->clear();
+	// The command buffers' memory blocks were returned to the pool above.
+	if(flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT)
+	{
+		freeCommandBlocks();
+	}
 
 	return VK_SUCCESS;
 }
 
 void CommandPool::trim(VkCommandPoolTrimFlags flags)
 {
-	// TODO (b/119827933): Optimize memory usage here
+	freeCommandBlocks();
+}
+
+void *CommandPool::allocateCommandBlock(size_t size)
+{
+	if((size == CommandBlockSize) && !unusedCommandBlocks->empty())
+	{
+		void *block = unusedCommandBlocks->back();
+		unusedCommandBlocks->pop_back();
+		return block;
+	}
+
+	return vk::allocate(size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY, GetAllocationScope());
+}
+
+void CommandPool::releaseCommandBlock(void *block, size_t size)
+{
+	if(size == CommandBlockSize)
+	{
+		unusedCommandBlocks->push_back(block);
+	}
+	else
+	{
+		vk::deallocate(block, DEVICE_MEMORY);
+	}
+}
+
+void CommandPool::freeCommandBlocks()
+{
+	for(auto block : *unusedCommandBlocks)
+	{
+		vk::deallocate(block, DEVICE_MEMORY);
+	}
+
+	unusedCommandBlocks->clear();
 }
 
 }  // namespace vk
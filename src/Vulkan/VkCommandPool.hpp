@@ -18,6 +18,7 @@
 #include "VkObject.hpp"
 
 #include <set>
+#include <vector>
 
 namespace vk {
 
@@ -36,8 +37,21 @@ public:
 	VkResult reset(VkCommandPoolResetFlags flags);
 	void trim(VkCommandPoolTrimFlags flags);
 
+	// Command buffers record into memory blocks owned by their pool. Blocks of
+	// the default size are recycled when command buffers get reset, and only
+	// freed on trimming or when resetting the pool with
+	// VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT. Command pools are externally
+	// synchronized, so this requires no locking.
+	static constexpr size_t CommandBlockSize = 64 * 1024;
+
+	void *allocateCommandBlock(size_t size);
+	void releaseCommandBlock(void *block, size_t size);
+
 private:
+	void freeCommandBlocks();
+
 	std::set<VkCommandBuffer> *commandBuffers;
+	std::vector<void *> *unusedCommandBlocks;
 };
 
 static inline CommandPool *Cast(VkCommandPool object)
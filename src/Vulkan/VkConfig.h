@@ -81,6 +81,42 @@ constexpr int SUBPIXEL_PRECISION_BITS = 4;
 constexpr float SUBPIXEL_PRECISION_FACTOR = static_cast<float>(1 << SUBPIXEL_PRECISION_BITS);
 constexpr int SUBPIXEL_PRECISION_MASK = 0xFFFFFFFF >> (32 - SUBPIXEL_PRECISION_BITS);
 
+// Build the draw routines of graphics pipelines on the device's worker threads
+// at pipeline creation, instead of on the queue thread at the first draw.
+constexpr bool PRECOMPILE_DRAW_ROUTINES = true;
+
+// Upper bound of the number of scheduler worker threads, imposed by marl.
+constexpr int MAX_WORKER_THREADS = 256;
+
+// Number of consecutive times an image sampling instruction must have resolved
+// the same image view and sampler before the pixel routine is rebuilt in the
+// background with the sampling code inlined for them. Zero disables this.
+constexpr uint32_t SAMPLING_SPECIALIZATION_THRESHOLD = 256;
+
+// Maximum number of times a shader's pixel routine gets rebuilt that way, so
+// shaders which alternate between descriptors don't keep the workers busy.
+constexpr uint32_t MAX_SAMPLING_SPECIALIZATIONS = 8;
+
+// Draw routines are first built at a low optimization level, which is quick to
+// compile, and rebuilt in the background at the default level once their
+// shader has been used for this many draws. Zero disables this.
+constexpr uint32_t TIERED_COMPILATION_THRESHOLD = 64;
+
+// Version of the preprocessed SPIR-V stored in pipeline cache data. It is part
+// of the pipelineCacheUUID, so bump it whenever preprocessSpirv() changes.
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+// Size of the hierarchical depth buffer cells, in pixels. A cell lies within a
+// single pair of rows, so it is only ever accessed by one rasterizer cluster.
+constexpr int HIZ_CELL_WIDTH = 16;
+constexpr int HIZ_CELL_HEIGHT = 2;
+
+// Size of the cells in which deferred clears of attachments are tracked. They
+// match the hierarchical depth buffer cells, so the pixel routines visit both
+// in the same loop.
+constexpr int CLEAR_CELL_WIDTH = HIZ_CELL_WIDTH;
+constexpr int CLEAR_CELL_HEIGHT = HIZ_CELL_HEIGHT;
+
 }  // namespace vk
 
 #if defined(__linux__) || defined(__ANDROID__)
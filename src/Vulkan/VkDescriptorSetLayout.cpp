@@ -301,6 +301,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			imageSampler[i].imageViewId = bufferView->id;
 			imageSampler[i].swizzle = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 			imageSampler[i].format = bufferView->getFormat();
+			imageSampler[i].tiled = false;
 
 			auto numElements = bufferView->getElementCount();
 			imageSampler[i].extent = { numElements, 1, 1 };
@@ -356,6 +357,7 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 			imageSampler[i].type = imageView->getType();
 			imageSampler[i].swizzle = imageView->getComponentMapping();
 			imageSampler[i].format = format;
+			imageSampler[i].tiled = imageView->isTiled();
 			imageSampler[i].device = device;
 
 			auto &subresourceRange = imageView->getSubresourceRange();
@@ -419,7 +421,8 @@ void DescriptorSetLayout::WriteDescriptorSet(Device *device, DescriptorSet *dstS
 
 					int width = extent.width;
 					int height = extent.height;
-					int bytes = format.bytes();
+					// Compressed images are addressed by block, and tiled images by 4x4 tile.
+					int bytes = format.isCompressed() ? format.bytesPerBlock() : format.bytes() * (imageSampler[i].tiled ? 16 : 1);
 					int layers = imageView->getSubresourceRange().layerCount;  // TODO(b/129523279): Untangle depth vs layers throughout the sampler
 					int depth = layers > 1 ? layers : extent.depth;
 					int pitchP = imageView->rowPitchBytes(aspect, level, ImageView::SAMPLING) / bytes;
@@ -41,6 +41,7 @@ struct alignas(16) SampledImageDescriptor
 	VkImageViewType type;
 	VkFormat format;
 	VkComponentMapping swizzle;
+	bool tiled;  // Stored in 4x4 tiles of texels
 	alignas(16) sw::Texture texture;
 	VkExtent3D extent;  // Of base mip-level.
 	int arrayLayers;
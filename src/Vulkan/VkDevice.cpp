@@ -22,9 +22,14 @@
 #include "Debug/Context.hpp"
 #include "Debug/Server.hpp"
 #include "Device/Blitter.hpp"
+#include "Device/PixelProcessor.hpp"
+#include "Device/SetupProcessor.hpp"
+#include "Device/VertexProcessor.hpp"
+#include "Reactor/ExecutableMemory.hpp"
 
 #include <chrono>
 #include <climits>
+#include <cstdlib>
 #include <new>  // Must #include this to use "placement new"
 
 namespace {
@@ -49,9 +54,50 @@ void Device::SamplingRoutineCache::add(const vk::Device::SamplingRoutineCache::K
 	cache.add(key, routine);
 }
 
+std::shared_ptr<rr::Routine> Device::SamplingRoutineCache::getOrCreate(std::unique_lock<std::mutex> &lock, const StateKey &key,
+                                                                      const std::function<std::shared_ptr<rr::Routine>()> &createRoutine)
+{
+	ASSERT(lock.owns_lock());
+
+	auto stateRoutine = stateCache.query(key);
+	if(stateRoutine)
+	{
+		lock.unlock();
+		stateRoutine->built.wait();
+		lock.lock();
+
+		return stateRoutine->routine;
+	}
+
+	stateRoutine = std::make_shared<StateRoutine>();
+	stateCache.add(key, stateRoutine);
+
+	lock.unlock();
+	stateRoutine->routine = createRoutine();
+	stateRoutine->built.signal();
+	lock.lock();
+
+	return stateRoutine->routine;
+}
+
 rr::Routine *Device::SamplingRoutineCache::queryConst(const vk::Device::SamplingRoutineCache::Key &key) const
 {
-	return cache.queryConstCache(key).get();
+	rr::Routine *routine = cache.queryConstCache(key).get();
+
+	if(routine)
+	{
+		constCacheHits.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return routine;
+}
+
+sw::CacheStats Device::SamplingRoutineCache::getStats() const
+{
+	sw::CacheStats stats = cache.getStats();
+	stats.hits += constCacheHits.load();
+
+	return stats;
 }
 
 void Device::SamplingRoutineCache::updateConstCache()
@@ -115,6 +161,11 @@ Device::Device(const VkDeviceCreateInfo *pCreateInfo, void *mem, PhysicalDevice
 
 void Device::destroy(const VkAllocationCallbacks *pAllocator)
 {
+	if(getenv("SWIFTSHADER_JIT_TELEMETRY"))
+	{
+		dumpJITTelemetry(stderr);
+	}
+
 	for(uint32_t i = 0; i < queueCount; i++)
 	{
 		queues[i].~Queue();
@@ -279,4 +330,46 @@ std::mutex &Device::getSamplingRoutineCacheMutex()
 	return samplingRoutineCacheMutex;
 }
 
+void Device::dumpJITTelemetry(FILE *out)
+{
+	fprintf(out, "%-20s %8s %10s %8s %8s %12s  %s\n", "Routine", "Count", "Total ms", "p50 ms", "p99 ms", "Code bytes", "Slowest");
+
+	for(auto &stats : rr::getCompileStats())
+	{
+		fprintf(out, "%-20s %8llu %10.1f %8.3f %8.3f %12llu  %s (%.1f ms)\n", stats.name.c_str(),
+		        (unsigned long long)stats.count, stats.totalMs, stats.p50Ms, stats.p99Ms,
+		        (unsigned long long)stats.codeBytes, stats.slowest.c_str(), stats.slowestMs);
+	}
+
+	sw::CacheStats samplingStats;
+	{
+		std::unique_lock<std::mutex> lock(samplingRoutineCacheMutex);
+		samplingStats = samplingRoutineCache->getStats();
+	}
+
+	const std::pair<const char *, sw::CacheStats> caches[] = {
+		{ "Vertex", sw::VertexProcessor::getCacheStats() },
+		{ "Setup", sw::SetupProcessor::getCacheStats() },
+		{ "Pixel", sw::PixelProcessor::getCacheStats() },
+		{ "Blit", blitter->getCacheStats() },
+		{ "Sampler", samplingStats },
+	};
+
+	fprintf(out, "%-20s %12s %12s %12s %9s\n", "Routine cache", "Hits", "Misses", "Evictions", "Hit rate");
+
+	for(auto &cache : caches)
+	{
+		uint64_t queries = cache.second.hits + cache.second.misses;
+		double hitRate = queries ? (100.0 * cache.second.hits / queries) : 0.0;
+
+		fprintf(out, "%-20s %12llu %12llu %12llu %8.1f%%\n", cache.first,
+		        (unsigned long long)cache.second.hits, (unsigned long long)cache.second.misses,
+		        (unsigned long long)cache.second.evictions, hitRate);
+	}
+
+	rr::CodeMemoryStats codeStats = rr::codeMemoryStats();
+	fprintf(out, "Code memory: %llu bytes used, %llu bytes reserved\n",
+	        (unsigned long long)codeStats.bytesUsed, (unsigned long long)codeStats.bytesReserved);
+}
+
 }  // namespace vk
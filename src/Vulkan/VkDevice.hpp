@@ -17,7 +17,14 @@
 
 #include "VkObject.hpp"
 #include "Device/LRUCache.hpp"
+#include "Device/Sampler.hpp"
 #include "Reactor/Routine.hpp"
+
+#include "marl/event.h"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -60,12 +67,14 @@ public:
 	void getRequirements(VkMemoryDedicatedRequirements *requirements) const;
 	const VkPhysicalDeviceFeatures &getEnabledFeatures() const { return enabledFeatures; }
 	sw::Blitter *getBlitter() const { return blitter.get(); }
+	marl::Scheduler *getScheduler() const { return scheduler.get(); }
 
 	class SamplingRoutineCache
 	{
 	public:
 		SamplingRoutineCache()
 		    : cache(1024)
+		    , stateCache(1024)
 		{}
 		~SamplingRoutineCache() {}
 
@@ -89,8 +98,38 @@ public:
 		rr::Routine *queryConst(const Key &key) const;
 		void updateConstCache();
 
+		// Hits of queryConst(), or of query() after a miss of the former, and
+		// misses of query(). Requires the sampling routine cache mutex.
+		sw::CacheStats getStats() const;
+
+		// Image views and samplers resolving to the same sampler state share
+		// their routine, which is looked up by this key on a miss of the above.
+		struct StateKey
+		{
+			uint32_t instruction;
+			sw::Sampler samplerState;
+
+			inline bool operator==(const StateKey &rhs) const;
+		};
+
+		// Returns the routine of the given state, calling createRoutine() to
+		// build it if there is none yet. The lock of the device's sampling
+		// routine cache mutex is released while building, so routines of
+		// different states are built concurrently. Callers asking for a state
+		// being built wait for it instead of building it again.
+		std::shared_ptr<rr::Routine> getOrCreate(std::unique_lock<std::mutex> &lock, const StateKey &key,
+		                                         const std::function<std::shared_ptr<rr::Routine>()> &createRoutine);
+
 	private:
+		struct StateRoutine
+		{
+			marl::Event built = marl::Event(marl::Event::Mode::Manual);
+			std::shared_ptr<rr::Routine> routine;
+		};
+
 		sw::LRUConstCache<Key, std::shared_ptr<rr::Routine>, Key::Hash> cache;
+		sw::LRUCache<StateKey, std::shared_ptr<StateRoutine>> stateCache;
+		mutable std::atomic<uint64_t> constCacheHits = { 0 };
 	};
 
 	SamplingRoutineCache *getSamplingRoutineCache() const;
@@ -98,6 +137,11 @@ public:
 	rr::Routine *findInConstCache(const SamplingRoutineCache::Key &key) const;
 	void updateSamplingRoutineConstCache();
 
+	// Writes the statistics of the routines built by Reactor, of the routine
+	// caches, and of the code memory to out. This is done on destruction when
+	// the SWIFTSHADER_JIT_TELEMETRY environment variable is set.
+	void dumpJITTelemetry(FILE *out);
+
 	std::shared_ptr<vk::dbg::Context> getDebuggerContext() const
 	{
 #ifdef ENABLE_VK_DEBUGGER
@@ -141,6 +185,12 @@ inline bool vk::Device::SamplingRoutineCache::Key::operator==(const Key &rhs) co
 	return instruction == rhs.instruction && sampler == rhs.sampler && imageView == rhs.imageView;
 }
 
+inline bool vk::Device::SamplingRoutineCache::StateKey::operator==(const StateKey &rhs) const
+{
+	static_assert(sw::is_memcmparable<StateKey>::value, "Cannot memcmp StateKey");
+	return memcmp(this, &rhs, sizeof(StateKey)) == 0;
+}
+
 inline std::size_t vk::Device::SamplingRoutineCache::Key::Hash::operator()(const Key &key) const noexcept
 {
 	// Combine three 32-bit integers into a 64-bit hash.
@@ -40,6 +40,13 @@ void Framebuffer::clear(const RenderPass *renderPass, uint32_t clearValueCount,
 {
 	ASSERT(attachmentCount == renderPass->getAttachmentCount());
 
+	// Depth written outside of the render pass instance isn't tracked by the
+	// hierarchical depth buffers, so they start out unknown, unless cleared.
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		attachments[i]->invalidateHiZ();
+	}
+
 	const uint32_t count = std::min(clearValueCount, attachmentCount);
 	for(uint32_t i = 0; i < count; i++)
 	{
@@ -66,6 +73,13 @@ void Framebuffer::clear(const RenderPass *renderPass, uint32_t clearValueCount,
 			attachments[i]->clear(pClearValues[i], aspectMask, renderArea);
 		}
 	}
+
+	// Input attachments are read through descriptors, which don't know about
+	// deferred clears.
+	if(renderPass->getSubpass(0).inputAttachmentCount > 0)
+	{
+		resolveDeferredClears();
+	}
 }
 
 void Framebuffer::clearAttachment(const RenderPass *renderPass, uint32_t subpassIndex, const VkClearAttachment &attachment, const VkClearRect &rect)
@@ -145,6 +159,43 @@ void Framebuffer::resolve(const RenderPass *renderPass, uint32_t subpassIndex)
 	}
 }
 
+bool Framebuffer::hasDeferredClears() const
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		if(attachments[i]->hasDeferredClear())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Framebuffer::resolveDeferredClears()
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		attachments[i]->resolveDeferredClear();
+	}
+}
+
+void Framebuffer::finishDeferredClears(const RenderPass *renderPass)
+{
+	for(uint32_t i = 0; i < attachmentCount; i++)
+	{
+		// Contents which aren't stored are undefined after the render pass.
+		if(renderPass->getAttachment(i).storeOp == VK_ATTACHMENT_STORE_OP_DONT_CARE)
+		{
+			attachments[i]->discardDeferredClear();
+		}
+		else
+		{
+			attachments[i]->resolveDeferredClear();
+		}
+	}
+}
+
 size_t Framebuffer::ComputeRequiredAllocationSize(const VkFramebufferCreateInfo *pCreateInfo)
 {
 	return pCreateInfo->attachmentCount * sizeof(void *);
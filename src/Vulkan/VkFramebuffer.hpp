@@ -35,6 +35,13 @@ public:
 	ImageView *getAttachment(uint32_t index) const;
 	void resolve(const RenderPass *renderPass, uint32_t subpassIndex);
 
+	// Deferred clears of the attachments, see ImageView::hasDeferredClear().
+	// They must be resolved before attachments are read other than by draws,
+	// and finishDeferredClears() must be called at the end of the render pass.
+	bool hasDeferredClears() const;
+	void resolveDeferredClears();
+	void finishDeferredClears(const RenderPass *renderPass);
+
 	const VkExtent3D &getExtent() const { return extent; }
 
 private:
@@ -19,7 +19,10 @@
 #include "Device/BC_Decoder.hpp"
 #include "Device/Blitter.hpp"
 #include "Device/ETC_Decoder.hpp"
+#include "Device/Parallel.hpp"
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #ifdef __ANDROID__
 #	include "System/GrallocAndroid.hpp"
@@ -27,6 +30,144 @@
 
 namespace {
 
+// Copies contiguous memory, spreading large copies across worker threads.
+void ParallelMemcpy(void *dst, const void *src, size_t size)
+{
+	constexpr size_t chunkSize = sw::ParallelMinBytesPerTask;
+	uint32_t chunkCount = static_cast<uint32_t>((size + chunkSize - 1) / chunkSize);
+
+	sw::parallelFor(chunkCount, chunkSize, [&](uint32_t begin, uint32_t end) {
+		size_t offset = begin * chunkSize;
+		size_t endOffset = std::min(end * chunkSize, size);
+		memcpy(static_cast<uint8_t *>(dst) + offset, static_cast<const uint8_t *>(src) + offset, endOffset - offset);
+	});
+}
+
+// Copies rowCount rows of rowSize bytes, for each of sliceCount slices,
+// spreading large copies across worker threads.
+void ParallelCopyRows(uint8_t *dst, const uint8_t *src, size_t rowSize,
+                      uint32_t rowCount, int dstRowPitchBytes, int srcRowPitchBytes,
+                      uint32_t sliceCount, int dstSlicePitchBytes, int srcSlicePitchBytes)
+{
+	sw::parallelFor(rowCount * sliceCount, rowSize, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t row = begin; row < end; row++)
+		{
+			uint32_t z = row / rowCount;
+			uint32_t y = row % rowCount;
+			memcpy(dst + z * dstSlicePitchBytes + y * dstRowPitchBytes,
+			       src + z * srcSlicePitchBytes + y * srcRowPitchBytes,
+			       rowSize);
+		}
+	});
+}
+
+// Copies rowCount rows of width texels, for each of sliceCount slices, to the
+// texels starting at (x, y) of an image stored in 4x4 tiles.
+void ParallelCopyRowsToTiles(uint8_t *dst, const uint8_t *src, int bytes, uint32_t x, uint32_t y, uint32_t width,
+                             uint32_t rowCount, int dstTileRowPitchBytes, int srcRowPitchBytes,
+                             uint32_t sliceCount, int dstSlicePitchBytes, int srcSlicePitchBytes)
+{
+	sw::parallelFor(rowCount * sliceCount, width * bytes, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t row = begin; row < end; row++)
+		{
+			uint32_t z = row / rowCount;
+			uint32_t j = y + row % rowCount;
+			uint8_t *dstRow = dst + z * dstSlicePitchBytes + (j / 4) * dstTileRowPitchBytes + (j % 4) * 4 * bytes;
+			const uint8_t *s = src + z * srcSlicePitchBytes + (row % rowCount) * srcRowPitchBytes;
+
+			// Each tile holds a run of up to 4 texels of the row.
+			for(uint32_t i = x; i < x + width;)
+			{
+				uint32_t count = std::min(4 - (i % 4), x + width - i);
+				memcpy(dstRow + ((i / 4) * 16 + (i % 4)) * bytes, s, count * bytes);
+				s += count * bytes;
+				i += count;
+			}
+		}
+	});
+}
+
+// A depth slice of a mipmap level of a compressed image, and where it decodes to.
+struct CompressedSlice
+{
+	const uint8_t *source;
+	uint8_t *dest;
+	int width;
+	int height;
+	int sourceRowPitchBytes;  // Bytes per row of 4x4 blocks
+	int destRowPitchBytes;
+};
+
+// Calls decode(source, dest, width, height, destRowPitchBytes) for ranges of
+// rows of blocks of the slices, spreading them across worker threads.
+template<typename Function>
+void ParallelDecodeSlices(const std::vector<CompressedSlice> &slices, int destBytesPerTexel, const Function &decode)
+{
+	std::vector<uint32_t> firstRows;  // Index of the first row of blocks of each slice
+	uint32_t rowCount = 0;
+	size_t destBytes = 0;
+
+	for(const auto &slice : slices)
+	{
+		firstRows.push_back(rowCount);
+		rowCount += (slice.height + 3) / 4;
+		destBytes += size_t(slice.width) * slice.height * destBytesPerTexel;
+	}
+
+	if(rowCount == 0)
+	{
+		return;
+	}
+
+	sw::parallelFor(rowCount, destBytes / rowCount, [&](uint32_t begin, uint32_t end) {
+		size_t s = std::upper_bound(firstRows.begin(), firstRows.end(), begin) - firstRows.begin() - 1;
+
+		for(; begin < end; s++)
+		{
+			const CompressedSlice &slice = slices[s];
+			uint32_t row = begin - firstRows[s];
+			uint32_t rows = std::min(end - begin, (slice.height + 3) / 4 - row);
+			int y = row * 4;
+
+			decode(slice.source + row * slice.sourceRowPitchBytes, slice.dest + y * slice.destRowPitchBytes,
+			       slice.width, std::min<int>(rows * 4, slice.height - y), slice.destRowPitchBytes);
+
+			begin += rows;
+		}
+	});
+}
+
+// Returns the depth slices of the subresource range of a compressed image.
+std::vector<CompressedSlice> GetCompressedSlices(const vk::Image *image, const vk::Image *decompressedImage, const VkImageSubresourceRange &subresourceRange)
+{
+	std::vector<CompressedSlice> slices;
+
+	uint32_t lastLayer = image->getLastLayerIndex(subresourceRange);
+	uint32_t lastMipLevel = image->getLastMipLevel(subresourceRange);
+
+	VkImageSubresourceLayers subresourceLayers = { subresourceRange.aspectMask, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer, 1 };
+	for(; subresourceLayers.baseArrayLayer <= lastLayer; subresourceLayers.baseArrayLayer++)
+	{
+		for(subresourceLayers.mipLevel = subresourceRange.baseMipLevel; subresourceLayers.mipLevel <= lastMipLevel; subresourceLayers.mipLevel++)
+		{
+			VkExtent3D mipLevelExtent = image->getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceLayers.aspectMask), subresourceLayers.mipLevel);
+
+			int sourcePitchB = image->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
+			int destPitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
+
+			for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
+			{
+				const uint8_t *source = static_cast<const uint8_t *>(image->getTexelPointer({ 0, 0, depth }, subresourceLayers));
+				uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresourceLayers));
+
+				slices.push_back({ source, dest, static_cast<int>(mipLevelExtent.width), static_cast<int>(mipLevelExtent.height), sourcePitchB, destPitchB });
+			}
+		}
+	}
+
+	return slices;
+}
+
 ETC_Decoder::InputType GetInputType(const vk::Format &format)
 {
 	switch(format)
@@ -108,6 +249,51 @@ bool GetNoAlphaOrUnsigned(const vk::Format &format)
 	}
 }
 
+// BC compressed 2D images are sampled directly, with the sampling routines
+// decoding the blocks they read. Other compressed images are decompressed into
+// a shadow image when they are prepared for sampling.
+bool RequiresDecompressedImage(const VkImageCreateInfo *pCreateInfo)
+{
+	switch(pCreateInfo->format)
+	{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+			// Cube maps need the borders of the shadow image for seamless filtering.
+			return (pCreateInfo->imageType != VK_IMAGE_TYPE_2D) ||
+			       (pCreateInfo->flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+		default:
+			return vk::Format(pCreateInfo->format).isCompressed();
+	}
+}
+
+// Optimal tiling 2D images which are only sampled and written by transfer
+// commands store their texels in 4x4 tiles, for the locality of texture
+// accesses. Images shared through external memory keep a linear layout.
+bool UseTiledStorage(const VkImageCreateInfo *pCreateInfo)
+{
+	vk::Format format(pCreateInfo->format);
+	VkImageUsageFlags tiledUsage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	return (pCreateInfo->pNext == nullptr) &&
+	       (pCreateInfo->tiling == VK_IMAGE_TILING_OPTIMAL) &&
+	       (pCreateInfo->imageType == VK_IMAGE_TYPE_2D) &&
+	       (pCreateInfo->samples == VK_SAMPLE_COUNT_1_BIT) &&
+	       ((pCreateInfo->flags & ~VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT) == 0) &&
+	       ((pCreateInfo->usage & VK_IMAGE_USAGE_SAMPLED_BIT) != 0) &&
+	       ((pCreateInfo->usage & ~tiledUsage) == 0) &&
+	       !format.isCompressed() && !format.isDepth() && !format.isStencil() && !format.isYcbcrFormat();
+}
+
 }  // anonymous namespace
 
 namespace vk {
@@ -123,11 +309,13 @@ Image::Image(const VkImageCreateInfo *pCreateInfo, void *mem, Device *device)
     , samples(pCreateInfo->samples)
     , tiling(pCreateInfo->tiling)
     , usage(pCreateInfo->usage)
+    , tiled(UseTiledStorage(pCreateInfo))
 {
-	if(format.isCompressed())
+	if(RequiresDecompressedImage(pCreateInfo))
 	{
 		VkImageCreateInfo compressedImageCreateInfo = *pCreateInfo;
 		compressedImageCreateInfo.format = format.getDecompressedFormat();
+		compressedImageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;  // The decoders write rows of texels
 		decompressedImage = new(mem) Image(&compressedImageCreateInfo, nullptr, device);
 	}
 
@@ -152,7 +340,7 @@ void Image::destroy(const VkAllocationCallbacks *pAllocator)
 
 size_t Image::ComputeRequiredAllocationSize(const VkImageCreateInfo *pCreateInfo)
 {
-	return Format(pCreateInfo->format).isCompressed() ? sizeof(Image) : 0;
+	return RequiresDecompressedImage(pCreateInfo) ? sizeof(Image) : 0;
 }
 
 const VkMemoryRequirements Image::getMemoryRequirements() const
@@ -308,6 +496,27 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 	VkExtent3D dstExtent = dstImage->getMipLevelExtent(dstAspect, region.dstSubresource.mipLevel);
 	VkExtent3D copyExtent = imageExtentInBlocks(region.extent, srcAspect);
 
+	if(dstImage->isTiled())
+	{
+		// Tiled images can't be transfer sources, so this image is linear.
+		ASSERT(!tiled);
+
+		VkImageSubresourceLayers srcSubresource = region.srcSubresource;
+		VkImageSubresourceLayers dstSubresource = region.dstSubresource;
+		srcSubresource.layerCount = dstSubresource.layerCount = 1;
+
+		for(uint32_t i = 0; i < region.dstSubresource.layerCount; i++, srcSubresource.baseArrayLayer++, dstSubresource.baseArrayLayer++)
+		{
+			srcMem = static_cast<const uint8_t *>(getTexelPointer(region.srcOffset, srcSubresource));
+			dstMem = static_cast<uint8_t *>(dstImage->getTexelPointer({ 0, 0, region.dstOffset.z }, dstSubresource));
+			ParallelCopyRowsToTiles(dstMem, srcMem, srcBytesPerBlock, region.dstOffset.x, region.dstOffset.y, copyExtent.width,
+			                        copyExtent.height, dstRowPitchBytes, srcRowPitchBytes,
+			                        copyExtent.depth, dstSlicePitchBytes, srcSlicePitchBytes);
+		}
+
+		return;
+	}
+
 	bool isSinglePlane = (copyExtent.depth == 1);
 	bool isSingleLine = (copyExtent.height == 1) && isSinglePlane;
 	// In order to copy multiple lines using a single memcpy call, we
@@ -344,41 +553,29 @@ void Image::copyTo(Image *dstImage, const VkImageCopy &region) const
 		size_t copySize = copyExtent.height * srcRowPitchBytes;
 		ASSERT((srcMem + copySize) < end());
 		ASSERT((dstMem + copySize) < dstImage->end());
-		memcpy(dstMem, srcMem, copySize);
+		ParallelMemcpy(dstMem, srcMem, copySize);
 	}
 	else if(isEntirePlane)  // Copy multiple planes
 	{
 		size_t copySize = copyExtent.depth * srcSlicePitchBytes;
 		ASSERT((srcMem + copySize) < end());
 		ASSERT((dstMem + copySize) < dstImage->end());
-		memcpy(dstMem, srcMem, copySize);
+		ParallelMemcpy(dstMem, srcMem, copySize);
 	}
 	else if(isEntireLine)  // Copy plane by plane
 	{
 		size_t copySize = copyExtent.height * srcRowPitchBytes;
-
-		for(uint32_t z = 0; z < copyExtent.depth; z++, dstMem += dstSlicePitchBytes, srcMem += srcSlicePitchBytes)
-		{
-			ASSERT((srcMem + copySize) < end());
-			ASSERT((dstMem + copySize) < dstImage->end());
-			memcpy(dstMem, srcMem, copySize);
-		}
+		ASSERT((srcMem + (copyExtent.depth - 1) * srcSlicePitchBytes + copySize) < end());
+		ASSERT((dstMem + (copyExtent.depth - 1) * dstSlicePitchBytes + copySize) < dstImage->end());
+		ParallelCopyRows(dstMem, srcMem, copySize, 1, 0, 0, copyExtent.depth, dstSlicePitchBytes, srcSlicePitchBytes);
 	}
 	else  // Copy line by line
 	{
 		size_t copySize = copyExtent.width * srcBytesPerBlock;
-
-		for(uint32_t z = 0; z < copyExtent.depth; z++, dstMem += dstSlicePitchBytes, srcMem += srcSlicePitchBytes)
-		{
-			const uint8_t *srcSlice = srcMem;
-			uint8_t *dstSlice = dstMem;
-			for(uint32_t y = 0; y < copyExtent.height; y++, dstSlice += dstRowPitchBytes, srcSlice += srcRowPitchBytes)
-			{
-				ASSERT((srcSlice + copySize) < end());
-				ASSERT((dstSlice + copySize) < dstImage->end());
-				memcpy(dstSlice, srcSlice, copySize);
-			}
-		}
+		ASSERT((srcMem + (copyExtent.depth - 1) * srcSlicePitchBytes + (copyExtent.height - 1) * srcRowPitchBytes + copySize) < end());
+		ASSERT((dstMem + (copyExtent.depth - 1) * dstSlicePitchBytes + (copyExtent.height - 1) * dstRowPitchBytes + copySize) < dstImage->end());
+		ParallelCopyRows(dstMem, srcMem, copySize, copyExtent.height, dstRowPitchBytes, srcRowPitchBytes,
+		                 copyExtent.depth, dstSlicePitchBytes, srcSlicePitchBytes);
 	}
 
 	dstImage->prepareForSampling({ region.dstSubresource.aspectMask, region.dstSubresource.mipLevel, 1,
@@ -422,6 +619,26 @@ void Image::copy(Buffer *buffer, const VkBufferImageCopy &region, bool bufferIsS
 	int srcRowPitchBytes = bufferIsSource ? bufferRowPitchBytes : imageRowPitchBytes;
 	int dstRowPitchBytes = bufferIsSource ? imageRowPitchBytes : bufferRowPitchBytes;
 
+	if(tiled)
+	{
+		// Tiled images can't be transfer sources.
+		ASSERT(bufferIsSource);
+
+		VkImageSubresourceLayers subresource = region.imageSubresource;
+		subresource.layerCount = 1;
+
+		for(uint32_t i = 0; i < region.imageSubresource.layerCount; i++, subresource.baseArrayLayer++)
+		{
+			imageMemory = static_cast<uint8_t *>(getTexelPointer({ 0, 0, region.imageOffset.z }, subresource));
+			ParallelCopyRowsToTiles(imageMemory, bufferMemory, bytesPerBlock, region.imageOffset.x, region.imageOffset.y, imageExtent.width,
+			                        imageExtent.height, imageRowPitchBytes, bufferRowPitchBytes,
+			                        imageExtent.depth, imageSlicePitchBytes, bufferSlicePitchBytes);
+			bufferMemory += imageExtent.depth * bufferSlicePitchBytes;
+		}
+
+		return;
+	}
+
 	VkExtent3D mipLevelExtent = getMipLevelExtent(aspect, region.imageSubresource.mipLevel);
 	bool isSinglePlane = (imageExtent.depth == 1);
 	bool isSingleLine = (imageExtent.height == 1) && isSinglePlane;
@@ -468,40 +685,21 @@ void Image::copy(Buffer *buffer, const VkBufferImageCopy &region, bool bufferIsS
 		{
 			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + copySize) < end());
 			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + copySize) < buffer->end());
-			memcpy(dstMemory, srcMemory, copySize);
+			ParallelMemcpy(dstMemory, srcMemory, copySize);
 		}
 		else if(isEntireLine)  // Copy plane by plane
 		{
-			uint8_t *srcPlaneMemory = srcMemory;
-			uint8_t *dstPlaneMemory = dstMemory;
-			for(uint32_t z = 0; z < imageExtent.depth; z++)
-			{
-				ASSERT(((bufferIsSource ? dstPlaneMemory : srcPlaneMemory) + copySize) < end());
-				ASSERT(((bufferIsSource ? srcPlaneMemory : dstPlaneMemory) + copySize) < buffer->end());
-				memcpy(dstPlaneMemory, srcPlaneMemory, copySize);
-				srcPlaneMemory += srcSlicePitchBytes;
-				dstPlaneMemory += dstSlicePitchBytes;
-			}
+			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + (imageExtent.depth - 1) * imageSlicePitchBytes + copySize) < end());
+			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + (imageExtent.depth - 1) * bufferSlicePitchBytes + copySize) < buffer->end());
+			ParallelCopyRows(dstMemory, srcMemory, copySize, 1, 0, 0,
+			                 imageExtent.depth, dstSlicePitchBytes, srcSlicePitchBytes);
 		}
 		else  // Copy line by line
 		{
-			uint8_t *srcLayerMemory = srcMemory;
-			uint8_t *dstLayerMemory = dstMemory;
-			for(uint32_t z = 0; z < imageExtent.depth; z++)
-			{
-				uint8_t *srcPlaneMemory = srcLayerMemory;
-				uint8_t *dstPlaneMemory = dstLayerMemory;
-				for(uint32_t y = 0; y < imageExtent.height; y++)
-				{
-					ASSERT(((bufferIsSource ? dstPlaneMemory : srcPlaneMemory) + copySize) < end());
-					ASSERT(((bufferIsSource ? srcPlaneMemory : dstPlaneMemory) + copySize) < buffer->end());
-					memcpy(dstPlaneMemory, srcPlaneMemory, copySize);
-					srcPlaneMemory += srcRowPitchBytes;
-					dstPlaneMemory += dstRowPitchBytes;
-				}
-				srcLayerMemory += srcSlicePitchBytes;
-				dstLayerMemory += dstSlicePitchBytes;
-			}
+			ASSERT(((bufferIsSource ? dstMemory : srcMemory) + (imageExtent.depth - 1) * imageSlicePitchBytes + (imageExtent.height - 1) * imageRowPitchBytes + copySize) < end());
+			ASSERT(((bufferIsSource ? srcMemory : dstMemory) + (imageExtent.depth - 1) * bufferSlicePitchBytes + (imageExtent.height - 1) * bufferRowPitchBytes + copySize) < buffer->end());
+			ParallelCopyRows(dstMemory, srcMemory, copySize, imageExtent.height, dstRowPitchBytes, srcRowPitchBytes,
+			                 imageExtent.depth, dstSlicePitchBytes, srcSlicePitchBytes);
 		}
 
 		srcMemory += srcLayerSize;
@@ -607,6 +805,14 @@ VkDeviceSize Image::texelOffsetBytesInStorage(const VkOffset3D &offset, const Vk
 {
 	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
 	VkOffset3D adjustedOffset = imageOffsetInBlocks(offset, aspect);
+
+	if(tiled)
+	{
+		return adjustedOffset.z * slicePitchBytes(aspect, subresource.mipLevel) +
+		       (adjustedOffset.y / 4) * rowPitchBytes(aspect, subresource.mipLevel) +
+		       ((adjustedOffset.x / 4) * 16 + (adjustedOffset.y % 4) * 4 + (adjustedOffset.x % 4)) * getFormat(aspect).bytes();
+	}
+
 	int border = borderSize();
 	return adjustedOffset.z * slicePitchBytes(aspect, subresource.mipLevel) +
 	       (adjustedOffset.y + border) * rowPitchBytes(aspect, subresource.mipLevel) +
@@ -660,6 +866,11 @@ int Image::rowPitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const
 	ASSERT((aspect & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) !=
 	       (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT));
 
+	if(tiled)
+	{
+		return sw::align<4>(getMipLevelExtent(aspect, mipLevel).width) * 4 * getFormat(aspect).bytes();
+	}
+
 	return getFormat(aspect).pitchB(getMipLevelExtent(aspect, mipLevel).width, borderSize(), true);
 }
 
@@ -671,6 +882,13 @@ int Image::slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) cons
 
 	VkExtent3D mipLevelExtent = getMipLevelExtent(aspect, mipLevel);
 	Format usedFormat = getFormat(aspect);
+	if(tiled)
+	{
+		// Padded like linear slices, but to a whole number of tiles.
+		int rows = (mipLevelExtent.height + 3) / 4;
+		return sw::align(rows * rowPitchBytes(aspect, mipLevel) + 15, 16 * usedFormat.bytes());
+	}
+
 	if(usedFormat.isCompressed())
 	{
 		sw::align(mipLevelExtent.width, usedFormat.blockWidth());
@@ -823,9 +1041,10 @@ const Image *Image::getSampledImage(const vk::Format &imageViewFormat) const
 		ASSERT(format.bytesPerBlock() == imageViewFormat.bytesPerBlock());
 	}
 	// If the ImageView's format is compressed, then we do need to decompress the image so that
-	// it may be sampled properly by texture sampling functions, which don't support compressed
-	// textures. If the ImageView's format is NOT compressed, then we reinterpret cast the
-	// compressed image into the ImageView's format, so we must return the compressed image as is.
+	// it may be sampled properly by texture sampling functions, unless they decode the blocks
+	// themselves, in which case there is no decompressed image. If the ImageView's format is NOT
+	// compressed, then we reinterpret cast the compressed image into the ImageView's format, so
+	// we must return the compressed image as is.
 	return (decompressedImage && isImageViewCompressed) ? decompressedImage : this;
 }
 
@@ -1018,46 +1237,23 @@ void Image::decodeETC2(const VkImageSubresourceRange &subresourceRange) const
 
 	ETC_Decoder::InputType inputType = GetInputType(format);
 
-	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
-	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
-
 	int bytes = decompressedImage->format.bytes();
 	bool fakeAlpha = (format == VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK) || (format == VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK);
-	size_t sizeToWrite = 0;
-
-	VkImageSubresourceLayers subresourceLayers = { subresourceRange.aspectMask, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer, 1 };
-	for(; subresourceLayers.baseArrayLayer <= lastLayer; subresourceLayers.baseArrayLayer++)
-	{
-		for(; subresourceLayers.mipLevel <= lastMipLevel; subresourceLayers.mipLevel++)
-		{
-			VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceLayers.aspectMask), subresourceLayers.mipLevel);
 
-			int pitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
+	std::vector<CompressedSlice> slices = GetCompressedSlices(this, decompressedImage, subresourceRange);
 
-			if(fakeAlpha)
+	ParallelDecodeSlices(slices, bytes, [&](const uint8_t *source, uint8_t *dest, int width, int height, int pitchB) {
+		if(fakeAlpha)
+		{
+			// Only write the texels, as cube textures are offset in memory to account for the border.
+			for(int y = 0; y < height; y++)
 			{
-				// To avoid overflow in case of cube textures, which are offset in memory to account for the border,
-				// compute the size from the first pixel to the last pixel, excluding any padding or border before
-				// the first pixel or after the last pixel.
-				sizeToWrite = ((mipLevelExtent.height - 1) * pitchB) + (mipLevelExtent.width * bytes);
-			}
-
-			for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
-			{
-				uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ 0, 0, depth }, subresourceLayers));
-				uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresourceLayers));
-
-				if(fakeAlpha)
-				{
-					ASSERT((dest + sizeToWrite) < decompressedImage->end());
-					memset(dest, 0xFF, sizeToWrite);
-				}
-
-				ETC_Decoder::Decode(source, dest, mipLevelExtent.width, mipLevelExtent.height,
-				                    mipLevelExtent.width, mipLevelExtent.height, pitchB, bytes, inputType);
+				memset(dest + y * pitchB, 0xFF, width * bytes);
 			}
 		}
-	}
+
+		ETC_Decoder::Decode(source, dest, width, height, width, height, pitchB, bytes, inputType);
+	});
 }
 
 void Image::decodeBC(const VkImageSubresourceRange &subresourceRange) const
@@ -1067,30 +1263,13 @@ void Image::decodeBC(const VkImageSubresourceRange &subresourceRange) const
 	int n = GetBCn(format);
 	int noAlphaU = GetNoAlphaOrUnsigned(format);
 
-	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
-	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
-
 	int bytes = decompressedImage->format.bytes();
 
-	VkImageSubresourceLayers subresourceLayers = { subresourceRange.aspectMask, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer, 1 };
-	for(; subresourceLayers.baseArrayLayer <= lastLayer; subresourceLayers.baseArrayLayer++)
-	{
-		for(; subresourceLayers.mipLevel <= lastMipLevel; subresourceLayers.mipLevel++)
-		{
-			VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceLayers.aspectMask), subresourceLayers.mipLevel);
+	std::vector<CompressedSlice> slices = GetCompressedSlices(this, decompressedImage, subresourceRange);
 
-			int pitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
-
-			for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
-			{
-				uint8_t *source = static_cast<uint8_t *>(getTexelPointer({ 0, 0, depth }, subresourceLayers));
-				uint8_t *dest = static_cast<uint8_t *>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresourceLayers));
-
-				BC_Decoder::Decode(source, dest, mipLevelExtent.width, mipLevelExtent.height,
-				                   mipLevelExtent.width, mipLevelExtent.height, pitchB, bytes, n, noAlphaU);
-			}
-		}
-	}
+	ParallelDecodeSlices(slices, bytes, [&](const uint8_t *source, uint8_t *dest, int width, int height, int pitchB) {
+		BC_Decoder::Decode(source, dest, width, height, width, height, pitchB, bytes, n, noAlphaU);
+	});
 }
 
 }  // namespace vk
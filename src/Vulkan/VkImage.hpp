@@ -79,6 +79,9 @@ public:
 	void *getTexelPointer(const VkOffset3D &offset, const VkImageSubresourceLayers &subresource) const;
 	bool isCube() const;
 	bool is3DSlice() const;
+	// Tiled images store their texels in 4x4 tiles, like compressed blocks.
+	// Their row pitch is the size of a row of tiles.
+	bool isTiled() const { return tiled; }
 	uint8_t *end() const;
 	VkDeviceSize getLayerSize(VkImageAspectFlagBits aspect) const;
 	VkDeviceSize getMipLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLevel) const;
@@ -126,6 +129,7 @@ private:
 	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
 	VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
 	VkImageUsageFlags usage = (VkImageUsageFlags)0;
+	bool tiled = false;
 	Image *decompressedImage = nullptr;
 #ifdef __ANDROID__
 	BackingMemory backingMemory = {};
@@ -14,7 +14,14 @@
 
 #include "VkImageView.hpp"
 #include "VkImage.hpp"
+#include "Device/Blitter.hpp"
+#include "Device/Parallel.hpp"
 #include <System/Math.hpp>
+#include <System/Memory.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 namespace {
 
@@ -50,6 +57,86 @@ VkImageSubresourceRange ResolveRemainingLevelsLayers(VkImageSubresourceRange ran
 	};
 }
 
+// Returns the size of the view's hierarchical depth buffer in cells, or an
+// empty extent if it is not eligible for one.
+VkExtent2D HiZExtent(const VkImageViewCreateInfo *pCreateInfo)
+{
+	const vk::Image *image = vk::Cast(pCreateInfo->image);
+	vk::Format format(pCreateInfo->format);
+
+	if(!(pCreateInfo->subresourceRange.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) ||
+	   !format.isDepth() ||
+	   (format.getAspectFormat(VK_IMAGE_ASPECT_DEPTH_BIT) != VK_FORMAT_D32_SFLOAT) ||
+	   (image->getSampleCountFlagBits() != VK_SAMPLE_COUNT_1_BIT) ||
+	   !(image->getUsage() & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+	{
+		return { 0, 0 };
+	}
+
+	VkExtent3D extent = image->getMipLevelExtent(VK_IMAGE_ASPECT_DEPTH_BIT, pCreateInfo->subresourceRange.baseMipLevel);
+
+	return {
+		(extent.width + vk::HIZ_CELL_WIDTH - 1) / vk::HIZ_CELL_WIDTH,
+		(extent.height + vk::HIZ_CELL_HEIGHT - 1) / vk::HIZ_CELL_HEIGHT,
+	};
+}
+
+// Returns the aspect of the view whose clears can be deferred, or 0 if none.
+VkImageAspectFlags DeferredClearAspect(const VkImageViewCreateInfo *pCreateInfo)
+{
+	const vk::Image *image = vk::Cast(pCreateInfo->image);
+	vk::Format format(pCreateInfo->format);
+	VkImageSubresourceRange range = ResolveRemainingLevelsLayers(pCreateInfo->subresourceRange, image);
+
+	if((range.levelCount != 1) ||
+	   (image->getImageType() != VK_IMAGE_TYPE_2D) ||
+	   (image->getSampleCountFlagBits() != VK_SAMPLE_COUNT_1_BIT))
+	{
+		return 0;
+	}
+
+	if((range.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT) &&
+	   (image->getUsage() & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) &&
+	   vk::ImageView::SupportsDeferredClear(format))
+	{
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+
+	if((range.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) &&
+	   (image->getUsage() & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) &&
+	   vk::ImageView::SupportsDeferredClear(format.getAspectFormat(VK_IMAGE_ASPECT_DEPTH_BIT)))
+	{
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	}
+
+	return 0;
+}
+
+// Returns the number of complete deferred clear cells of the view, or an empty
+// extent if its clears can't be deferred.
+VkExtent2D ClearCellsExtent(const VkImageViewCreateInfo *pCreateInfo)
+{
+	VkImageAspectFlags aspect = DeferredClearAspect(pCreateInfo);
+
+	if(!aspect)
+	{
+		return { 0, 0 };
+	}
+
+	const vk::Image *image = vk::Cast(pCreateInfo->image);
+	VkExtent3D extent = image->getMipLevelExtent(static_cast<VkImageAspectFlagBits>(aspect), pCreateInfo->subresourceRange.baseMipLevel);
+
+	if((extent.width < vk::CLEAR_CELL_WIDTH) || (extent.height < vk::CLEAR_CELL_HEIGHT))
+	{
+		return { 0, 0 };
+	}
+
+	return {
+		extent.width / vk::CLEAR_CELL_WIDTH,
+		extent.height / vk::CLEAR_CELL_HEIGHT,
+	};
+}
+
 }  // anonymous namespace
 
 namespace vk {
@@ -63,16 +150,29 @@ ImageView::ImageView(const VkImageViewCreateInfo *pCreateInfo, void *mem, const
     , components(ResolveComponentMapping(pCreateInfo->components, format))
     , subresourceRange(ResolveRemainingLevelsLayers(pCreateInfo->subresourceRange, image))
     , ycbcrConversion(ycbcrConversion)
+    , metadata(mem)
+    , hiZExtent(HiZExtent(pCreateInfo))
+    , hiZ(hiZExtent.width ? reinterpret_cast<float *>(mem) : nullptr)
+    , clearCellsExtent(ClearCellsExtent(pCreateInfo))
+    , clearAspect(clearCellsExtent.width ? DeferredClearAspect(pCreateInfo) : 0)
+    , clearCells(clearAspect ? reinterpret_cast<uint8_t *>(mem) + hiZExtent.width * hiZExtent.height * subresourceRange.layerCount * 2 * sizeof(float) : nullptr)
 {
+	invalidateHiZ();
 }
 
 size_t ImageView::ComputeRequiredAllocationSize(const VkImageViewCreateInfo *pCreateInfo)
 {
-	return 0;
+	VkExtent2D hiZExtent = HiZExtent(pCreateInfo);
+	VkExtent2D clearCellsExtent = ClearCellsExtent(pCreateInfo);
+	uint32_t layerCount = ResolveRemainingLevelsLayers(pCreateInfo->subresourceRange, vk::Cast(pCreateInfo->image)).layerCount;
+
+	return hiZExtent.width * hiZExtent.height * layerCount * 2 * sizeof(float) +
+	       clearCellsExtent.width * clearCellsExtent.height * layerCount;
 }
 
 void ImageView::destroy(const VkAllocationCallbacks *pAllocator)
 {
+	vk::deallocate(metadata, pAllocator);
 }
 
 bool ImageView::imageTypesMatch(VkImageType imageType) const
@@ -129,8 +229,17 @@ void ImageView::clear(const VkClearValue &clearValue, const VkImageAspectFlags a
 	}
 
 	VkImageSubresourceRange sr = subresourceRange;
-	sr.aspectMask = aspectMask;
-	image->clear(clearValue, format, renderArea, sr);
+	sr.aspectMask = deferClear(clearValue, aspectMask, renderArea, 0, subresourceRange.layerCount);
+
+	if(sr.aspectMask)
+	{
+		image->clear(clearValue, format, renderArea, sr);
+	}
+
+	if(aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT)
+	{
+		clearHiZ(clearValue.depthStencil.depth, renderArea, 0, subresourceRange.layerCount);
+	}
 }
 
 void ImageView::clear(const VkClearValue &clearValue, const VkImageAspectFlags aspectMask, const VkClearRect &renderArea)
@@ -148,13 +257,21 @@ void ImageView::clear(const VkClearValue &clearValue, const VkImageAspectFlags a
 	}
 
 	VkImageSubresourceRange sr;
-	sr.aspectMask = aspectMask;
+	sr.aspectMask = deferClear(clearValue, aspectMask, renderArea.rect, renderArea.baseArrayLayer, renderArea.layerCount);
 	sr.baseMipLevel = subresourceRange.baseMipLevel;
 	sr.levelCount = subresourceRange.levelCount;
 	sr.baseArrayLayer = renderArea.baseArrayLayer + subresourceRange.baseArrayLayer;
 	sr.layerCount = renderArea.layerCount;
 
-	image->clear(clearValue, format, renderArea.rect, sr);
+	if(sr.aspectMask)
+	{
+		image->clear(clearValue, format, renderArea.rect, sr);
+	}
+
+	if(aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT)
+	{
+		clearHiZ(clearValue.depthStencil.depth, renderArea.rect, renderArea.baseArrayLayer, renderArea.layerCount);
+	}
 }
 
 void ImageView::clearWithLayerMask(const VkClearValue &clearValue, VkImageAspectFlags aspectMask, const VkRect2D &renderArea, uint32_t layerMask)
@@ -194,6 +311,10 @@ void ImageView::resolve(ImageView *resolveAttachment, int layer)
 	region.extent = image->getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask),
 	                                         subresourceRange.baseMipLevel);
 
+	// Only one layer is overwritten, so pending clears of the resolve attachment
+	// are written out first rather than discarded.
+	resolveAttachment->resolveDeferredClear();
+
 	image->copyTo(resolveAttachment->image, region);
 }
 
@@ -222,6 +343,20 @@ void ImageView::resolve(ImageView *resolveAttachment)
 	region.extent = image->getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask),
 	                                         subresourceRange.baseMipLevel);
 
+	// Pending clears of the resolve attachment must not be written over the
+	// resolved pixels. They are all overwritten, unless the resolve attachment
+	// is larger than this one.
+	VkExtent3D resolveExtent = resolveAttachment->getMipLevelExtent(0);
+	if((region.extent.width >= resolveExtent.width) && (region.extent.height >= resolveExtent.height) &&
+	   (subresourceRange.layerCount >= resolveAttachment->subresourceRange.layerCount))
+	{
+		resolveAttachment->discardDeferredClear();
+	}
+	else
+	{
+		resolveAttachment->resolveDeferredClear();
+	}
+
 	image->copyTo(resolveAttachment->image, region);
 }
 
@@ -235,6 +370,236 @@ void ImageView::resolveWithLayerMask(ImageView *resolveAttachment, uint32_t laye
 	}
 }
 
+float *ImageView::getHiZPointer(uint32_t layer) const
+{
+	if(!hiZ)
+	{
+		return nullptr;
+	}
+
+	return hiZ + layer * hiZExtent.width * hiZExtent.height * 2;
+}
+
+void ImageView::invalidateHiZ()
+{
+	if(hiZ)
+	{
+		size_t count = hiZExtent.width * hiZExtent.height * subresourceRange.layerCount;
+
+		for(size_t i = 0; i < count; i++)
+		{
+			hiZ[2 * i + 0] = -std::numeric_limits<float>::infinity();
+			hiZ[2 * i + 1] = std::numeric_limits<float>::infinity();
+		}
+	}
+}
+
+void ImageView::clearHiZ(float depth, const VkRect2D &rect, uint32_t baseLayer, uint32_t layerCount)
+{
+	if(!hiZ)
+	{
+		return;
+	}
+
+	VkExtent3D extent = getMipLevelExtent(0);
+
+	int x0 = rect.offset.x;
+	int y0 = rect.offset.y;
+	int x1 = std::min(x0 + static_cast<int>(rect.extent.width), static_cast<int>(extent.width));
+	int y1 = std::min(y0 + static_cast<int>(rect.extent.height), static_cast<int>(extent.height));
+
+	for(uint32_t layer = baseLayer; layer < baseLayer + layerCount; layer++)
+	{
+		float *cells = getHiZPointer(layer);
+
+		for(int cy = y0 / HIZ_CELL_HEIGHT; cy * HIZ_CELL_HEIGHT < y1; cy++)
+		{
+			for(int cx = x0 / HIZ_CELL_WIDTH; cx * HIZ_CELL_WIDTH < x1; cx++)
+			{
+				float *cell = cells + 2 * (cy * hiZExtent.width + cx);
+
+				// Cells only partially covered by the clear keep their other pixels,
+				// and incomplete cells at the edges of the image remain unknown.
+				bool covered = (cx * HIZ_CELL_WIDTH >= x0) && ((cx + 1) * HIZ_CELL_WIDTH <= x1) &&
+				               (cy * HIZ_CELL_HEIGHT >= y0) && ((cy + 1) * HIZ_CELL_HEIGHT <= y1);
+
+				if(covered)
+				{
+					cell[0] = depth;
+					cell[1] = depth;
+				}
+				else
+				{
+					cell[0] = std::min(cell[0], depth);
+					cell[1] = std::max(cell[1], depth);
+				}
+			}
+		}
+	}
+}
+
+bool ImageView::SupportsDeferredClear(VkFormat format)
+{
+	switch(format)
+	{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+		case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+uint8_t *ImageView::getClearCellsPointer(uint32_t layer) const
+{
+	if(!clearCells)
+	{
+		return nullptr;
+	}
+
+	return clearCells + layer * clearCellsExtent.width * clearCellsExtent.height;
+}
+
+VkImageAspectFlags ImageView::deferClear(const VkClearValue &clearValue, VkImageAspectFlags aspectMask, const VkRect2D &rect, uint32_t baseLayer, uint32_t layerCount)
+{
+	if(!(aspectMask & clearAspect))
+	{
+		return aspectMask;
+	}
+
+	VkExtent3D extent = getMipLevelExtent(0);
+
+	bool covered = (rect.offset.x <= 0) && (rect.offset.y <= 0) &&
+	               (rect.offset.x + static_cast<int64_t>(rect.extent.width) >= extent.width) &&
+	               (rect.offset.y + static_cast<int64_t>(rect.extent.height) >= extent.height);
+
+	uint32_t pixel = 0;
+
+	if(clearAspect == VK_IMAGE_ASPECT_COLOR_BIT)
+	{
+		float color[4];
+		for(int i = 0; i < 4; i++)
+		{
+			color[i] = format.isUnsignedNormalized() ? sw::clamp(clearValue.color.float32[i], 0.0f, 1.0f) : clearValue.color.float32[i];
+		}
+
+		covered = covered && sw::Blitter::packClearColor(color, format, pixel);
+	}
+	else
+	{
+		memcpy(&pixel, &clearValue.depthStencil.depth, sizeof(pixel));
+	}
+
+	// Cells still pending with another value, or partially overwritten by this
+	// clear, must be written out first.
+	if(clearPending && (!covered || (pixel != clearPixel)))
+	{
+		resolveDeferredClear();
+	}
+
+	if(!covered)
+	{
+		return aspectMask;
+	}
+
+	for(uint32_t layer = baseLayer; layer < baseLayer + layerCount; layer++)
+	{
+		memset(getClearCellsPointer(layer), 1, clearCellsExtent.width * clearCellsExtent.height);
+	}
+
+	clearPixel = pixel;
+	clearPending = true;
+
+	// The incomplete cells at the right and bottom edges are cleared right away.
+	VkImageSubresourceRange sr = {
+		clearAspect,
+		subresourceRange.baseMipLevel,
+		1,
+		subresourceRange.baseArrayLayer + baseLayer,
+		layerCount
+	};
+
+	uint32_t x1 = clearCellsExtent.width * CLEAR_CELL_WIDTH;
+	uint32_t y1 = clearCellsExtent.height * CLEAR_CELL_HEIGHT;
+
+	if(x1 < extent.width)
+	{
+		image->clear(clearValue, format, { { static_cast<int32_t>(x1), 0 }, { extent.width - x1, extent.height } }, sr);
+	}
+
+	if(y1 < extent.height)
+	{
+		image->clear(clearValue, format, { { 0, static_cast<int32_t>(y1) }, { x1, extent.height - y1 } }, sr);
+	}
+
+	return aspectMask & ~clearAspect;
+}
+
+void ImageView::resolveDeferredClear()
+{
+	if(!clearPending)
+	{
+		return;
+	}
+
+	VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(clearAspect);
+	int pitchB = rowPitchBytes(aspect, 0);
+	uint32_t width = clearCellsExtent.width;
+	uint32_t pixel = clearPixel;
+
+	for(uint32_t layer = 0; layer < subresourceRange.layerCount; layer++)
+	{
+		uint8_t *cells = getClearCellsPointer(layer);
+		uint8_t *pixels = static_cast<uint8_t *>(getOffsetPointer({ 0, 0, 0 }, aspect, 0, layer));
+
+		sw::parallelFor(clearCellsExtent.height, width * CLEAR_CELL_WIDTH * CLEAR_CELL_HEIGHT * sizeof(uint32_t), [&](uint32_t begin, uint32_t end) {
+			for(uint32_t cy = begin; cy < end; cy++)
+			{
+				uint8_t *row = cells + cy * width;
+
+				// Write each run of consecutive pending cells at once.
+				for(uint32_t cx = 0; cx < width;)
+				{
+					if(!row[cx])
+					{
+						cx++;
+						continue;
+					}
+
+					uint32_t runEnd = cx;
+					while((runEnd < width) && row[runEnd])
+					{
+						row[runEnd++] = 0;
+					}
+
+					for(int y = 0; y < CLEAR_CELL_HEIGHT; y++)
+					{
+						uint32_t *p = reinterpret_cast<uint32_t *>(pixels + (cy * CLEAR_CELL_HEIGHT + y) * pitchB);
+						sw::clear(p + cx * CLEAR_CELL_WIDTH, pixel, (runEnd - cx) * CLEAR_CELL_WIDTH);
+					}
+
+					cx = runEnd;
+				}
+			}
+		});
+	}
+
+	clearPending = false;
+}
+
+void ImageView::discardDeferredClear()
+{
+	if(clearPending)
+	{
+		memset(clearCells, 0, clearCellsExtent.width * clearCellsExtent.height * subresourceRange.layerCount);
+		clearPending = false;
+	}
+}
+
 const Image *ImageView::getImage(Usage usage) const
 {
 	switch(usage)
@@ -58,6 +58,7 @@ public:
 	int getMipLevelSize(VkImageAspectFlagBits aspect, uint32_t mipLevel, Usage usage = RAW) const;
 	int layerPitchBytes(VkImageAspectFlagBits aspect, Usage usage = RAW) const;
 	VkExtent3D getMipLevelExtent(uint32_t mipLevel) const;
+	bool isTiled() const { return image->isTiled(); }
 
 	int getSampleCount() const
 	{
@@ -77,6 +78,30 @@ public:
 
 	void prepareForSampling() const { image->prepareForSampling(subresourceRange); }
 
+	// Hierarchical depth buffer, holding the { min, max } depth of each
+	// HIZ_CELL_WIDTH x HIZ_CELL_HEIGHT pixel cell. It is only maintained for
+	// single-sampled 32-bit float depth attachments, and only within a render
+	// pass instance. Cells which are not known are { -inf, +inf }.
+	float *getHiZPointer(uint32_t layer) const;
+	int hiZPitchBytes() const { return hiZExtent.width * 2 * sizeof(float); }
+	void invalidateHiZ();
+
+	// Deferred clears. Clearing all of a single-sampled, single-level color
+	// attachment of one of the SupportsDeferredClear() formats, or the depth
+	// aspect of a 32-bit float depth attachment, only marks its complete
+	// CLEAR_CELL_WIDTH x CLEAR_CELL_HEIGHT cells as pending, with one byte per
+	// cell. The pixel routines write the clear pixel to pending cells the first
+	// time they touch them, and the remaining ones are written by
+	// resolveDeferredClear() before the render pass instance ends.
+	static bool SupportsDeferredClear(VkFormat format);
+	bool hasDeferredClear() const { return clearPending; }
+	uint8_t *getClearCellsPointer(uint32_t layer) const;
+	int clearCellsPitchBytes() const { return clearCellsExtent.width; }
+	VkExtent2D getClearCellsExtent() const { return clearCellsExtent; }
+	uint32_t getClearPixel() const { return clearPixel; }
+	void resolveDeferredClear();
+	void discardDeferredClear();
+
 	const VkComponentMapping &getComponentMapping() const { return components; }
 	const VkImageSubresourceRange &getSubresourceRange() const { return subresourceRange; }
 	size_t getImageSizeInBytes() const { return image->getMemoryRequirements().size; }
@@ -89,6 +114,8 @@ private:
 
 	bool imageTypesMatch(VkImageType imageType) const;
 	const Image *getImage(Usage usage) const;
+	void clearHiZ(float depth, const VkRect2D &rect, uint32_t baseLayer, uint32_t layerCount);
+	VkImageAspectFlags deferClear(const VkClearValue &clearValue, VkImageAspectFlags aspectMask, const VkRect2D &rect, uint32_t baseLayer, uint32_t layerCount);
 
 	Image *const image = nullptr;
 	const VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
@@ -97,6 +124,17 @@ private:
 	const VkImageSubresourceRange subresourceRange = {};
 
 	const vk::SamplerYcbcrConversion *ycbcrConversion = nullptr;
+
+	void *const metadata = nullptr;  // Holds the hierarchical depth buffer, then the clear cells
+
+	const VkExtent2D hiZExtent = {};  // In cells, including the incomplete ones at the edges
+	float *const hiZ = nullptr;
+
+	const VkExtent2D clearCellsExtent = {};  // In cells, excluding the incomplete ones at the edges
+	const VkImageAspectFlags clearAspect = 0;
+	uint8_t *const clearCells = nullptr;
+	uint32_t clearPixel = 0;
+	bool clearPending = false;
 };
 
 // TODO(b/132437008): Also used by SamplerYcbcrConversion. Move somewhere centrally?
@@ -15,6 +15,7 @@
 #include "VkPhysicalDevice.hpp"
 
 #include "VkConfig.h"
+#include "VkPipelineCache.hpp"
 #include "Pipeline/SpirvShader.hpp"  // sw::SIMD::Width
 #include "Reactor/Reactor.hpp"
 
@@ -304,11 +305,13 @@ const VkPhysicalDeviceProperties &PhysicalDevice::getProperties() const
 			DEVICE_ID,
 			VK_PHYSICAL_DEVICE_TYPE_CPU,  // deviceType
 			"",                           // deviceName
-			SWIFTSHADER_UUID,             // pipelineCacheUUID
+			{},                           // pipelineCacheUUID
 			getLimits(),                  // limits
 			{}                            // sparseProperties
 		};
 
+		memcpy(properties.pipelineCacheUUID, PipelineCache::GetUUID(), VK_UUID_SIZE);
+
 		// Append Reactor JIT backend name and version
 		snprintf(properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE,
 		         "%s (%s)", SWIFTSHADER_DEVICE_NAME, rr::BackendName().c_str());
@@ -23,7 +23,9 @@
 #include "Pipeline/ComputeProgram.hpp"
 #include "Pipeline/SpirvShader.hpp"
 
+#include "marl/scheduler.h"
 #include "marl/trace.h"
+#include "marl/waitgroup.h"
 
 #include "spirv-tools/optimizer.hpp"
 
@@ -216,17 +218,49 @@ std::vector<uint32_t> preprocessSpirv(
 	return optimized;
 }
 
+// getPreprocessedSpirv returns preprocessSpirv() of the key's code, using the
+// pipeline cache's binaries (which may have been loaded from a previous
+// process' vkGetPipelineCacheData) when available.
+std::vector<uint32_t> getPreprocessedSpirv(
+    const vk::PipelineCache::SpirvShaderKey &key,
+    vk::PipelineCache *pipelineCache)
+{
+	if(!pipelineCache)
+	{
+		return preprocessSpirv(key.getInsns(), key.getSpecializationInfo(), true);
+	}
+
+	const vk::PipelineCache::SpirvBinaryKey binaryKey(key.getInsns(), key.getSpecializationInfo());
+	{
+		std::unique_lock<std::mutex> lock(pipelineCache->getBinaryMutex());
+		const std::vector<uint32_t> *binary = (*pipelineCache)[binaryKey];
+		if(binary)
+		{
+			return *binary;
+		}
+	}
+
+	auto code = preprocessSpirv(key.getInsns(), key.getSpecializationInfo(), true);
+
+	{
+		std::unique_lock<std::mutex> lock(pipelineCache->getBinaryMutex());
+		pipelineCache->insert(binaryKey, code);
+	}
+
+	return code;
+}
+
 std::shared_ptr<sw::SpirvShader> createShader(
     const vk::PipelineCache::SpirvShaderKey &key,
     const vk::ShaderModule *module,
     bool robustBufferAccess,
-    const std::shared_ptr<vk::dbg::Context> &dbgctx)
+    const std::shared_ptr<vk::dbg::Context> &dbgctx,
+    vk::PipelineCache *pipelineCache)
 {
 	// Do not optimize the shader if we have a debugger context.
 	// Optimization passes are likely to damage debug information, and reorder
 	// instructions.
-	const bool optimize = !dbgctx;
-
+	//
 	// TODO(b/147726513): Do not preprocess the shader if we have a debugger
 	// context.
 	// This is a work-around for the SPIR-V tools incorrectly reporting errors
@@ -235,7 +269,7 @@ std::shared_ptr<sw::SpirvShader> createShader(
 	// https://github.com/KhronosGroup/SPIRV-Tools/issues/3102
 	// https://github.com/KhronosGroup/SPIRV-Tools/issues/3103
 	// https://github.com/KhronosGroup/SPIRV-Tools/issues/3118
-	auto code = dbgctx ? key.getInsns() : preprocessSpirv(key.getInsns(), key.getSpecializationInfo(), optimize);
+	auto code = dbgctx ? key.getInsns() : getPreprocessedSpirv(key, pipelineCache);
 	ASSERT(code.size() > 0);
 
 	// If the pipeline has specialization constants, assume they're unique and
@@ -504,6 +538,8 @@ GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo *pCreateIn
 
 void GraphicsPipeline::destroyPipeline(const VkAllocationCallbacks *pAllocator)
 {
+	context.precompiledRoutines = nullptr;
+	precompiledRoutines.reset();
 	vertexShader.reset();
 	fragmentShader.reset();
 }
@@ -572,7 +608,7 @@ void GraphicsPipeline::compileShaders(const VkAllocationCallbacks *pAllocator, c
 				const std::shared_ptr<sw::SpirvShader> *spirvShader = pipelineCache[key];
 				if(!spirvShader)
 				{
-					auto shader = createShader(key, module, robustBufferAccess, device->getDebuggerContext());
+					auto shader = createShader(key, module, robustBufferAccess, device->getDebuggerContext(), pPipelineCache);
 					setShader(pipelineStage, shader);
 					pipelineCache.insert(key, getShader(pipelineStage));
 				}
@@ -584,10 +620,87 @@ void GraphicsPipeline::compileShaders(const VkAllocationCallbacks *pAllocator, c
 		}
 		else
 		{
-			auto shader = createShader(key, module, robustBufferAccess, device->getDebuggerContext());
+			auto shader = createShader(key, module, robustBufferAccess, device->getDebuggerContext(), nullptr);
 			setShader(pipelineStage, shader);
 		}
 	}
+
+	if(PRECOMPILE_DRAW_ROUTINES)
+	{
+		precompileRoutines(pCreateInfo);
+	}
+}
+
+void GraphicsPipeline::precompileRoutines(const VkGraphicsPipelineCreateInfo *pCreateInfo)
+{
+	MARL_SCOPED_EVENT("GraphicsPipeline::precompileRoutines");
+
+	if(!vertexShader || !device->getScheduler())
+	{
+		return;
+	}
+
+	// The routine states depend on the attachment formats, which the render
+	// pass already provides. Dynamic state is assumed to keep the pipeline's
+	// values, and occlusion queries to be inactive. Draws which end up with
+	// different states fall back to the renderer's routine caches.
+	sw::Context ctx = context;
+
+	const RenderPass *renderPass = vk::Cast(pCreateInfo->renderPass);
+	const VkSubpassDescription &subpass = renderPass->getSubpass(pCreateInfo->subpass);
+
+	for(uint32_t i = 0; i < subpass.colorAttachmentCount; i++)
+	{
+		uint32_t attachment = subpass.pColorAttachments[i].attachment;
+		if(attachment != VK_ATTACHMENT_UNUSED)
+		{
+			ctx.renderTargetFormat[i] = renderPass->getAttachment(attachment).format;
+		}
+	}
+
+	if(subpass.pDepthStencilAttachment && (subpass.pDepthStencilAttachment->attachment != VK_ATTACHMENT_UNUSED))
+	{
+		vk::Format format = renderPass->getAttachment(subpass.pDepthStencilAttachment->attachment).format;
+		if(format.isDepth())
+		{
+			ctx.depthBufferFormat = format;
+		}
+		if(format.isStencil())
+		{
+			ctx.stencilBufferFormat = format;
+		}
+	}
+
+	precompiledRoutines.reset(new sw::PrecompiledRoutines());
+	auto routines = precompiledRoutines.get();
+
+	routines->vertexState = sw::VertexProcessor::update(&ctx);
+	routines->setupState = sw::SetupProcessor::update(&ctx);
+	routines->pixelState = sw::PixelProcessor::update(&ctx);
+
+	// Descriptor sets are only read at draw time, so the routines do not depend
+	// on the ones bound here.
+	const vk::DescriptorSet::Bindings descriptorSets = {};
+
+	marl::WaitGroup wg(3);
+	auto scheduler = device->getScheduler();
+
+	scheduler->enqueue(marl::Task([&] {
+		routines->vertexRoutine = sw::VertexProcessor::generate(routines->vertexState, ctx.pipelineLayout, ctx.vertexShader, descriptorSets);
+		wg.done();
+	}));
+	scheduler->enqueue(marl::Task([&] {
+		routines->setupRoutine = sw::SetupProcessor::generate(routines->setupState);
+		wg.done();
+	}));
+	scheduler->enqueue(marl::Task([&] {
+		routines->pixelRoutine = sw::PixelProcessor::generate(routines->pixelState, ctx.pipelineLayout, ctx.pixelShader, descriptorSets);
+		wg.done();
+	}));
+
+	wg.wait();
+
+	context.precompiledRoutines = routines;
 }
 
 uint32_t GraphicsPipeline::computePrimitiveCount(uint32_t vertexCount) const
@@ -672,7 +785,7 @@ void ComputePipeline::compileShaders(const VkAllocationCallbacks *pAllocator, co
 			const std::shared_ptr<sw::SpirvShader> *spirvShader = pipelineCache[shaderKey];
 			if(!spirvShader)
 			{
-				shader = createShader(shaderKey, module, robustBufferAccess, device->getDebuggerContext());
+				shader = createShader(shaderKey, module, robustBufferAccess, device->getDebuggerContext(), pPipelineCache);
 				pipelineCache.insert(shaderKey, shader);
 			}
 			else
@@ -698,7 +811,7 @@ void ComputePipeline::compileShaders(const VkAllocationCallbacks *pAllocator, co
 	}
 	else
 	{
-		shader = createShader(shaderKey, module, robustBufferAccess, device->getDebuggerContext());
+		shader = createShader(shaderKey, module, robustBufferAccess, device->getDebuggerContext(), nullptr);
 		const PipelineCache::ComputeProgramKey programKey(shader.get(), layout);
 		program = createProgram(programKey);
 	}
@@ -708,13 +821,15 @@ void ComputePipeline::run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t bas
                           uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
                           vk::DescriptorSet::Bindings const &descriptorSets,
                           vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
-                          sw::PushConstantStorage const &pushConstants)
+                          sw::PushConstantStorage const &pushConstants,
+                          marl::Ticket::Queue *tickets)
 {
 	ASSERT_OR_RETURN(program != nullptr);
 	program->run(
 	    descriptorSets, descriptorDynamicOffsets, pushConstants,
 	    baseGroupX, baseGroupY, baseGroupZ,
-	    groupCountX, groupCountY, groupCountZ);
+	    groupCountX, groupCountY, groupCountZ,
+	    tickets);
 }
 
 }  // namespace vk
@@ -109,8 +109,10 @@ public:
 private:
 	void setShader(const VkShaderStageFlagBits &stage, const std::shared_ptr<sw::SpirvShader> spirvShader);
 	const std::shared_ptr<sw::SpirvShader> getShader(const VkShaderStageFlagBits &stage) const;
+	void precompileRoutines(const VkGraphicsPipelineCreateInfo *pCreateInfo);
 	std::shared_ptr<sw::SpirvShader> vertexShader;
 	std::shared_ptr<sw::SpirvShader> fragmentShader;
+	std::unique_ptr<sw::PrecompiledRoutines> precompiledRoutines;
 
 	uint32_t dynamicStateFlags = 0;
 	bool primitiveRestartEnable = false;
@@ -143,7 +145,8 @@ public:
 	         uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
 	         vk::DescriptorSet::Bindings const &descriptorSets,
 	         vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
-	         sw::PushConstantStorage const &pushConstants);
+	         sw::PushConstantStorage const &pushConstants,
+	         marl::Ticket::Queue *tickets);
 
 protected:
 	std::shared_ptr<sw::SpirvShader> shader;
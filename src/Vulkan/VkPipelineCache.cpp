@@ -13,6 +13,13 @@
 // limitations under the License.
 
 #include "VkPipelineCache.hpp"
+
+#include "System/Math.hpp"
+
+#include "spirv-tools/libspirv.h"
+
+#include <algorithm>
+#include <array>
 #include <cstring>
 
 namespace vk {
@@ -153,6 +160,62 @@ bool PipelineCache::SpirvShaderKey::operator<(const SpirvShaderKey &other) const
 	return (specializationInfo < other.specializationInfo);
 }
 
+PipelineCache::SpirvBinaryKey::SpirvBinaryKey(const std::vector<uint32_t> &insns,
+                                              const VkSpecializationInfo *specializationInfo)
+    : insns(insns)
+{
+	if(specializationInfo)
+	{
+		mapEntries.assign(specializationInfo->pMapEntries,
+		                  specializationInfo->pMapEntries + specializationInfo->mapEntryCount);
+
+		auto data = reinterpret_cast<const uint8_t *>(specializationInfo->pData);
+		specializationData.assign(data, data + specializationInfo->dataSize);
+	}
+}
+
+PipelineCache::SpirvBinaryKey::SpirvBinaryKey(std::vector<uint32_t> &&insns,
+                                              std::vector<VkSpecializationMapEntry> &&mapEntries,
+                                              std::vector<uint8_t> &&specializationData)
+    : insns(std::move(insns))
+    , mapEntries(std::move(mapEntries))
+    , specializationData(std::move(specializationData))
+{
+}
+
+bool PipelineCache::SpirvBinaryKey::operator<(const SpirvBinaryKey &other) const
+{
+	if(insns.size() != other.insns.size())
+	{
+		return insns.size() < other.insns.size();
+	}
+
+	if(mapEntries.size() != other.mapEntries.size())
+	{
+		return mapEntries.size() < other.mapEntries.size();
+	}
+
+	if(specializationData.size() != other.specializationData.size())
+	{
+		return specializationData.size() < other.specializationData.size();
+	}
+
+	int cmp = memcmp(insns.data(), other.insns.data(), insns.size() * sizeof(uint32_t));
+	if(cmp != 0)
+	{
+		return cmp < 0;
+	}
+
+	cmp = memcmp(mapEntries.data(), other.mapEntries.data(), mapEntries.size() * sizeof(VkSpecializationMapEntry));
+	if(cmp != 0)
+	{
+		return cmp < 0;
+	}
+
+	cmp = memcmp(specializationData.data(), other.specializationData.data(), specializationData.size());
+	return cmp < 0;
+}
+
 PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo *pCreateInfo, void *mem)
     : dataSize(ComputeRequiredAllocationSize(pCreateInfo))
     , data(reinterpret_cast<uint8_t *>(mem))
@@ -162,11 +225,11 @@ PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo *pCreateInfo, void
 	header->headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
 	header->vendorID = VENDOR_ID;
 	header->deviceID = DEVICE_ID;
-	memcpy(header->pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE);
+	memcpy(header->pipelineCacheUUID, GetUUID(), VK_UUID_SIZE);
 
 	if(pCreateInfo->pInitialData && (pCreateInfo->initialDataSize > 0))
 	{
-		memcpy(data + sizeof(CacheHeader), pCreateInfo->pInitialData, pCreateInfo->initialDataSize);
+		loadData(reinterpret_cast<const uint8_t *>(pCreateInfo->pInitialData), pCreateInfo->initialDataSize);
 	}
 }
 
@@ -183,28 +246,167 @@ void PipelineCache::destroy(const VkAllocationCallbacks *pAllocator)
 
 size_t PipelineCache::ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo *pCreateInfo)
 {
-	return pCreateInfo->initialDataSize + sizeof(CacheHeader);
+	return sizeof(CacheHeader);
+}
+
+const uint8_t *PipelineCache::GetUUID()
+{
+	// The version and revision identify the build. The SPIR-V Tools version and
+	// PIPELINE_CACHE_VERSION identify the preprocessing which produced the cached
+	// binaries.
+	static const std::array<uint64_t, 2> uuid = [] {
+		std::string build = SWIFTSHADER_UUID " " VERSION_STRING "." REVISION_STRING;
+		std::string preprocessing = std::string(spvSoftwareVersionDetailsString()) + " " + std::to_string(PIPELINE_CACHE_VERSION);
+
+		return std::array<uint64_t, 2>{ {
+			sw::FNV_1a(reinterpret_cast<const unsigned char *>(build.data()), static_cast<int>(build.size())),
+			sw::FNV_1a(reinterpret_cast<const unsigned char *>(preprocessing.data()), static_cast<int>(preprocessing.size())),
+		} };
+	}();
+	static_assert(sizeof(uuid) == VK_UUID_SIZE, "pipelineCacheUUID size mismatch");
+
+	return reinterpret_cast<const uint8_t *>(uuid.data());
+}
+
+void PipelineCache::loadData(const uint8_t *initialData, size_t initialDataSize)
+{
+	// Data from an incompatible implementation, or from any other build of
+	// this one, is silently ignored, as required by the specification.
+	if(initialDataSize < sizeof(CacheHeader) ||
+	   memcmp(initialData, data, sizeof(CacheHeader)) != 0)
+	{
+		return;
+	}
+
+	const uint8_t *ptr = initialData + sizeof(CacheHeader);
+	const uint8_t *end = initialData + initialDataSize;
+
+	while(static_cast<size_t>(end - ptr) >= sizeof(BinaryHeader))
+	{
+		BinaryHeader header;
+		memcpy(&header, ptr, sizeof(header));
+		ptr += sizeof(header);
+
+		size_t insnsSize = size_t(header.insnCount) * sizeof(uint32_t);
+		size_t mapEntriesSize = size_t(header.mapEntryCount) * sizeof(VkSpecializationMapEntry);
+		size_t specializationDataSize = (size_t(header.specializationDataSize) + 3) & ~size_t(3);
+		size_t binarySize = size_t(header.binaryCount) * sizeof(uint32_t);
+
+		size_t entrySize = insnsSize + mapEntriesSize + specializationDataSize + binarySize;
+		if(static_cast<size_t>(end - ptr) < entrySize)
+		{
+			return;  // Truncated entry.
+		}
+
+		if(sw::FNV_1a(ptr, static_cast<int>(entrySize)) != header.checksum)
+		{
+			ptr += entrySize;  // Corrupt entry.
+			continue;
+		}
+
+		std::vector<uint32_t> insns(header.insnCount);
+		memcpy(insns.data(), ptr, insnsSize);
+		ptr += insnsSize;
+
+		std::vector<VkSpecializationMapEntry> mapEntries(header.mapEntryCount);
+		memcpy(mapEntries.data(), ptr, mapEntriesSize);
+		ptr += mapEntriesSize;
+
+		std::vector<uint8_t> specializationData(ptr, ptr + header.specializationDataSize);
+		ptr += specializationDataSize;
+
+		std::vector<uint32_t> binary(header.binaryCount);
+		memcpy(binary.data(), ptr, binarySize);
+		ptr += binarySize;
+
+		SpirvBinaryKey key(std::move(insns), std::move(mapEntries), std::move(specializationData));
+		spirvBinaries.emplace(std::move(key), std::move(binary));
+	}
+}
+
+size_t PipelineCache::serializedSize(const SpirvBinaryKey &key, const std::vector<uint32_t> &binary)
+{
+	return sizeof(BinaryHeader) +
+	       key.getInsns().size() * sizeof(uint32_t) +
+	       key.getMapEntries().size() * sizeof(VkSpecializationMapEntry) +
+	       ((key.getSpecializationData().size() + 3) & ~size_t(3)) +
+	       binary.size() * sizeof(uint32_t);
+}
+
+void PipelineCache::serialize(const SpirvBinaryKey &key, const std::vector<uint32_t> &binary, uint8_t *dst)
+{
+	BinaryHeader header;
+	header.insnCount = static_cast<uint32_t>(key.getInsns().size());
+	header.mapEntryCount = static_cast<uint32_t>(key.getMapEntries().size());
+	header.specializationDataSize = static_cast<uint32_t>(key.getSpecializationData().size());
+	header.binaryCount = static_cast<uint32_t>(binary.size());
+
+	uint8_t *entry = dst + sizeof(header);
+	dst = entry;
+
+	size_t insnsSize = key.getInsns().size() * sizeof(uint32_t);
+	memcpy(dst, key.getInsns().data(), insnsSize);
+	dst += insnsSize;
+
+	size_t mapEntriesSize = key.getMapEntries().size() * sizeof(VkSpecializationMapEntry);
+	memcpy(dst, key.getMapEntries().data(), mapEntriesSize);
+	dst += mapEntriesSize;
+
+	size_t specializationDataSize = key.getSpecializationData().size();
+	size_t paddedSize = (specializationDataSize + 3) & ~size_t(3);
+	memcpy(dst, key.getSpecializationData().data(), specializationDataSize);
+	memset(dst + specializationDataSize, 0, paddedSize - specializationDataSize);
+	dst += paddedSize;
+
+	size_t binarySize = binary.size() * sizeof(uint32_t);
+	memcpy(dst, binary.data(), binarySize);
+	dst += binarySize;
+
+	header.checksum = sw::FNV_1a(entry, static_cast<int>(dst - entry));
+	memcpy(entry - sizeof(header), &header, sizeof(header));
 }
 
 VkResult PipelineCache::getData(size_t *pDataSize, void *pData)
 {
+	std::unique_lock<std::mutex> lock(spirvBinariesMutex);
+
 	if(!pData)
 	{
-		*pDataSize = dataSize;
+		size_t size = dataSize;
+		for(auto &it : spirvBinaries)
+		{
+			size += serializedSize(it.first, it.second);
+		}
+
+		*pDataSize = size;
 		return VK_SUCCESS;
 	}
 
-	if(*pDataSize != dataSize)
+	if(*pDataSize < dataSize)
 	{
 		*pDataSize = 0;
 		return VK_INCOMPLETE;
 	}
 
-	if(*pDataSize > 0)
+	// Write as many complete entries as fit.
+	uint8_t *dst = reinterpret_cast<uint8_t *>(pData);
+	size_t written = dataSize;
+	memcpy(dst, data, dataSize);
+
+	for(auto &it : spirvBinaries)
 	{
-		memcpy(pData, data, *pDataSize);
+		size_t size = serializedSize(it.first, it.second);
+		if(written + size > *pDataSize)
+		{
+			*pDataSize = written;
+			return VK_INCOMPLETE;
+		}
+
+		serialize(it.first, it.second, dst + written);
+		written += size;
 	}
 
+	*pDataSize = written;
 	return VK_SUCCESS;
 }
 
@@ -214,6 +416,11 @@ VkResult PipelineCache::merge(uint32_t srcCacheCount, const VkPipelineCache *pSr
 	{
 		PipelineCache *srcCache = Cast(pSrcCaches[i]);
 
+		{
+			std::unique_lock<std::mutex> lock(spirvBinariesMutex);
+			spirvBinaries.insert(srcCache->spirvBinaries.begin(), srcCache->spirvBinaries.end());
+		}
+
 		{
 			std::unique_lock<std::mutex> lock(spirvShadersMutex);
 			spirvShaders.insert(srcCache->spirvShaders.begin(), srcCache->spirvShaders.end());
@@ -228,6 +435,17 @@ VkResult PipelineCache::merge(uint32_t srcCacheCount, const VkPipelineCache *pSr
 	return VK_SUCCESS;
 }
 
+const std::vector<uint32_t> *PipelineCache::operator[](const PipelineCache::SpirvBinaryKey &key) const
+{
+	auto it = spirvBinaries.find(key);
+	return (it != spirvBinaries.end()) ? &(it->second) : nullptr;
+}
+
+void PipelineCache::insert(const PipelineCache::SpirvBinaryKey &key, const std::vector<uint32_t> &binary)
+{
+	spirvBinaries[key] = binary;
+}
+
 const std::shared_ptr<sw::SpirvShader> *PipelineCache::operator[](const PipelineCache::SpirvShaderKey &key) const
 {
 	auto it = spirvShaders.find(key);
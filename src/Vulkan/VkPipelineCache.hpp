@@ -46,6 +46,10 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo *pCreateInfo);
 
+	// Identifies this build of the library and of the SPIR-V preprocessing, so
+	// that cache data written by any other build is rejected.
+	static const uint8_t *GetUUID();
+
 	VkResult getData(size_t *pDataSize, void *pData);
 	VkResult merge(uint32_t srcCacheCount, const VkPipelineCache *pSrcCaches);
 
@@ -93,6 +97,33 @@ public:
 		const SpecializationInfo specializationInfo;
 	};
 
+	// SpirvBinaryKey identifies the preprocessed SPIR-V of a shader module with
+	// its specialization constants applied. Unlike SpirvShaderKey it holds no
+	// process-local pointers, so these entries are serialized by getData().
+	struct SpirvBinaryKey
+	{
+		SpirvBinaryKey(const std::vector<uint32_t> &insns,
+		               const VkSpecializationInfo *specializationInfo);
+		SpirvBinaryKey(std::vector<uint32_t> &&insns,
+		               std::vector<VkSpecializationMapEntry> &&mapEntries,
+		               std::vector<uint8_t> &&specializationData);
+
+		bool operator<(const SpirvBinaryKey &other) const;
+
+		const std::vector<uint32_t> &getInsns() const { return insns; }
+		const std::vector<VkSpecializationMapEntry> &getMapEntries() const { return mapEntries; }
+		const std::vector<uint8_t> &getSpecializationData() const { return specializationData; }
+
+	private:
+		std::vector<uint32_t> insns;
+		std::vector<VkSpecializationMapEntry> mapEntries;
+		std::vector<uint8_t> specializationData;
+	};
+
+	std::mutex &getBinaryMutex() { return spirvBinariesMutex; }
+	const std::vector<uint32_t> *operator[](const PipelineCache::SpirvBinaryKey &key) const;
+	void insert(const PipelineCache::SpirvBinaryKey &key, const std::vector<uint32_t> &binary);
+
 	std::mutex &getShaderMutex() { return spirvShadersMutex; }
 	const std::shared_ptr<sw::SpirvShader> *operator[](const PipelineCache::SpirvShaderKey &key) const;
 	void insert(const PipelineCache::SpirvShaderKey &key, const std::shared_ptr<sw::SpirvShader> &shader);
@@ -131,9 +162,29 @@ private:
 		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
 	};
 
+	// Serialized SpirvBinaryKey and binary, following the CacheHeader. The
+	// instructions, map entries, specialization data (padded to a multiple of
+	// 4 bytes) and the preprocessed binary follow each BinaryHeader, and the
+	// checksum covers all of them.
+	struct BinaryHeader
+	{
+		uint32_t insnCount;
+		uint32_t mapEntryCount;
+		uint32_t specializationDataSize;
+		uint32_t binaryCount;
+		uint64_t checksum;
+	};
+
+	void loadData(const uint8_t *initialData, size_t initialDataSize);
+	static size_t serializedSize(const SpirvBinaryKey &key, const std::vector<uint32_t> &binary);
+	static void serialize(const SpirvBinaryKey &key, const std::vector<uint32_t> &binary, uint8_t *dst);
+
 	size_t dataSize = 0;
 	uint8_t *data = nullptr;
 
+	std::mutex spirvBinariesMutex;
+	std::map<SpirvBinaryKey, std::vector<uint32_t>> spirvBinaries;
+
 	std::mutex spirvShadersMutex;
 	std::map<SpirvShaderKey, std::shared_ptr<sw::SpirvShader>> spirvShaders;
 
@@ -139,6 +139,13 @@ void Queue::submitQueue(const Task &task)
 			}
 		}
 
+		if(submitInfo.signalSemaphoreCount > 0)
+		{
+			// Draw calls and compute dispatches complete asynchronously, and
+			// have to be done before the semaphores signal.
+			renderer->synchronize();
+		}
+
 		for(uint32_t j = 0; j < submitInfo.signalSemaphoreCount; j++)
 		{
 			vk::Cast(submitInfo.pSignalSemaphores[j])->signal();
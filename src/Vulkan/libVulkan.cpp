@@ -76,6 +76,8 @@
 #include "System/CPUID.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <map>
 #include <string>
@@ -130,6 +132,21 @@ void setCPUDefaults()
 	sw::CPUID::setEnableSSE(true);
 }
 
+// Returns the number of worker threads of the scheduler. It defaults to one per
+// logical CPU, and can be overridden with the SWIFTSHADER_WORKER_THREADS
+// environment variable.
+int getWorkerThreadCount()
+{
+	int count = static_cast<int>(marl::Thread::numLogicalCPUs());
+
+	if(const char *env = getenv("SWIFTSHADER_WORKER_THREADS"))
+	{
+		count = atoi(env);
+	}
+
+	return std::min(std::max(count, 1), vk::MAX_WORKER_THREADS);
+}
+
 std::shared_ptr<marl::Scheduler> getOrCreateScheduler()
 {
 	static std::mutex mutex;
@@ -139,11 +156,25 @@ std::shared_ptr<marl::Scheduler> getOrCreateScheduler()
 	if(!scheduler)
 	{
 		scheduler = std::make_shared<marl::Scheduler>();
-		scheduler->setThreadInitializer([] {
+
+		// Pinning the worker threads keeps them on the NUMA node of the memory
+		// they first touched. It's opt-in, as processes sharing the machine
+		// would otherwise pin their workers to the same CPUs. Setting
+		// SWIFTSHADER_PIN_WORKER_THREADS to a non-zero value enables it.
+		const char *pinEnv = getenv("SWIFTSHADER_PIN_WORKER_THREADS");
+		bool pinWorkers = pinEnv && (atoi(pinEnv) != 0);
+		auto nextWorker = std::make_shared<std::atomic<int>>(0);
+
+		scheduler->setThreadInitializer([pinWorkers, nextWorker] {
 			sw::CPUID::setFlushToZero(true);
 			sw::CPUID::setDenormalsAreZero(true);
+
+			if(pinWorkers)
+			{
+				sw::CPUID::pinCurrentThread((*nextWorker)++);
+			}
 		});
-		scheduler->setWorkerThreadCount(std::min<size_t>(marl::Thread::numLogicalCPUs(), 16));
+		scheduler->setWorkerThreadCount(getWorkerThreadCount());
 		schedulerWeak = scheduler;
 	}
 	return scheduler;
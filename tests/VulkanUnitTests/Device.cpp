@@ -181,6 +181,334 @@ void Device::DestroyBuffer(VkBuffer buffer) const
 	driver->vkDestroyBuffer(device, buffer, nullptr);
 }
 
+VkResult Device::CreateTransferBuffer(
+    VkDeviceMemory memory, VkDeviceSize size,
+    VkDeviceSize offset, VkBuffer *out) const
+{
+	const VkBufferCreateInfo info = {
+		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,  // sType
+		nullptr,                               // pNext
+		0,                                     // flags
+		size,                                  // size
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+		    VK_BUFFER_USAGE_TRANSFER_DST_BIT,  // usage
+		VK_SHARING_MODE_EXCLUSIVE,             // sharingMode
+		0,                                     // queueFamilyIndexCount
+		nullptr,                               // pQueueFamilyIndices
+	};
+
+	VkBuffer buffer;
+	VkResult result = driver->vkCreateBuffer(device, &info, 0, &buffer);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	result = driver->vkBindBufferMemory(device, buffer, memory, offset);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	*out = buffer;
+	return VK_SUCCESS;
+}
+
+VkResult Device::CreateTransferImage(
+    VkFormat format, uint32_t width, uint32_t height,
+    VkImage *out, VkDeviceMemory *outMemory) const
+{
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		VK_IMAGE_TYPE_2D,                     // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		1,                                    // mipLevels
+		1,                                    // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+		    VK_IMAGE_USAGE_TRANSFER_DST_BIT,  // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return CreateImage(info, out, outMemory);
+}
+
+VkResult Device::CreateSampledImage(
+    VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels,
+    VkImage *out, VkDeviceMemory *outMemory, VkImageType imageType) const
+{
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		imageType,                            // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		mipLevels,                            // mipLevels
+		1,                                    // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		VK_IMAGE_USAGE_SAMPLED_BIT |
+		    VK_IMAGE_USAGE_TRANSFER_DST_BIT,  // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return CreateImage(info, out, outMemory);
+}
+
+VkResult Device::CreateAttachmentImage(
+    VkFormat format, uint32_t width, uint32_t height,
+    VkSampleCountFlagBits samples,
+    VkImage *out, VkDeviceMemory *outMemory) const
+{
+	const VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		VK_IMAGE_TYPE_2D,                     // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		1,                                    // mipLevels
+		1,                                    // arrayLayers
+		samples,                              // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+		    VK_IMAGE_USAGE_TRANSFER_SRC_BIT,  // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return CreateImage(info, out, outMemory);
+}
+
+VkResult Device::CreateImage(const VkImageCreateInfo &info, VkImage *out, VkDeviceMemory *outMemory) const
+{
+	VkImage image;
+	VkResult result = driver->vkCreateImage(device, &info, 0, &image);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	VkMemoryRequirements requirements;
+	driver->vkGetImageMemoryRequirements(device, image, &requirements);
+
+	VkDeviceMemory memory;
+	result = AllocateMemory(requirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memory);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	result = driver->vkBindImageMemory(device, image, memory, 0);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	*out = image;
+	*outMemory = memory;
+	return VK_SUCCESS;
+}
+
+void Device::DestroyImage(VkImage image) const
+{
+	driver->vkDestroyImage(device, image, nullptr);
+}
+
+VkResult Device::CreateImageView(VkImage image, VkFormat format, VkImageView *out,
+                                 uint32_t mipLevels) const
+{
+	const VkImageViewCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,  // sType
+		nullptr,                                   // pNext
+		0,                                         // flags
+		image,                                     // image
+		VK_IMAGE_VIEW_TYPE_2D,                     // viewType
+		format,                                    // format
+		{
+		    // components
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // r
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // g
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // b
+		    VK_COMPONENT_SWIZZLE_IDENTITY,  // a
+		},
+		{
+		    // subresourceRange
+		    VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+		    0,                          // baseMipLevel
+		    mipLevels,                  // levelCount
+		    0,                          // baseArrayLayer
+		    1,                          // layerCount
+		},
+	};
+
+	return driver->vkCreateImageView(device, &info, 0, out);
+}
+
+void Device::DestroyImageView(VkImageView imageView) const
+{
+	driver->vkDestroyImageView(device, imageView, nullptr);
+}
+
+VkResult Device::CreateSampler(VkSampler *out) const
+{
+	const VkSamplerCreateInfo info = {
+		VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,    // sType
+		nullptr,                                  // pNext
+		0,                                        // flags
+		VK_FILTER_NEAREST,                        // magFilter
+		VK_FILTER_NEAREST,                        // minFilter
+		VK_SAMPLER_MIPMAP_MODE_NEAREST,           // mipmapMode
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeU
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeV
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeW
+		0.0f,                                     // mipLodBias
+		VK_FALSE,                                 // anisotropyEnable
+		1.0f,                                     // maxAnisotropy
+		VK_FALSE,                                 // compareEnable
+		VK_COMPARE_OP_NEVER,                      // compareOp
+		0.0f,                                     // minLod
+		VK_LOD_CLAMP_NONE,                        // maxLod
+		VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,  // borderColor
+		VK_FALSE,                                 // unnormalizedCoordinates
+	};
+
+	return driver->vkCreateSampler(device, &info, 0, out);
+}
+
+void Device::DestroySampler(VkSampler sampler) const
+{
+	driver->vkDestroySampler(device, sampler, nullptr);
+}
+
+VkResult Device::CreateVertexBuffer(
+    VkDeviceMemory memory, VkDeviceSize size,
+    VkDeviceSize offset, VkBuffer *out) const
+{
+	const VkBufferCreateInfo info = {
+		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,  // sType
+		nullptr,                               // pNext
+		0,                                     // flags
+		size,                                  // size
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,     // usage
+		VK_SHARING_MODE_EXCLUSIVE,             // sharingMode
+		0,                                     // queueFamilyIndexCount
+		nullptr,                               // pQueueFamilyIndices
+	};
+
+	VkBuffer buffer;
+	VkResult result = driver->vkCreateBuffer(device, &info, 0, &buffer);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	result = driver->vkBindBufferMemory(device, buffer, memory, offset);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	*out = buffer;
+	return VK_SUCCESS;
+}
+
+VkResult Device::CreateIndexBuffer(
+    VkDeviceMemory memory, VkDeviceSize size,
+    VkDeviceSize offset, VkBuffer *out) const
+{
+	const VkBufferCreateInfo info = {
+		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,  // sType
+		nullptr,                               // pNext
+		0,                                     // flags
+		size,                                  // size
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT,      // usage
+		VK_SHARING_MODE_EXCLUSIVE,             // sharingMode
+		0,                                     // queueFamilyIndexCount
+		nullptr,                               // pQueueFamilyIndices
+	};
+
+	VkBuffer buffer;
+	VkResult result = driver->vkCreateBuffer(device, &info, 0, &buffer);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	result = driver->vkBindBufferMemory(device, buffer, memory, offset);
+	if(result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	*out = buffer;
+	return VK_SUCCESS;
+}
+
+VkResult Device::CreateRenderPass(
+    const std::vector<VkAttachmentDescription> &attachments,
+    const VkSubpassDescription &subpass,
+    VkRenderPass *out) const
+{
+	const VkRenderPassCreateInfo info = {
+		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,  // sType
+		nullptr,                                    // pNext
+		0,                                          // flags
+		(uint32_t)attachments.size(),               // attachmentCount
+		attachments.data(),                         // pAttachments
+		1,                                          // subpassCount
+		&subpass,                                   // pSubpasses
+		0,                                          // dependencyCount
+		nullptr,                                    // pDependencies
+	};
+
+	return driver->vkCreateRenderPass(device, &info, 0, out);
+}
+
+void Device::DestroyRenderPass(VkRenderPass renderPass) const
+{
+	driver->vkDestroyRenderPass(device, renderPass, nullptr);
+}
+
+VkResult Device::CreateFramebuffer(
+    VkRenderPass renderPass,
+    const std::vector<VkImageView> &attachments,
+    uint32_t width, uint32_t height,
+    VkFramebuffer *out) const
+{
+	const VkFramebufferCreateInfo info = {
+		VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,  // sType
+		nullptr,                                    // pNext
+		0,                                          // flags
+		renderPass,                                 // renderPass
+		(uint32_t)attachments.size(),               // attachmentCount
+		attachments.data(),                         // pAttachments
+		width,                                      // width
+		height,                                     // height
+		1,                                          // layers
+	};
+
+	return driver->vkCreateFramebuffer(device, &info, 0, out);
+}
+
+void Device::DestroyFramebuffer(VkFramebuffer framebuffer) const
+{
+	driver->vkDestroyFramebuffer(device, framebuffer, nullptr);
+}
+
 VkResult Device::CreateShaderModule(
     const std::vector<uint32_t> &spirv, VkShaderModule *out) const
 {
@@ -242,7 +570,7 @@ void Device::DestroyPipelineLayout(VkPipelineLayout pipelineLayout) const
 
 VkResult Device::CreateComputePipeline(
     VkShaderModule module, VkPipelineLayout pipelineLayout,
-    VkPipeline *out) const
+    VkPipeline *out, VkPipelineCache pipelineCache) const
 {
 	VkComputePipelineCreateInfo info = {
 		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,  // sType
@@ -263,7 +591,175 @@ VkResult Device::CreateComputePipeline(
 		0,               // basePipelineIndex
 	};
 
-	return driver->vkCreateComputePipelines(device, 0, 1, &info, 0, out);
+	return driver->vkCreateComputePipelines(device, pipelineCache, 1, &info, 0, out);
+}
+
+VkResult Device::CreateGraphicsPipeline(
+    VkShaderModule vertexModule, VkShaderModule fragmentModule,
+    VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+    VkSampleCountFlagBits samples, uint32_t width, uint32_t height,
+    VkPipeline *out) const
+{
+	const VkPipelineShaderStageCreateInfo stages[] = {
+		{
+		    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,  // sType
+		    nullptr,                                              // pNext
+		    0,                                                    // flags
+		    VK_SHADER_STAGE_VERTEX_BIT,                           // stage
+		    vertexModule,                                         // module
+		    "main",                                               // pName
+		    nullptr,                                              // pSpecializationInfo
+		},
+		{
+		    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,  // sType
+		    nullptr,                                              // pNext
+		    0,                                                    // flags
+		    VK_SHADER_STAGE_FRAGMENT_BIT,                         // stage
+		    fragmentModule,                                       // module
+		    "main",                                               // pName
+		    nullptr,                                              // pSpecializationInfo
+		},
+	};
+
+	const VkVertexInputBindingDescription binding = {
+		0,                            // binding
+		6 * sizeof(float),            // stride
+		VK_VERTEX_INPUT_RATE_VERTEX,  // inputRate
+	};
+
+	const VkVertexInputAttributeDescription attributes[] = {
+		{
+		    0,                        // location
+		    0,                        // binding
+		    VK_FORMAT_R32G32_SFLOAT,  // format
+		    0,                        // offset
+		},
+		{
+		    1,                              // location
+		    0,                              // binding
+		    VK_FORMAT_R32G32B32A32_SFLOAT,  // format
+		    2 * sizeof(float),              // offset
+		},
+	};
+
+	const VkPipelineVertexInputStateCreateInfo vertexInputState = {
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,  // sType
+		nullptr,                                                    // pNext
+		0,                                                          // flags
+		1,                                                          // vertexBindingDescriptionCount
+		&binding,                                                   // pVertexBindingDescriptions
+		2,                                                          // vertexAttributeDescriptionCount
+		attributes,                                                 // pVertexAttributeDescriptions
+	};
+
+	const VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,  // sType
+		nullptr,                                                      // pNext
+		0,                                                            // flags
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,                          // topology
+		VK_FALSE,                                                     // primitiveRestartEnable
+	};
+
+	const VkViewport viewport = {
+		0.0f,           // x
+		0.0f,           // y
+		float(width),   // width
+		float(height),  // height
+		0.0f,           // minDepth
+		1.0f,           // maxDepth
+	};
+
+	const VkRect2D scissor = {
+		{ 0, 0 },           // offset
+		{ width, height },  // extent
+	};
+
+	const VkPipelineViewportStateCreateInfo viewportState = {
+		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,  // sType
+		nullptr,                                                // pNext
+		0,                                                      // flags
+		1,                                                      // viewportCount
+		&viewport,                                              // pViewports
+		1,                                                      // scissorCount
+		&scissor,                                               // pScissors
+	};
+
+	const VkPipelineRasterizationStateCreateInfo rasterizationState = {
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,  // sType
+		nullptr,                                                     // pNext
+		0,                                                           // flags
+		VK_FALSE,                                                    // depthClampEnable
+		VK_FALSE,                                                    // rasterizerDiscardEnable
+		VK_POLYGON_MODE_FILL,                                        // polygonMode
+		VK_CULL_MODE_NONE,                                           // cullMode
+		VK_FRONT_FACE_COUNTER_CLOCKWISE,                             // frontFace
+		VK_FALSE,                                                    // depthBiasEnable
+		0.0f,                                                        // depthBiasConstantFactor
+		0.0f,                                                        // depthBiasClamp
+		0.0f,                                                        // depthBiasSlopeFactor
+		1.0f,                                                        // lineWidth
+	};
+
+	const VkPipelineMultisampleStateCreateInfo multisampleState = {
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,  // sType
+		nullptr,                                                   // pNext
+		0,                                                         // flags
+		samples,                                                   // rasterizationSamples
+		VK_FALSE,                                                  // sampleShadingEnable
+		0.0f,                                                      // minSampleShading
+		nullptr,                                                   // pSampleMask
+		VK_FALSE,                                                  // alphaToCoverageEnable
+		VK_FALSE,                                                  // alphaToOneEnable
+	};
+
+	const VkPipelineColorBlendAttachmentState blendAttachment = {
+		VK_FALSE,                      // blendEnable
+		VK_BLEND_FACTOR_ONE,           // srcColorBlendFactor
+		VK_BLEND_FACTOR_ZERO,          // dstColorBlendFactor
+		VK_BLEND_OP_ADD,               // colorBlendOp
+		VK_BLEND_FACTOR_ONE,           // srcAlphaBlendFactor
+		VK_BLEND_FACTOR_ZERO,          // dstAlphaBlendFactor
+		VK_BLEND_OP_ADD,               // alphaBlendOp
+		VK_COLOR_COMPONENT_R_BIT |
+		    VK_COLOR_COMPONENT_G_BIT |
+		    VK_COLOR_COMPONENT_B_BIT |
+		    VK_COLOR_COMPONENT_A_BIT,  // colorWriteMask
+	};
+
+	const VkPipelineColorBlendStateCreateInfo colorBlendState = {
+		VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,  // sType
+		nullptr,                                                   // pNext
+		0,                                                         // flags
+		VK_FALSE,                                                  // logicOpEnable
+		VK_LOGIC_OP_COPY,                                          // logicOp
+		1,                                                         // attachmentCount
+		&blendAttachment,                                          // pAttachments
+		{ 0.0f, 0.0f, 0.0f, 0.0f },                                // blendConstants
+	};
+
+	const VkGraphicsPipelineCreateInfo info = {
+		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,  // sType
+		nullptr,                                          // pNext
+		0,                                                // flags
+		2,                                                // stageCount
+		stages,                                           // pStages
+		&vertexInputState,                                // pVertexInputState
+		&inputAssemblyState,                              // pInputAssemblyState
+		nullptr,                                          // pTessellationState
+		&viewportState,                                   // pViewportState
+		&rasterizationState,                              // pRasterizationState
+		&multisampleState,                                // pMultisampleState
+		nullptr,                                          // pDepthStencilState
+		&colorBlendState,                                 // pColorBlendState
+		nullptr,                                          // pDynamicState
+		pipelineLayout,                                   // layout
+		renderPass,                                       // renderPass
+		0,                                                // subpass
+		0,                                                // basePipelineHandle
+		0,                                                // basePipelineIndex
+	};
+
+	return driver->vkCreateGraphicsPipelines(device, 0, 1, &info, 0, out);
 }
 
 void Device::DestroyPipeline(VkPipeline pipeline) const
@@ -271,6 +767,32 @@ void Device::DestroyPipeline(VkPipeline pipeline) const
 	driver->vkDestroyPipeline(device, pipeline, nullptr);
 }
 
+VkResult Device::CreatePipelineCache(
+    const std::vector<uint8_t> &initialData,
+    VkPipelineCache *out) const
+{
+	const VkPipelineCacheCreateInfo info = {
+		VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,  // sType
+		nullptr,                                       // pNext
+		0,                                             // flags
+		initialData.size(),                            // initialDataSize
+		initialData.data(),                            // pInitialData
+	};
+
+	return driver->vkCreatePipelineCache(device, &info, nullptr, out);
+}
+
+VkResult Device::GetPipelineCacheData(VkPipelineCache pipelineCache,
+                                      size_t *pDataSize, void *pData) const
+{
+	return driver->vkGetPipelineCacheData(device, pipelineCache, pDataSize, pData);
+}
+
+void Device::DestroyPipelineCache(VkPipelineCache pipelineCache) const
+{
+	driver->vkDestroyPipelineCache(device, pipelineCache, nullptr);
+}
+
 VkResult Device::CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
                                                    VkDescriptorPool *out) const
 {
@@ -291,6 +813,21 @@ VkResult Device::CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
 	return driver->vkCreateDescriptorPool(device, &info, 0, out);
 }
 
+VkResult Device::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize> &sizes,
+                                      VkDescriptorPool *out) const
+{
+	VkDescriptorPoolCreateInfo info = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,  // sType
+		nullptr,                                        // pNext
+		0,                                              // flags
+		1,                                              // maxSets
+		static_cast<uint32_t>(sizes.size()),            // poolSizeCount
+		sizes.data(),                                   // pPoolSizes
+	};
+
+	return driver->vkCreateDescriptorPool(device, &info, 0, out);
+}
+
 void Device::DestroyDescriptorPool(VkDescriptorPool descriptorPool) const
 {
 	driver->vkDestroyDescriptorPool(device, descriptorPool, nullptr);
@@ -336,6 +873,32 @@ void Device::UpdateStorageBufferDescriptorSets(
 	driver->vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, nullptr);
 }
 
+void Device::UpdateCombinedImageSamplerDescriptorSet(
+    VkDescriptorSet descriptorSet, uint32_t binding,
+    VkImageView imageView, VkSampler sampler) const
+{
+	VkDescriptorImageInfo imageInfo = {
+		sampler,                                   // sampler
+		imageView,                                 // imageView
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  // imageLayout
+	};
+
+	VkWriteDescriptorSet write = {
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,     // sType
+		nullptr,                                    // pNext
+		descriptorSet,                              // dstSet
+		binding,                                    // dstBinding
+		0,                                          // dstArrayElement
+		1,                                          // descriptorCount
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // descriptorType
+		&imageInfo,                                 // pImageInfo
+		nullptr,                                    // pBufferInfo
+		nullptr,                                    // pTexelBufferView
+	};
+
+	driver->vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
 VkResult Device::AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDeviceMemory *out) const
 {
 	VkPhysicalDeviceMemoryProperties properties;
@@ -49,6 +49,84 @@ public:
 	// DestroyBuffer destroys a VkBuffer.
 	void DestroyBuffer(VkBuffer buffer) const;
 
+	// CreateTransferBuffer creates a new buffer with the
+	// VK_BUFFER_USAGE_TRANSFER_SRC_BIT and VK_BUFFER_USAGE_TRANSFER_DST_BIT
+	// usages, and VK_SHARING_MODE_EXCLUSIVE sharing mode.
+	VkResult CreateTransferBuffer(VkDeviceMemory memory, VkDeviceSize size,
+	                              VkDeviceSize offset, VkBuffer *out) const;
+
+	// CreateTransferImage creates a new optimally tiled 2D image, with a single
+	// mip level and array layer, and the VK_IMAGE_USAGE_TRANSFER_SRC_BIT and
+	// VK_IMAGE_USAGE_TRANSFER_DST_BIT usages. Memory satisfying the image's
+	// requirements is allocated and bound to it.
+	VkResult CreateTransferImage(VkFormat format, uint32_t width, uint32_t height,
+	                             VkImage *out, VkDeviceMemory *outMemory) const;
+
+	// CreateAttachmentImage creates a new optimally tiled 2D image, with a
+	// single mip level and array layer, and the
+	// VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT and VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+	// usages. Memory satisfying the image's requirements is allocated and bound
+	// to it.
+	VkResult CreateAttachmentImage(VkFormat format, uint32_t width, uint32_t height,
+	                               VkSampleCountFlagBits samples,
+	                               VkImage *out, VkDeviceMemory *outMemory) const;
+
+	// CreateSampledImage creates a new optimally tiled image of imageType, with
+	// mipLevels mip levels and a single array layer or depth slice, and the
+	// VK_IMAGE_USAGE_SAMPLED_BIT and VK_IMAGE_USAGE_TRANSFER_DST_BIT usages.
+	// Memory satisfying the image's requirements is allocated and bound to it.
+	VkResult CreateSampledImage(VkFormat format, uint32_t width, uint32_t height,
+	                            uint32_t mipLevels,
+	                            VkImage *out, VkDeviceMemory *outMemory,
+	                            VkImageType imageType = VK_IMAGE_TYPE_2D) const;
+
+	// DestroyImage destroys a VkImage.
+	void DestroyImage(VkImage image) const;
+
+	// CreateImageView creates a new 2D view of the color aspect of the first
+	// mipLevels mip levels of image.
+	VkResult CreateImageView(VkImage image, VkFormat format, VkImageView *out,
+	                         uint32_t mipLevels = 1) const;
+
+	// DestroyImageView destroys a VkImageView.
+	void DestroyImageView(VkImageView imageView) const;
+
+	// CreateSampler creates a new sampler with nearest filtering and mipmap
+	// selection, clamp to edge addressing, and no level of detail clamping.
+	VkResult CreateSampler(VkSampler *out) const;
+
+	// DestroySampler destroys a VkSampler.
+	void DestroySampler(VkSampler sampler) const;
+
+	// CreateVertexBuffer creates a new buffer with the
+	// VK_BUFFER_USAGE_VERTEX_BUFFER_BIT usage, and VK_SHARING_MODE_EXCLUSIVE
+	// sharing mode.
+	VkResult CreateVertexBuffer(VkDeviceMemory memory, VkDeviceSize size,
+	                            VkDeviceSize offset, VkBuffer *out) const;
+
+	// CreateIndexBuffer creates a new buffer with the
+	// VK_BUFFER_USAGE_INDEX_BUFFER_BIT usage, and VK_SHARING_MODE_EXCLUSIVE
+	// sharing mode.
+	VkResult CreateIndexBuffer(VkDeviceMemory memory, VkDeviceSize size,
+	                           VkDeviceSize offset, VkBuffer *out) const;
+
+	// CreateRenderPass creates a new render pass with a single subpass.
+	VkResult CreateRenderPass(const std::vector<VkAttachmentDescription> &attachments,
+	                          const VkSubpassDescription &subpass,
+	                          VkRenderPass *out) const;
+
+	// DestroyRenderPass destroys a VkRenderPass.
+	void DestroyRenderPass(VkRenderPass renderPass) const;
+
+	// CreateFramebuffer creates a new single layer framebuffer.
+	VkResult CreateFramebuffer(VkRenderPass renderPass,
+	                           const std::vector<VkImageView> &attachments,
+	                           uint32_t width, uint32_t height,
+	                           VkFramebuffer *out) const;
+
+	// DestroyFramebuffer destroys a VkFramebuffer.
+	void DestroyFramebuffer(VkFramebuffer framebuffer) const;
+
 	// CreateShaderModule creates a new shader module with the given SPIR-V
 	// code.
 	VkResult CreateShaderModule(const std::vector<uint32_t> &spirv,
@@ -74,19 +152,51 @@ public:
 	void DestroyPipelineLayout(VkPipelineLayout pipelineLayout) const;
 
 	// CreateComputePipeline creates a new compute pipeline with the entry point
-	// "main".
+	// "main", using pipelineCache if it isn't VK_NULL_HANDLE.
 	VkResult CreateComputePipeline(VkShaderModule module,
 	                               VkPipelineLayout pipelineLayout,
-	                               VkPipeline *out) const;
+	                               VkPipeline *out,
+	                               VkPipelineCache pipelineCache = VK_NULL_HANDLE) const;
+
+	// CreateGraphicsPipeline creates a new pipeline drawing triangle lists with
+	// the entry points "main", for subpass 0 of renderPass. Vertices consist of
+	// a vec2 position at location 0 followed by a vec4 color at location 1.
+	// The viewport and scissor cover width x height pixels, and blending is
+	// disabled.
+	VkResult CreateGraphicsPipeline(VkShaderModule vertexModule,
+	                                VkShaderModule fragmentModule,
+	                                VkPipelineLayout pipelineLayout,
+	                                VkRenderPass renderPass,
+	                                VkSampleCountFlagBits samples,
+	                                uint32_t width, uint32_t height,
+	                                VkPipeline *out) const;
 
 	// DestroyPipeline destroys a graphics or compute pipeline.
 	void DestroyPipeline(VkPipeline pipeline) const;
 
+	// CreatePipelineCache creates a new pipeline cache, initialized with
+	// initialData.
+	VkResult CreatePipelineCache(const std::vector<uint8_t> &initialData,
+	                             VkPipelineCache *out) const;
+
+	// GetPipelineCacheData wraps vkGetPipelineCacheData, supplying the first
+	// VkDevice parameter.
+	VkResult GetPipelineCacheData(VkPipelineCache pipelineCache,
+	                              size_t *pDataSize, void *pData) const;
+
+	// DestroyPipelineCache destroys a VkPipelineCache.
+	void DestroyPipelineCache(VkPipelineCache pipelineCache) const;
+
 	// CreateStorageBufferDescriptorPool creates a new descriptor pool that can
 	// hold descriptorCount storage buffers.
 	VkResult CreateStorageBufferDescriptorPool(uint32_t descriptorCount,
 	                                           VkDescriptorPool *out) const;
 
+	// CreateDescriptorPool creates a new descriptor pool that can hold a
+	// single set with the given descriptors.
+	VkResult CreateDescriptorPool(const std::vector<VkDescriptorPoolSize> &sizes,
+	                              VkDescriptorPool *out) const;
+
 	// DestroyDescriptorPool destroys the VkDescriptorPool.
 	void DestroyDescriptorPool(VkDescriptorPool descriptorPool) const;
 
@@ -101,6 +211,11 @@ public:
 	void UpdateStorageBufferDescriptorSets(VkDescriptorSet descriptorSet,
 	                                       const std::vector<VkDescriptorBufferInfo> &bufferInfos) const;
 
+	// UpdateCombinedImageSamplerDescriptorSet updates the combined image
+	// sampler at binding in descriptorSet to sample imageView with sampler.
+	void UpdateCombinedImageSamplerDescriptorSet(VkDescriptorSet descriptorSet, uint32_t binding,
+	                                             VkImageView imageView, VkSampler sampler) const;
+
 	// AllocateMemory allocates size bytes from a memory heap that has all the
 	// given flag bits set.
 	// If memory could not be allocated from any heap then
@@ -146,6 +261,8 @@ public:
 private:
 	Device(Driver const *driver, VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
 
+	VkResult CreateImage(const VkImageCreateInfo &info, VkImage *out, VkDeviceMemory *outMemory) const;
+
 	static std::vector<VkQueueFamilyProperties>
 	GetPhysicalDeviceQueueFamilyProperties(
 	    Driver const *driver, VkPhysicalDevice device);
@@ -23,10 +23,28 @@ VK_INSTANCE(vkAllocateMemory, VkResult, VkDevice, const VkMemoryAllocateInfo *,
             VkDeviceMemory *);
 VK_INSTANCE(vkBeginCommandBuffer, VkResult, VkCommandBuffer, const VkCommandBufferBeginInfo *);
 VK_INSTANCE(vkBindBufferMemory, VkResult, VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize);
+VK_INSTANCE(vkBindImageMemory, VkResult, VkDevice, VkImage, VkDeviceMemory, VkDeviceSize);
+VK_INSTANCE(vkCmdBeginRenderPass, void, VkCommandBuffer, const VkRenderPassBeginInfo *, VkSubpassContents);
 VK_INSTANCE(vkCmdBindDescriptorSets, void, VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t,
             const VkDescriptorSet *, uint32_t, const uint32_t *);
+VK_INSTANCE(vkCmdBindIndexBuffer, void, VkCommandBuffer, VkBuffer, VkDeviceSize, VkIndexType);
 VK_INSTANCE(vkCmdBindPipeline, void, VkCommandBuffer, VkPipelineBindPoint, VkPipeline);
+VK_INSTANCE(vkCmdBindVertexBuffers, void, VkCommandBuffer, uint32_t, uint32_t, const VkBuffer *, const VkDeviceSize *);
+VK_INSTANCE(vkCmdBlitImage, void, VkCommandBuffer, VkImage, VkImageLayout, VkImage, VkImageLayout, uint32_t,
+            const VkImageBlit *, VkFilter);
+VK_INSTANCE(vkCmdClearColorImage, void, VkCommandBuffer, VkImage, VkImageLayout, const VkClearColorValue *, uint32_t,
+            const VkImageSubresourceRange *);
+VK_INSTANCE(vkCmdCopyBufferToImage, void, VkCommandBuffer, VkBuffer, VkImage, VkImageLayout, uint32_t,
+            const VkBufferImageCopy *);
+VK_INSTANCE(vkCmdCopyImageToBuffer, void, VkCommandBuffer, VkImage, VkImageLayout, VkBuffer, uint32_t,
+            const VkBufferImageCopy *);
 VK_INSTANCE(vkCmdDispatch, void, VkCommandBuffer, uint32_t, uint32_t, uint32_t);
+VK_INSTANCE(vkCmdDraw, void, VkCommandBuffer, uint32_t, uint32_t, uint32_t, uint32_t);
+VK_INSTANCE(vkCmdDrawIndexed, void, VkCommandBuffer, uint32_t, uint32_t, uint32_t, int32_t, uint32_t);
+VK_INSTANCE(vkCmdEndRenderPass, void, VkCommandBuffer);
+VK_INSTANCE(vkCmdPipelineBarrier, void, VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags,
+            uint32_t, const VkMemoryBarrier *, uint32_t, const VkBufferMemoryBarrier *, uint32_t,
+            const VkImageMemoryBarrier *);
 VK_INSTANCE(vkCreateBuffer, VkResult, VkDevice, const VkBufferCreateInfo *, const VkAllocationCallbacks *, VkBuffer *);
 VK_INSTANCE(vkCreateCommandPool, VkResult, VkDevice, const VkCommandPoolCreateInfo *, const VkAllocationCallbacks *,
             VkCommandPool *);
@@ -38,8 +56,20 @@ VK_INSTANCE(vkCreateDescriptorSetLayout, VkResult, VkDevice, const VkDescriptorS
             const VkAllocationCallbacks *, VkDescriptorSetLayout *);
 VK_INSTANCE(vkCreateDevice, VkResult, VkPhysicalDevice, const VkDeviceCreateInfo *, const VkAllocationCallbacks *,
             VkDevice *);
+VK_INSTANCE(vkCreateFramebuffer, VkResult, VkDevice, const VkFramebufferCreateInfo *, const VkAllocationCallbacks *,
+            VkFramebuffer *);
+VK_INSTANCE(vkCreateGraphicsPipelines, VkResult, VkDevice, VkPipelineCache, uint32_t, const VkGraphicsPipelineCreateInfo *,
+            const VkAllocationCallbacks *, VkPipeline *);
+VK_INSTANCE(vkCreateImage, VkResult, VkDevice, const VkImageCreateInfo *, const VkAllocationCallbacks *, VkImage *);
+VK_INSTANCE(vkCreateImageView, VkResult, VkDevice, const VkImageViewCreateInfo *, const VkAllocationCallbacks *,
+            VkImageView *);
+VK_INSTANCE(vkCreatePipelineCache, VkResult, VkDevice, const VkPipelineCacheCreateInfo *, const VkAllocationCallbacks *,
+            VkPipelineCache *);
 VK_INSTANCE(vkCreatePipelineLayout, VkResult, VkDevice, const VkPipelineLayoutCreateInfo *, const VkAllocationCallbacks *,
             VkPipelineLayout *);
+VK_INSTANCE(vkCreateRenderPass, VkResult, VkDevice, const VkRenderPassCreateInfo *, const VkAllocationCallbacks *,
+            VkRenderPass *);
+VK_INSTANCE(vkCreateSampler, VkResult, VkDevice, const VkSamplerCreateInfo *, const VkAllocationCallbacks *, VkSampler *);
 VK_INSTANCE(vkCreateShaderModule, VkResult, VkDevice, const VkShaderModuleCreateInfo *, const VkAllocationCallbacks *,
             VkShaderModule *);
 VK_INSTANCE(vkDestroyBuffer, void, VkDevice, VkBuffer, const VkAllocationCallbacks *);
@@ -47,19 +77,27 @@ VK_INSTANCE(vkDestroyCommandPool, void, VkDevice, VkCommandPool, const VkAllocat
 VK_INSTANCE(vkDestroyDescriptorPool, void, VkDevice, VkDescriptorPool, const VkAllocationCallbacks *);
 VK_INSTANCE(vkDestroyDescriptorSetLayout, void, VkDevice, VkDescriptorSetLayout, const VkAllocationCallbacks *);
 VK_INSTANCE(vkDestroyDevice, VkResult, VkDevice, const VkAllocationCallbacks *);
+VK_INSTANCE(vkDestroyFramebuffer, void, VkDevice, VkFramebuffer, const VkAllocationCallbacks *);
+VK_INSTANCE(vkDestroyImage, void, VkDevice, VkImage, const VkAllocationCallbacks *);
+VK_INSTANCE(vkDestroyImageView, void, VkDevice, VkImageView, const VkAllocationCallbacks *);
 VK_INSTANCE(vkDestroyInstance, void, VkInstance, const VkAllocationCallbacks *);
 VK_INSTANCE(vkDestroyPipeline, void, VkDevice, VkPipeline, const VkAllocationCallbacks *);
+VK_INSTANCE(vkDestroyPipelineCache, void, VkDevice, VkPipelineCache, const VkAllocationCallbacks *);
 VK_INSTANCE(vkDestroyPipelineLayout, void, VkDevice, VkPipelineLayout, const VkAllocationCallbacks *);
+VK_INSTANCE(vkDestroyRenderPass, void, VkDevice, VkRenderPass, const VkAllocationCallbacks *);
+VK_INSTANCE(vkDestroySampler, void, VkDevice, VkSampler, const VkAllocationCallbacks *);
 VK_INSTANCE(vkDestroyShaderModule, void, VkDevice, VkShaderModule, const VkAllocationCallbacks *);
 VK_INSTANCE(vkEndCommandBuffer, VkResult, VkCommandBuffer);
 VK_INSTANCE(vkEnumeratePhysicalDevices, VkResult, VkInstance, uint32_t *, VkPhysicalDevice *);
 VK_INSTANCE(vkFreeCommandBuffers, void, VkDevice, VkCommandPool, uint32_t, const VkCommandBuffer *);
 VK_INSTANCE(vkFreeMemory, void, VkDevice, VkDeviceMemory, const VkAllocationCallbacks *);
 VK_INSTANCE(vkGetDeviceQueue, void, VkDevice, uint32_t, uint32_t, VkQueue *);
+VK_INSTANCE(vkGetImageMemoryRequirements, void, VkDevice, VkImage, VkMemoryRequirements *);
 VK_INSTANCE(vkGetPhysicalDeviceMemoryProperties, void, VkPhysicalDevice, VkPhysicalDeviceMemoryProperties *);
 VK_INSTANCE(vkGetPhysicalDeviceProperties, void, VkPhysicalDevice, VkPhysicalDeviceProperties *);
 VK_INSTANCE(vkGetPhysicalDeviceProperties2, void, VkPhysicalDevice, VkPhysicalDeviceProperties2 *);
 VK_INSTANCE(vkGetPhysicalDeviceQueueFamilyProperties, void, VkPhysicalDevice, uint32_t *, VkQueueFamilyProperties *);
+VK_INSTANCE(vkGetPipelineCacheData, VkResult, VkDevice, VkPipelineCache, size_t *, void *);
 VK_INSTANCE(vkMapMemory, VkResult, VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void **);
 VK_INSTANCE(vkQueueSubmit, VkResult, VkQueue, uint32_t, const VkSubmitInfo *, VkFence);
 VK_INSTANCE(vkQueueWaitIdle, VkResult, VkQueue);
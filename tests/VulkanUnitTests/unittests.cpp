@@ -23,6 +23,8 @@
 
 #include "spirv-tools/libspirv.hpp"
 
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 
@@ -31,6 +33,24 @@ size_t alignUp(size_t val, size_t alignment)
 {
 	return alignment * ((val + alignment - 1) / alignment);
 }
+
+// Sets, or unsets if value is null, an environment variable read by the
+// driver when a device is created.
+void setEnvironmentVariable(const char *name, const char *value)
+{
+#if defined(_WIN32)
+	_putenv_s(name, value ? value : "");
+#else
+	if(value)
+	{
+		setenv(name, value, 1);
+	}
+	else
+	{
+		unsetenv(name);
+	}
+#endif
+}
 }  // anonymous namespace
 
 class SwiftShaderVulkanTest : public testing::Test
@@ -1623,3 +1643,2270 @@ TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopDivergentMergePhi)
 	test(
 	    src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return i; });
 }
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopUniformCounterDivergentBreak)
+{
+	// #version 450
+	// layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// void main()
+	// {
+	//     uint x = gl_GlobalInvocationID.x;
+	//     int sum = 0;
+	//     uint i = 0;
+	//     for (; i < 4; i++)
+	//     {
+	//         sum += In.Data[x] + int(i);
+	//         if (x % 4 == i)
+	//         {
+	//             break;
+	//         }
+	//     }
+	//     Out.Data[x] = sum + int(i) * 1000;
+	// }
+	//
+	// The loop counter only depends on uniform values, but lanes leave the loop
+	// on different iterations, so it must keep the value of each lane's last
+	// iteration.
+	std::stringstream src;
+	// clang-format off
+    src <<
+              "OpCapability Shader\n"
+         "%1 = OpExtInstImport \"GLSL.std.450\"\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %2 \"main\" %3\n"
+              "OpExecutionMode %2 LocalSize " <<
+                              GetParam().localSizeX << " " <<
+                              GetParam().localSizeY << " " <<
+                              GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %4 ArrayStride 4\n"
+              "OpMemberDecorate %5 0 Offset 0\n"
+              "OpDecorate %5 BufferBlock\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+              "OpDecorate %7 ArrayStride 4\n"
+              "OpMemberDecorate %8 0 Offset 0\n"
+              "OpDecorate %8 BufferBlock\n"
+              "OpDecorate %9 DescriptorSet 0\n"
+              "OpDecorate %9 Binding 1\n"
+        "%10 = OpTypeVoid\n"
+        "%11 = OpTypeFunction %10\n"
+        "%12 = OpTypeInt 32 1\n"
+        "%13 = OpConstant %12 0\n"
+        "%14 = OpTypeInt 32 0\n"
+        "%15 = OpTypeVector %14 3\n"
+        "%16 = OpTypePointer Input %15\n"
+         "%3 = OpVariable %16 Input\n"
+        "%17 = OpConstant %14 0\n"
+        "%18 = OpTypePointer Input %14\n"
+        "%19 = OpConstant %14 4\n"
+        "%20 = OpTypeBool\n"
+         "%4 = OpTypeRuntimeArray %12\n"
+         "%5 = OpTypeStruct %4\n"
+        "%21 = OpTypePointer Uniform %5\n"
+         "%6 = OpVariable %21 Uniform\n"
+        "%22 = OpTypePointer Uniform %12\n"
+        "%23 = OpConstant %14 1\n"
+        "%24 = OpConstant %12 1000\n"
+         "%7 = OpTypeRuntimeArray %12\n"
+         "%8 = OpTypeStruct %7\n"
+        "%25 = OpTypePointer Uniform %8\n"
+         "%9 = OpVariable %25 Uniform\n"
+         "%2 = OpFunction %10 None %11\n"
+        "%26 = OpLabel\n"
+        "%27 = OpAccessChain %18 %3 %17\n"
+        "%28 = OpLoad %14 %27\n"            // x
+        "%29 = OpUMod %14 %28 %19\n"        // x % 4
+        "%30 = OpAccessChain %22 %6 %13 %28\n"
+        "%31 = OpLoad %12 %30\n"            // In.Data[x]
+              "OpBranch %32\n"
+        "%32 = OpLabel\n"
+        "%33 = OpPhi %14 %17 %26 %34 %35\n" // i
+        "%36 = OpPhi %12 %13 %26 %37 %35\n" // sum
+        "%38 = OpULessThan %20 %33 %19\n"
+              "OpLoopMerge %39 %35 None\n"
+              "OpBranchConditional %38 %40 %39\n"
+        "%40 = OpLabel\n"
+        "%41 = OpBitcast %12 %33\n"
+        "%42 = OpIAdd %12 %31 %41\n"
+        "%37 = OpIAdd %12 %36 %42\n"
+        "%43 = OpIEqual %20 %29 %33\n"
+              "OpSelectionMerge %44 None\n"
+              "OpBranchConditional %43 %45 %44\n"
+        "%45 = OpLabel\n"
+              "OpBranch %39\n"
+        "%44 = OpLabel\n"
+              "OpBranch %35\n"
+        "%35 = OpLabel\n"
+        "%34 = OpIAdd %14 %33 %23\n"
+              "OpBranch %32\n"
+        "%39 = OpLabel\n"
+        "%46 = OpPhi %12 %36 %32 %37 %45\n"
+        "%47 = OpBitcast %12 %33\n"         // i, read after the loop
+        "%48 = OpIMul %12 %47 %24\n"
+        "%49 = OpIAdd %12 %46 %48\n"
+        "%50 = OpAccessChain %22 %9 %13 %28\n"
+              "OpStore %50 %49\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return i; }, [](uint32_t i) {
+		    uint32_t k = i % 4;
+		    return (k + 1) * i + k * (k + 1) / 2 + k * 1000;
+	    });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, UniformPhiAfterDivergentIf)
+{
+	// #version 450
+	// layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// void main()
+	// {
+	//     uint x = gl_GlobalInvocationID.x;
+	//     int phi;
+	//     if (x % 2 == 0)
+	//     {
+	//         Out.Data[x] = 0;
+	//         phi = In.Data[0] + 7;
+	//     }
+	//     else
+	//     {
+	//         phi = 11;
+	//     }
+	//     Out.Data[x] = phi + In.Data[x];
+	// }
+	//
+	// Both incoming values of the phi are uniform, but lanes reach it from
+	// different blocks, so it isn't.
+	std::stringstream src;
+	// clang-format off
+    src <<
+              "OpCapability Shader\n"
+         "%1 = OpExtInstImport \"GLSL.std.450\"\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %2 \"main\" %3\n"
+              "OpExecutionMode %2 LocalSize " <<
+                              GetParam().localSizeX << " " <<
+                              GetParam().localSizeY << " " <<
+                              GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %4 ArrayStride 4\n"
+              "OpMemberDecorate %5 0 Offset 0\n"
+              "OpDecorate %5 BufferBlock\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+              "OpDecorate %7 ArrayStride 4\n"
+              "OpMemberDecorate %8 0 Offset 0\n"
+              "OpDecorate %8 BufferBlock\n"
+              "OpDecorate %9 DescriptorSet 0\n"
+              "OpDecorate %9 Binding 1\n"
+        "%10 = OpTypeVoid\n"
+        "%11 = OpTypeFunction %10\n"
+        "%12 = OpTypeInt 32 1\n"
+        "%13 = OpConstant %12 0\n"
+        "%14 = OpTypeInt 32 0\n"
+        "%15 = OpTypeVector %14 3\n"
+        "%16 = OpTypePointer Input %15\n"
+         "%3 = OpVariable %16 Input\n"
+        "%17 = OpConstant %14 0\n"
+        "%18 = OpTypePointer Input %14\n"
+        "%19 = OpConstant %14 2\n"
+        "%20 = OpTypeBool\n"
+         "%4 = OpTypeRuntimeArray %12\n"
+         "%5 = OpTypeStruct %4\n"
+        "%21 = OpTypePointer Uniform %5\n"
+         "%6 = OpVariable %21 Uniform\n"
+        "%22 = OpTypePointer Uniform %12\n"
+        "%23 = OpConstant %12 7\n"
+        "%24 = OpConstant %12 11\n"
+         "%7 = OpTypeRuntimeArray %12\n"
+         "%8 = OpTypeStruct %7\n"
+        "%25 = OpTypePointer Uniform %8\n"
+         "%9 = OpVariable %25 Uniform\n"
+         "%2 = OpFunction %10 None %11\n"
+        "%26 = OpLabel\n"
+        "%27 = OpAccessChain %18 %3 %17\n"
+        "%28 = OpLoad %14 %27\n"            // x
+        "%29 = OpAccessChain %22 %9 %13 %28\n"
+        "%30 = OpUMod %14 %28 %19\n"
+        "%31 = OpIEqual %20 %30 %17\n"      // x % 2 == 0
+              "OpSelectionMerge %32 None\n"
+              "OpBranchConditional %31 %33 %34\n"
+        "%33 = OpLabel\n"
+              "OpStore %29 %13\n"
+        "%35 = OpAccessChain %22 %6 %13 %13\n"
+        "%36 = OpLoad %12 %35\n"            // In.Data[0]
+        "%37 = OpIAdd %12 %36 %23\n"
+              "OpBranch %32\n"
+        "%34 = OpLabel\n"
+              "OpBranch %32\n"
+        "%32 = OpLabel\n"
+        "%38 = OpPhi %12 %37 %33 %24 %34\n" // phi
+        "%39 = OpAccessChain %22 %6 %13 %28\n"
+        "%40 = OpLoad %12 %39\n"
+        "%41 = OpIAdd %12 %38 %40\n"
+              "OpStore %29 %41\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return ((i % 2) == 0 ? 7 : 11) + i; });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, UniformIndexLoadPartialMask)
+{
+	// #version 450
+	// layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// void main()
+	// {
+	//     uint x = gl_GlobalInvocationID.x;
+	//     int value = -1;
+	//     if (x % 4 == 3)
+	//     {
+	//         value = In.Data[In.Data[0]];
+	//     }
+	//     Out.Data[x] = value;
+	// }
+	//
+	// The index is uniform, so the load reads a single element, which must not
+	// depend on which lanes are active.
+	std::stringstream src;
+	// clang-format off
+    src <<
+              "OpCapability Shader\n"
+         "%1 = OpExtInstImport \"GLSL.std.450\"\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %2 \"main\" %3\n"
+              "OpExecutionMode %2 LocalSize " <<
+                              GetParam().localSizeX << " " <<
+                              GetParam().localSizeY << " " <<
+                              GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %4 ArrayStride 4\n"
+              "OpMemberDecorate %5 0 Offset 0\n"
+              "OpDecorate %5 BufferBlock\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+              "OpDecorate %7 ArrayStride 4\n"
+              "OpMemberDecorate %8 0 Offset 0\n"
+              "OpDecorate %8 BufferBlock\n"
+              "OpDecorate %9 DescriptorSet 0\n"
+              "OpDecorate %9 Binding 1\n"
+        "%10 = OpTypeVoid\n"
+        "%11 = OpTypeFunction %10\n"
+        "%12 = OpTypeInt 32 1\n"
+        "%13 = OpConstant %12 0\n"
+        "%14 = OpTypeInt 32 0\n"
+        "%15 = OpTypeVector %14 3\n"
+        "%16 = OpTypePointer Input %15\n"
+         "%3 = OpVariable %16 Input\n"
+        "%17 = OpConstant %14 0\n"
+        "%18 = OpTypePointer Input %14\n"
+        "%19 = OpConstant %14 4\n"
+        "%20 = OpConstant %14 3\n"
+        "%21 = OpTypeBool\n"
+         "%4 = OpTypeRuntimeArray %12\n"
+         "%5 = OpTypeStruct %4\n"
+        "%22 = OpTypePointer Uniform %5\n"
+         "%6 = OpVariable %22 Uniform\n"
+        "%23 = OpTypePointer Uniform %12\n"
+        "%24 = OpConstant %12 -1\n"
+         "%7 = OpTypeRuntimeArray %12\n"
+         "%8 = OpTypeStruct %7\n"
+        "%25 = OpTypePointer Uniform %8\n"
+         "%9 = OpVariable %25 Uniform\n"
+         "%2 = OpFunction %10 None %11\n"
+        "%26 = OpLabel\n"
+        "%27 = OpAccessChain %18 %3 %17\n"
+        "%28 = OpLoad %14 %27\n"            // x
+        "%29 = OpUMod %14 %28 %19\n"
+        "%30 = OpIEqual %21 %29 %20\n"      // x % 4 == 3
+              "OpSelectionMerge %31 None\n"
+              "OpBranchConditional %30 %32 %31\n"
+        "%32 = OpLabel\n"
+        "%33 = OpAccessChain %23 %6 %13 %13\n"
+        "%34 = OpLoad %12 %33\n"            // In.Data[0]
+        "%35 = OpAccessChain %23 %6 %13 %34\n"
+        "%36 = OpLoad %12 %35\n"            // In.Data[In.Data[0]]
+              "OpBranch %31\n"
+        "%31 = OpLabel\n"
+        "%37 = OpPhi %12 %24 %26 %36 %32\n"
+        "%38 = OpAccessChain %23 %9 %13 %28\n"
+              "OpStore %38 %37\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return i == 0 ? 1 : 100 + i; }, [](uint32_t i) { return (i % 4) == 3 ? 101 : -1; });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, UniformSDivSMod)
+{
+	// #version 450
+	// layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+	// layout(binding = 0, std430) buffer InBuffer
+	// {
+	//     int Data[];
+	// } In;
+	// layout(binding = 1, std430) buffer OutBuffer
+	// {
+	//     int Data[];
+	// } Out;
+	// void main()
+	// {
+	//     int u = In.Data[0];  // 7
+	//     int zero = u - 7;
+	//     int intMin = zero | int(0x80000000);
+	//     int minusOne = u - 8;
+	//     int results[8] = {
+	//         -u / 2, -u % 2,
+	//         u / -2, u % -2,
+	//         u / zero, u % zero,
+	//         intMin / minusOne, intMin % minusOne,
+	//     };
+	//     Out.Data[gl_GlobalInvocationID.x] = results[gl_GlobalInvocationID.x % 8];
+	// }
+	//
+	// The operands are uniform, so each division is done once for all lanes.
+	// Division by zero and INT_MIN / -1 are undefined; SwiftShader divides by
+	// -1 and divides -1 instead, respectively.
+	std::stringstream src;
+	// clang-format off
+    src <<
+              "OpCapability Shader\n"
+         "%1 = OpExtInstImport \"GLSL.std.450\"\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %2 \"main\" %3\n"
+              "OpExecutionMode %2 LocalSize " <<
+                              GetParam().localSizeX << " " <<
+                              GetParam().localSizeY << " " <<
+                              GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %4 ArrayStride 4\n"
+              "OpMemberDecorate %5 0 Offset 0\n"
+              "OpDecorate %5 BufferBlock\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+              "OpDecorate %7 ArrayStride 4\n"
+              "OpMemberDecorate %8 0 Offset 0\n"
+              "OpDecorate %8 BufferBlock\n"
+              "OpDecorate %9 DescriptorSet 0\n"
+              "OpDecorate %9 Binding 1\n"
+        "%10 = OpTypeVoid\n"
+        "%11 = OpTypeFunction %10\n"
+        "%12 = OpTypeInt 32 1\n"
+        "%13 = OpConstant %12 0\n"
+        "%14 = OpTypeInt 32 0\n"
+        "%15 = OpTypeVector %14 3\n"
+        "%16 = OpTypePointer Input %15\n"
+         "%3 = OpVariable %16 Input\n"
+        "%17 = OpConstant %14 0\n"
+        "%18 = OpTypePointer Input %14\n"
+        "%19 = OpConstant %14 8\n"
+         "%4 = OpTypeRuntimeArray %12\n"
+         "%5 = OpTypeStruct %4\n"
+        "%20 = OpTypePointer Uniform %5\n"
+         "%6 = OpVariable %20 Uniform\n"
+        "%21 = OpTypePointer Uniform %12\n"
+         "%7 = OpTypeRuntimeArray %12\n"
+         "%8 = OpTypeStruct %7\n"
+        "%22 = OpTypePointer Uniform %8\n"
+         "%9 = OpVariable %22 Uniform\n"
+        "%23 = OpTypeArray %12 %19\n"       // int[8]
+        "%24 = OpTypePointer Function %23\n"
+        "%25 = OpTypePointer Function %12\n"
+        "%26 = OpConstant %12 2\n"
+        "%27 = OpConstant %12 -2\n"
+        "%28 = OpConstant %12 7\n"
+        "%29 = OpConstant %12 -2147483648\n"
+        "%30 = OpConstant %12 8\n"
+        "%31 = OpConstant %12 1\n"
+        "%32 = OpConstant %12 3\n"
+        "%33 = OpConstant %12 4\n"
+        "%34 = OpConstant %12 5\n"
+        "%35 = OpConstant %12 6\n"
+         "%2 = OpFunction %10 None %11\n"
+        "%36 = OpLabel\n"
+        "%37 = OpVariable %24 Function\n"   // results
+        "%38 = OpAccessChain %18 %3 %17\n"
+        "%39 = OpLoad %14 %38\n"            // x
+        "%40 = OpAccessChain %21 %6 %13 %13\n"
+        "%41 = OpLoad %12 %40\n"            // u
+        "%42 = OpSNegate %12 %41\n"         // -u
+        "%43 = OpISub %12 %41 %28\n"        // zero
+        "%44 = OpBitwiseOr %12 %43 %29\n"   // intMin
+        "%45 = OpISub %12 %41 %30\n"        // minusOne
+        "%46 = OpSDiv %12 %42 %26\n"
+        "%47 = OpSMod %12 %42 %26\n"
+        "%48 = OpSDiv %12 %41 %27\n"
+        "%49 = OpSMod %12 %41 %27\n"
+        "%50 = OpSDiv %12 %41 %43\n"
+        "%51 = OpSMod %12 %41 %43\n"
+        "%52 = OpSDiv %12 %44 %45\n"
+        "%53 = OpSMod %12 %44 %45\n"
+        "%54 = OpAccessChain %25 %37 %13\n"
+              "OpStore %54 %46\n"
+        "%55 = OpAccessChain %25 %37 %31\n"
+              "OpStore %55 %47\n"
+        "%56 = OpAccessChain %25 %37 %26\n"
+              "OpStore %56 %48\n"
+        "%57 = OpAccessChain %25 %37 %32\n"
+              "OpStore %57 %49\n"
+        "%58 = OpAccessChain %25 %37 %33\n"
+              "OpStore %58 %50\n"
+        "%59 = OpAccessChain %25 %37 %34\n"
+              "OpStore %59 %51\n"
+        "%60 = OpAccessChain %25 %37 %35\n"
+              "OpStore %60 %52\n"
+        "%61 = OpAccessChain %25 %37 %28\n"
+              "OpStore %61 %53\n"
+        "%62 = OpUMod %14 %39 %19\n"
+        "%63 = OpAccessChain %25 %37 %62\n"
+        "%64 = OpLoad %12 %63\n"
+        "%65 = OpAccessChain %21 %9 %13 %39\n"
+              "OpStore %65 %64\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+	// clang-format on
+
+	test(
+	    src.str(), [](uint32_t i) { return 7 + i; }, [](uint32_t i) {
+		    const int32_t results[8] = { -3, 1, -3, -1, -7, 0, 1, 0 };
+		    return results[i % 8];
+	    });
+}
+
+// Records and replays a large number of commands, to measure the CPU overhead
+// of command buffer recording and playback. Re-recording reuses the memory of
+// the previous iteration's commands. The commands bind one of two pipelines,
+// which add different values to a counter, and every hundredth one dispatches
+// the bound pipeline, so the counter depends on every command having been
+// replayed in order.
+TEST_F(SwiftShaderVulkanTest, CommandBufferRecordAndReplay)
+{
+	auto compileIncrement = [](uint32_t value) {
+		std::stringstream src;
+		// clang-format off
+		src <<
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %1 \"main\"\n"
+              "OpExecutionMode %1 LocalSize 1 1 1\n"
+              "OpDecorate %2 ArrayStride 4\n"
+              "OpMemberDecorate %3 0 Offset 0\n"
+              "OpDecorate %3 BufferBlock\n"
+              "OpDecorate %4 DescriptorSet 0\n"
+              "OpDecorate %4 Binding 0\n"
+         "%5 = OpTypeVoid\n"
+         "%6 = OpTypeFunction %5\n"  // void()
+         "%7 = OpTypeInt 32 0\n"
+         "%2 = OpTypeRuntimeArray %7\n"
+         "%3 = OpTypeStruct %2\n"
+         "%8 = OpTypePointer Uniform %3\n"
+         "%4 = OpVariable %8 Uniform\n"
+         "%9 = OpTypeInt 32 1\n"
+        "%10 = OpConstant %9 0\n"
+        "%11 = OpConstant %7 0\n"
+        "%12 = OpTypePointer Uniform %7\n"
+        "%13 = OpConstant %7 " << value << "\n"
+         "%1 = OpFunction %5 None %6\n"
+        "%14 = OpLabel\n"
+        "%15 = OpAccessChain %12 %4 %10 %11\n"
+        "%16 = OpLoad %7 %15\n"
+        "%17 = OpIAdd %7 %16 %13\n"
+              "OpStore %15 %17\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+		// clang-format on
+		return compileSpirv(src.str().c_str());
+	};
+
+	const uint32_t values[2] = { 3, 1000 };
+	auto code0 = compileIncrement(values[0]);
+	auto code1 = compileIncrement(values[1]);
+
+	Driver driver;
+	ASSERT_TRUE(driver.loadSwiftShader());
+
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+		nullptr,                                 // pNext
+		0,                                       // flags
+		nullptr,                                 // pApplicationInfo
+		0,                                       // enabledLayerCount
+		nullptr,                                 // ppEnabledLayerNames
+		0,                                       // enabledExtensionCount
+		nullptr,                                 // ppEnabledExtensionNames
+	};
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+	ASSERT_TRUE(driver.resolve(instance));
+
+	std::unique_ptr<Device> device;
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	ASSERT_TRUE(device->IsValid());
+
+	const size_t counterSize = sizeof(uint32_t);
+
+	VkDeviceMemory memory;
+	VK_ASSERT(device->AllocateMemory(counterSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &memory));
+
+	VkBuffer buffer;
+	VK_ASSERT(device->CreateStorageBuffer(memory, counterSize, 0, &buffer));
+
+	VkShaderModule shaderModules[2];
+	VK_ASSERT(device->CreateShaderModule(code0, &shaderModules[0]));
+	VK_ASSERT(device->CreateShaderModule(code1, &shaderModules[1]));
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
+		{
+		    0,                                  // binding
+		    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+		    1,                                  // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+		    0,                                  // pImmutableSamplers
+		},
+	};
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	VkPipeline pipelines[2];
+	VK_ASSERT(device->CreateComputePipeline(shaderModules[0], pipelineLayout, &pipelines[0]));
+	VK_ASSERT(device->CreateComputePipeline(shaderModules[1], pipelineLayout, &pipelines[1]));
+
+	VkDescriptorPool descriptorPool;
+	VK_ASSERT(device->CreateStorageBufferDescriptorPool(1, &descriptorPool));
+
+	VkDescriptorSet descriptorSet;
+	VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+	device->UpdateStorageBufferDescriptorSets(descriptorSet, { { buffer, 0, VK_WHOLE_SIZE } });
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	VkCommandBuffer commandBuffer;
+	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+
+	const int commandCount = 100000;
+
+	const VkMemoryBarrier barrier = {
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,                        // sType
+		nullptr,                                                 // pNext
+		VK_ACCESS_SHADER_WRITE_BIT,                              // srcAccessMask
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,  // dstAccessMask
+	};
+
+	// The counter's value after replaying the commands recorded below.
+	uint32_t expected = 0;
+	int bound = 0;
+	for(int i = 0; i < commandCount; i++)
+	{
+		if(i % 100 == 99)
+		{
+			expected += values[bound];
+		}
+		else if(i % 100 != 0)
+		{
+			bound = (i / 3) % 2;
+		}
+	}
+
+	for(int iteration = 0; iteration < 3; iteration++)
+	{
+		uint32_t *counter;
+		VK_ASSERT(device->MapMemory(memory, 0, counterSize, 0, (void **)&counter));
+		*counter = 0;
+		device->UnmapMemory(memory);
+
+		auto start = std::chrono::steady_clock::now();
+
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+		driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+		                               0, nullptr);
+
+		// Dispatches use the pipeline bound by the previous command, and are
+		// each followed by a barrier for the next one's read of the counter.
+		for(int i = 0; i < commandCount; i++)
+		{
+			if(i % 100 == 99)
+			{
+				driver.vkCmdDispatch(commandBuffer, 1, 1, 1);
+			}
+			else if(i % 100 == 0)
+			{
+				driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+			else
+			{
+				driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[(i / 3) % 2]);
+			}
+		}
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+		auto recorded = std::chrono::steady_clock::now();
+
+		VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+		auto replayed = std::chrono::steady_clock::now();
+
+		printf("%d commands: recorded in %.3f ms, replayed in %.3f ms\n", commandCount,
+		       std::chrono::duration<double, std::milli>(recorded - start).count(),
+		       std::chrono::duration<double, std::milli>(replayed - recorded).count());
+
+		VK_ASSERT(device->MapMemory(memory, 0, counterSize, 0, (void **)&counter));
+		EXPECT_EQ(expected, *counter) << "iteration " << iteration;
+		device->UnmapMemory(memory);
+	}
+
+	device->FreeCommandBuffer(commandPool, commandBuffer);
+	device->DestroyCommandPool(commandPool);
+	device->DestroyDescriptorPool(descriptorPool);
+	device->DestroyPipeline(pipelines[1]);
+	device->DestroyPipeline(pipelines[0]);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyShaderModule(shaderModules[1]);
+	device->DestroyShaderModule(shaderModules[0]);
+	device->DestroyBuffer(buffer);
+	device->FreeMemory(memory);
+	device.reset(nullptr);
+	driver.vkDestroyInstance(instance, nullptr);
+}
+
+// Serializes a pipeline cache holding two compute shaders, and loads the data
+// into new caches: intact, truncated, and with a corrupted entry. Entries which
+// don't fit, or whose checksum doesn't match, are dropped.
+TEST_F(SwiftShaderVulkanTest, PipelineCacheData)
+{
+	auto compileStore = [](uint32_t value) {
+		std::stringstream src;
+		// clang-format off
+		src <<
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %1 \"main\"\n"
+              "OpExecutionMode %1 LocalSize 1 1 1\n"
+              "OpDecorate %2 ArrayStride 4\n"
+              "OpMemberDecorate %3 0 Offset 0\n"
+              "OpDecorate %3 BufferBlock\n"
+              "OpDecorate %4 DescriptorSet 0\n"
+              "OpDecorate %4 Binding 0\n"
+         "%5 = OpTypeVoid\n"
+         "%6 = OpTypeFunction %5\n"  // void()
+         "%7 = OpTypeInt 32 0\n"
+         "%2 = OpTypeRuntimeArray %7\n"
+         "%3 = OpTypeStruct %2\n"
+         "%8 = OpTypePointer Uniform %3\n"
+         "%4 = OpVariable %8 Uniform\n"
+         "%9 = OpTypeInt 32 1\n"
+        "%10 = OpConstant %9 0\n"
+        "%11 = OpTypePointer Uniform %7\n"
+        "%12 = OpConstant %7 " << value << "\n"
+         "%1 = OpFunction %5 None %6\n"
+        "%13 = OpLabel\n"
+        "%14 = OpAccessChain %11 %4 %10 %10\n"
+              "OpStore %14 %12\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+		// clang-format on
+		return compileSpirv(src.str().c_str());
+	};
+
+	auto code0 = compileStore(1);
+	auto code1 = compileStore(2);
+
+	Driver driver;
+	ASSERT_TRUE(driver.loadSwiftShader());
+
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+		nullptr,                                 // pNext
+		0,                                       // flags
+		nullptr,                                 // pApplicationInfo
+		0,                                       // enabledLayerCount
+		nullptr,                                 // ppEnabledLayerNames
+		0,                                       // enabledExtensionCount
+		nullptr,                                 // ppEnabledExtensionNames
+	};
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+	ASSERT_TRUE(driver.resolve(instance));
+
+	std::unique_ptr<Device> device;
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	ASSERT_TRUE(device->IsValid());
+
+	VkShaderModule shaderModules[2];
+	VK_ASSERT(device->CreateShaderModule(code0, &shaderModules[0]));
+	VK_ASSERT(device->CreateShaderModule(code1, &shaderModules[1]));
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
+		{
+		    0,                                  // binding
+		    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+		    1,                                  // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+		    0,                                  // pImmutableSamplers
+		},
+	};
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	// Returns the data of pipelineCache, or of a new cache loaded from
+	// initialData if pipelineCache is VK_NULL_HANDLE.
+	auto getData = [&](VkPipelineCache pipelineCache, const std::vector<uint8_t> &initialData) {
+		VkPipelineCache loaded = VK_NULL_HANDLE;
+		if(pipelineCache == VK_NULL_HANDLE)
+		{
+			EXPECT_EQ(VK_SUCCESS, device->CreatePipelineCache(initialData, &loaded));
+			pipelineCache = loaded;
+		}
+
+		size_t size = 0;
+		EXPECT_EQ(VK_SUCCESS, device->GetPipelineCacheData(pipelineCache, &size, nullptr));
+		std::vector<uint8_t> data(size);
+		EXPECT_EQ(VK_SUCCESS, device->GetPipelineCacheData(pipelineCache, &size, data.data()));
+		EXPECT_EQ(data.size(), size);
+
+		if(loaded != VK_NULL_HANDLE)
+		{
+			device->DestroyPipelineCache(loaded);
+		}
+
+		return data;
+	};
+
+	VkPipelineCache pipelineCache;
+	VK_ASSERT(device->CreatePipelineCache({}, &pipelineCache));
+
+	const std::vector<uint8_t> empty = getData(pipelineCache, {});
+	ASSERT_GE(empty.size(), size_t(16 + VK_UUID_SIZE));
+
+	VkPipeline pipelines[2];
+	VK_ASSERT(device->CreateComputePipeline(shaderModules[0], pipelineLayout, &pipelines[0], pipelineCache));
+	VK_ASSERT(device->CreateComputePipeline(shaderModules[1], pipelineLayout, &pipelines[1], pipelineCache));
+
+	const std::vector<uint8_t> full = getData(pipelineCache, {});
+	ASSERT_GT(full.size(), empty.size());
+	EXPECT_EQ(0, memcmp(full.data(), empty.data(), empty.size()));  // Same header
+
+	// The data of a cache loaded from full is identical.
+	EXPECT_EQ(full, getData(VK_NULL_HANDLE, full));
+
+	// A buffer too small for the header receives nothing.
+	size_t size = empty.size() - 1;
+	std::vector<uint8_t> truncated(full.size());
+	EXPECT_EQ(VK_INCOMPLETE, device->GetPipelineCacheData(pipelineCache, &size, truncated.data()));
+	EXPECT_EQ(0u, size);
+
+	// A buffer one byte short of the whole data receives all but one entry.
+	size = full.size() - 1;
+	EXPECT_EQ(VK_INCOMPLETE, device->GetPipelineCacheData(pipelineCache, &size, truncated.data()));
+	EXPECT_GT(size, empty.size());
+	EXPECT_LT(size, full.size());
+	truncated.resize(size);
+	EXPECT_EQ(0, memcmp(truncated.data(), full.data(), size));
+	EXPECT_EQ(truncated, getData(VK_NULL_HANDLE, truncated));
+
+	// Corrupting the last entry drops it, and keeps the first one.
+	std::vector<uint8_t> corrupted = full;
+	corrupted.back() ^= 0xFF;
+	EXPECT_EQ(truncated, getData(VK_NULL_HANDLE, corrupted));
+
+	// Data from another build, with a different UUID, is ignored entirely.
+	std::vector<uint8_t> otherBuild = full;
+	otherBuild[16] ^= 0xFF;
+	EXPECT_EQ(empty, getData(VK_NULL_HANDLE, otherBuild));
+
+	device->DestroyPipeline(pipelines[1]);
+	device->DestroyPipeline(pipelines[0]);
+	device->DestroyPipelineCache(pipelineCache);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyShaderModule(shaderModules[1]);
+	device->DestroyShaderModule(shaderModules[0]);
+	device.reset(nullptr);
+	driver.vkDestroyInstance(instance, nullptr);
+}
+
+// Copies a buffer to an image and back at common framebuffer resolutions,
+// which are large enough for the copies to be split across worker threads,
+// and checks the result. Also reports the throughput of the first copy.
+TEST_F(SwiftShaderVulkanTest, BufferToImageCopyBandwidth)
+{
+	Driver driver;
+	ASSERT_TRUE(driver.loadSwiftShader());
+
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+		nullptr,                                 // pNext
+		0,                                       // flags
+		nullptr,                                 // pApplicationInfo
+		0,                                       // enabledLayerCount
+		nullptr,                                 // ppEnabledLayerNames
+		0,                                       // enabledExtensionCount
+		nullptr,                                 // ppEnabledExtensionNames
+	};
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+	ASSERT_TRUE(driver.resolve(instance));
+
+	std::unique_ptr<Device> device;
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	ASSERT_TRUE(device->IsValid());
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	struct Resolution
+	{
+		const char *name;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	const Resolution resolutions[] = {
+		{ "1001x333", 1001, 333 },
+		{ "1080p", 1920, 1080 },
+		{ "4K", 3840, 2160 },
+		{ "8K", 7680, 4320 },
+	};
+
+	for(const auto &resolution : resolutions)
+	{
+		const VkDeviceSize size = VkDeviceSize(resolution.width) * resolution.height * 4;
+
+		VkDeviceMemory bufferMemory;
+		VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &bufferMemory));
+
+		// Each texel holds its coordinates, so misplaced rows or columns show.
+		uint32_t *texels;
+		VK_ASSERT(device->MapMemory(bufferMemory, 0, size, 0, (void **)&texels));
+		for(uint32_t y = 0; y < resolution.height; y++)
+		{
+			for(uint32_t x = 0; x < resolution.width; x++)
+			{
+				texels[y * resolution.width + x] = (y << 16) | x;
+			}
+		}
+		device->UnmapMemory(bufferMemory);
+
+		VkBuffer buffer;
+		VK_ASSERT(device->CreateTransferBuffer(bufferMemory, size, 0, &buffer));
+
+		VkDeviceMemory readbackMemory;
+		VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &readbackMemory));
+
+		VkBuffer readbackBuffer;
+		VK_ASSERT(device->CreateTransferBuffer(readbackMemory, size, 0, &readbackBuffer));
+
+		VkImage image;
+		VkDeviceMemory imageMemory;
+		VK_ASSERT(device->CreateTransferImage(VK_FORMAT_R8G8B8A8_UNORM, resolution.width, resolution.height, &image, &imageMemory));
+
+		VkCommandBuffer commandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(0, commandBuffer));
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { resolution.width, resolution.height, 1 };
+		driver.vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+		double best = 0.0;
+		for(int iteration = 0; iteration < 3; iteration++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+			auto end = std::chrono::steady_clock::now();
+
+			double seconds = std::chrono::duration<double>(end - start).count();
+			best = std::max(best, size / seconds / 1e9);
+		}
+
+		printf("Buffer to image copy at %s: %.2f GB/s\n", resolution.name, best);
+
+		VkCommandBuffer readbackCommandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &readbackCommandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, readbackCommandBuffer));
+		driver.vkCmdCopyImageToBuffer(readbackCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+		VK_ASSERT(driver.vkEndCommandBuffer(readbackCommandBuffer));
+		VK_ASSERT(device->QueueSubmitAndWait(readbackCommandBuffer));
+
+		VK_ASSERT(device->MapMemory(readbackMemory, 0, size, 0, (void **)&texels));
+		for(uint32_t y = 0; y < resolution.height; y++)
+		{
+			for(uint32_t x = 0; x < resolution.width; x++)
+			{
+				ASSERT_EQ((y << 16) | x, texels[y * resolution.width + x]) << "at (" << x << ", " << y << ") of " << resolution.name;
+			}
+		}
+		device->UnmapMemory(readbackMemory);
+
+		device->FreeCommandBuffer(commandPool, readbackCommandBuffer);
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+		device->DestroyImage(image);
+		device->FreeMemory(imageMemory);
+		device->DestroyBuffer(readbackBuffer);
+		device->FreeMemory(readbackMemory);
+		device->DestroyBuffer(buffer);
+		device->FreeMemory(bufferMemory);
+	}
+
+	device->DestroyCommandPool(commandPool);
+	device.reset(nullptr);
+	driver.vkDestroyInstance(instance, nullptr);
+}
+
+// Compressed images which can't be sampled directly are decoded into a shadow
+// image when they're written. This measures that decoding for each format.
+TEST_F(SwiftShaderVulkanTest, CompressedImageDecodeThroughput)
+{
+	Driver driver;
+	ASSERT_TRUE(driver.loadSwiftShader());
+
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+		nullptr,                                 // pNext
+		0,                                       // flags
+		nullptr,                                 // pApplicationInfo
+		0,                                       // enabledLayerCount
+		nullptr,                                 // ppEnabledLayerNames
+		0,                                       // enabledExtensionCount
+		nullptr,                                 // ppEnabledExtensionNames
+	};
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+	ASSERT_TRUE(driver.resolve(instance));
+
+	std::unique_ptr<Device> device;
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	ASSERT_TRUE(device->IsValid());
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	struct CompressedFormat
+	{
+		const char *name;
+		VkFormat format;
+		uint32_t blockBytes;
+		VkImageType imageType;
+	};
+
+	// 2D BC images are decoded by the sampler, so BC formats use 3D images.
+	const CompressedFormat formats[] = {
+		{ "ETC2_R8G8B8", VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 8, VK_IMAGE_TYPE_2D },
+		{ "ETC2_R8G8B8A1", VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 8, VK_IMAGE_TYPE_2D },
+		{ "ETC2_R8G8B8A8", VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 16, VK_IMAGE_TYPE_2D },
+		{ "EAC_R11", VK_FORMAT_EAC_R11_UNORM_BLOCK, 8, VK_IMAGE_TYPE_2D },
+		{ "EAC_R11G11", VK_FORMAT_EAC_R11G11_UNORM_BLOCK, 16, VK_IMAGE_TYPE_2D },
+		{ "BC1_RGBA (3D)", VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, VK_IMAGE_TYPE_3D },
+		{ "BC2 (3D)", VK_FORMAT_BC2_UNORM_BLOCK, 16, VK_IMAGE_TYPE_3D },
+		{ "BC3 (3D)", VK_FORMAT_BC3_UNORM_BLOCK, 16, VK_IMAGE_TYPE_3D },
+		{ "BC4 (3D)", VK_FORMAT_BC4_UNORM_BLOCK, 8, VK_IMAGE_TYPE_3D },
+		{ "BC5 (3D)", VK_FORMAT_BC5_UNORM_BLOCK, 16, VK_IMAGE_TYPE_3D },
+	};
+
+	const uint32_t width = 2048;
+	const uint32_t height = 2048;
+
+	for(const auto &format : formats)
+	{
+		const VkDeviceSize size = VkDeviceSize(width / 4) * (height / 4) * format.blockBytes;
+
+		VkDeviceMemory bufferMemory;
+		VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &bufferMemory));
+
+		// Pseudo-random blocks use all of each format's modes.
+		uint32_t *blocks;
+		VK_ASSERT(device->MapMemory(bufferMemory, 0, size, 0, (void **)&blocks));
+		uint32_t state = 0x12345678;
+		for(VkDeviceSize i = 0; i < size / sizeof(uint32_t); i++)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			blocks[i] = state;
+		}
+		device->UnmapMemory(bufferMemory);
+
+		VkBuffer buffer;
+		VK_ASSERT(device->CreateTransferBuffer(bufferMemory, size, 0, &buffer));
+
+		VkImage image;
+		VkDeviceMemory imageMemory;
+		VK_ASSERT(device->CreateSampledImage(format.format, width, height, 1, &image, &imageMemory, format.imageType));
+
+		VkCommandBuffer commandBuffer;
+		VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+		VK_ASSERT(device->BeginCommandBuffer(0, commandBuffer));
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { width, height, 1 };
+		driver.vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+		double best = 0.0;
+		for(int iteration = 0; iteration < 3; iteration++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+			auto end = std::chrono::steady_clock::now();
+
+			double seconds = std::chrono::duration<double>(end - start).count();
+			best = std::max(best, double(width) * height / seconds / 1e6);
+		}
+
+		printf("Decode of %s at %ux%u: %.1f Mpixels/s\n", format.name, width, height, best);
+
+		device->FreeCommandBuffer(commandPool, commandBuffer);
+		device->DestroyImage(image);
+		device->FreeMemory(imageMemory);
+		device->DestroyBuffer(buffer);
+		device->FreeMemory(bufferMemory);
+	}
+
+	device->DestroyCommandPool(commandPool);
+	device.reset(nullptr);
+	driver.vkDestroyInstance(instance, nullptr);
+}
+
+// Base class for tests that draw triangles into a color attachment and read
+// back the result.
+class SwiftShaderVulkanRenderTest : public testing::Test
+{
+public:
+	// A draw of count vertices starting at first, or of count indices starting
+	// at first if indexed.
+	struct Draw
+	{
+		uint32_t first;
+		uint32_t count;
+		bool indexed;
+	};
+
+	// render() draws triangle lists, whose vertices consist of a vec2 position
+	// in normalized device coordinates and a vec4 color, into a width x height
+	// R8G8B8A8_UNORM color attachment cleared to clearColor, and returns its
+	// texels in pixels. If samples is greater than 1, the attachment is
+	// resolved into a single-sampled one cleared to resolveClearColor, which
+	// is the one read back.
+	void render(const std::vector<float> &vertices, uint32_t width, uint32_t height,
+	            VkSampleCountFlagBits samples,
+	            VkClearColorValue clearColor, VkClearColorValue resolveClearColor,
+	            std::vector<uint32_t> &pixels);
+
+	// Same as above, but records each of draws in turn, within the same render
+	// pass. Indexed draws use indices, as 32-bit indices into vertices.
+	void render(const std::vector<float> &vertices, const std::vector<uint32_t> &indices,
+	            const std::vector<Draw> &draws, uint32_t width, uint32_t height,
+	            VkSampleCountFlagBits samples,
+	            VkClearColorValue clearColor, VkClearColorValue resolveClearColor,
+	            std::vector<uint32_t> &pixels);
+};
+
+void SwiftShaderVulkanRenderTest::render(
+    const std::vector<float> &vertices, uint32_t width, uint32_t height,
+    VkSampleCountFlagBits samples,
+    VkClearColorValue clearColor, VkClearColorValue resolveClearColor,
+    std::vector<uint32_t> &pixels)
+{
+	const Draw draw = { 0, static_cast<uint32_t>(vertices.size() / 6), false };
+	render(vertices, {}, { draw }, width, height, samples, clearColor, resolveClearColor, pixels);
+}
+
+void SwiftShaderVulkanRenderTest::render(
+    const std::vector<float> &vertices, const std::vector<uint32_t> &indices,
+    const std::vector<Draw> &draws, uint32_t width, uint32_t height,
+    VkSampleCountFlagBits samples,
+    VkClearColorValue clearColor, VkClearColorValue resolveClearColor,
+    std::vector<uint32_t> &pixels)
+{
+	// clang-format off
+	auto vertexCode = compileSpirv(
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint Vertex %1 \"main\" %2 %3 %4 %5\n"
+              "OpMemberDecorate %6 0 BuiltIn Position\n"
+              "OpDecorate %6 Block\n"
+              "OpDecorate %2 Location 0\n"
+              "OpDecorate %3 Location 1\n"
+              "OpDecorate %4 Location 0\n"
+         "%7 = OpTypeVoid\n"
+         "%8 = OpTypeFunction %7\n"
+         "%9 = OpTypeFloat 32\n"
+        "%10 = OpTypeVector %9 2\n"
+        "%11 = OpTypeVector %9 4\n"
+         "%6 = OpTypeStruct %11\n"
+        "%12 = OpTypePointer Output %6\n"
+         "%5 = OpVariable %12 Output\n"
+        "%13 = OpTypePointer Input %10\n"
+         "%2 = OpVariable %13 Input\n"
+        "%14 = OpTypePointer Input %11\n"
+         "%3 = OpVariable %14 Input\n"
+        "%15 = OpTypePointer Output %11\n"
+         "%4 = OpVariable %15 Output\n"
+        "%16 = OpTypeInt 32 1\n"
+        "%17 = OpConstant %16 0\n"
+        "%18 = OpConstant %9 0\n"
+        "%19 = OpConstant %9 1\n"
+         "%1 = OpFunction %7 None %8\n"
+        "%20 = OpLabel\n"
+        "%21 = OpLoad %10 %2\n"  // position
+        "%22 = OpCompositeExtract %9 %21 0\n"
+        "%23 = OpCompositeExtract %9 %21 1\n"
+        "%24 = OpCompositeConstruct %11 %22 %23 %18 %19\n"
+        "%25 = OpAccessChain %15 %5 %17\n"
+              "OpStore %25 %24\n"
+        "%26 = OpLoad %11 %3\n"  // color
+              "OpStore %4 %26\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n");
+
+	auto fragmentCode = compileSpirv(
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint Fragment %1 \"main\" %2 %3\n"
+              "OpExecutionMode %1 OriginUpperLeft\n"
+              "OpDecorate %2 Location 0\n"
+              "OpDecorate %3 Location 0\n"
+         "%4 = OpTypeVoid\n"
+         "%5 = OpTypeFunction %4\n"
+         "%6 = OpTypeFloat 32\n"
+         "%7 = OpTypeVector %6 4\n"
+         "%8 = OpTypePointer Input %7\n"
+         "%2 = OpVariable %8 Input\n"
+         "%9 = OpTypePointer Output %7\n"
+         "%3 = OpVariable %9 Output\n"
+         "%1 = OpFunction %4 None %5\n"
+        "%10 = OpLabel\n"
+        "%11 = OpLoad %7 %2\n"
+              "OpStore %3 %11\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n");
+	// clang-format on
+
+	Driver driver;
+	ASSERT_TRUE(driver.loadSwiftShader());
+
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+		nullptr,                                 // pNext
+		0,                                       // flags
+		nullptr,                                 // pApplicationInfo
+		0,                                       // enabledLayerCount
+		nullptr,                                 // ppEnabledLayerNames
+		0,                                       // enabledExtensionCount
+		nullptr,                                 // ppEnabledExtensionNames
+	};
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+	ASSERT_TRUE(driver.resolve(instance));
+
+	std::unique_ptr<Device> device;
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	ASSERT_TRUE(device->IsValid());
+
+	const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+	const bool resolve = (samples != VK_SAMPLE_COUNT_1_BIT);
+
+	VkImage colorImage;
+	VkDeviceMemory colorMemory;
+	VK_ASSERT(device->CreateAttachmentImage(format, width, height, samples, &colorImage, &colorMemory));
+
+	VkImageView colorView;
+	VK_ASSERT(device->CreateImageView(colorImage, format, &colorView));
+
+	VkImage resolveImage = VK_NULL_HANDLE;
+	VkDeviceMemory resolveMemory = VK_NULL_HANDLE;
+	VkImageView resolveView = VK_NULL_HANDLE;
+	if(resolve)
+	{
+		VK_ASSERT(device->CreateAttachmentImage(format, width, height, VK_SAMPLE_COUNT_1_BIT, &resolveImage, &resolveMemory));
+		VK_ASSERT(device->CreateImageView(resolveImage, format, &resolveView));
+	}
+
+	VkAttachmentDescription attachment = {
+		0,                                     // flags
+		format,                                // format
+		samples,                               // samples
+		VK_ATTACHMENT_LOAD_OP_CLEAR,           // loadOp
+		VK_ATTACHMENT_STORE_OP_STORE,          // storeOp
+		VK_ATTACHMENT_LOAD_OP_DONT_CARE,       // stencilLoadOp
+		VK_ATTACHMENT_STORE_OP_DONT_CARE,      // stencilStoreOp
+		VK_IMAGE_LAYOUT_UNDEFINED,             // initialLayout
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,  // finalLayout
+	};
+
+	std::vector<VkAttachmentDescription> attachments = { attachment };
+	if(resolve)
+	{
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments.push_back(attachment);
+	}
+
+	const VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	const VkAttachmentReference resolveReference = { 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+	const VkSubpassDescription subpass = {
+		0,                                      // flags
+		VK_PIPELINE_BIND_POINT_GRAPHICS,        // pipelineBindPoint
+		0,                                      // inputAttachmentCount
+		nullptr,                                // pInputAttachments
+		1,                                      // colorAttachmentCount
+		&colorReference,                        // pColorAttachments
+		resolve ? &resolveReference : nullptr,  // pResolveAttachments
+		nullptr,                                // pDepthStencilAttachment
+		0,                                      // preserveAttachmentCount
+		nullptr,                                // pPreserveAttachments
+	};
+
+	VkRenderPass renderPass;
+	VK_ASSERT(device->CreateRenderPass(attachments, subpass, &renderPass));
+
+	std::vector<VkImageView> views = { colorView };
+	if(resolve)
+	{
+		views.push_back(resolveView);
+	}
+
+	VkFramebuffer framebuffer;
+	VK_ASSERT(device->CreateFramebuffer(renderPass, views, width, height, &framebuffer));
+
+	VkShaderModule vertexModule;
+	VK_ASSERT(device->CreateShaderModule(vertexCode, &vertexModule));
+
+	VkShaderModule fragmentModule;
+	VK_ASSERT(device->CreateShaderModule(fragmentCode, &fragmentModule));
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout({}, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	VkPipeline pipeline;
+	VK_ASSERT(device->CreateGraphicsPipeline(vertexModule, fragmentModule, pipelineLayout, renderPass,
+	                                         samples, width, height, &pipeline));
+
+	const size_t vertexSize = vertices.size() * sizeof(float);
+	const size_t pixelsSize = size_t(width) * height * sizeof(uint32_t);
+
+	VkDeviceMemory vertexMemory;
+	VK_ASSERT(device->AllocateMemory(vertexSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &vertexMemory));
+
+	void *data;
+	VK_ASSERT(device->MapMemory(vertexMemory, 0, vertexSize, 0, &data));
+	memcpy(data, vertices.data(), vertexSize);
+	device->UnmapMemory(vertexMemory);
+
+	VkBuffer vertexBuffer;
+	VK_ASSERT(device->CreateVertexBuffer(vertexMemory, vertexSize, 0, &vertexBuffer));
+
+	VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	if(!indices.empty())
+	{
+		const size_t indexSize = indices.size() * sizeof(uint32_t);
+		VK_ASSERT(device->AllocateMemory(indexSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &indexMemory));
+
+		VK_ASSERT(device->MapMemory(indexMemory, 0, indexSize, 0, &data));
+		memcpy(data, indices.data(), indexSize);
+		device->UnmapMemory(indexMemory);
+
+		VK_ASSERT(device->CreateIndexBuffer(indexMemory, indexSize, 0, &indexBuffer));
+	}
+
+	VkDeviceMemory pixelsMemory;
+	VK_ASSERT(device->AllocateMemory(pixelsSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &pixelsMemory));
+
+	VkBuffer pixelsBuffer;
+	VK_ASSERT(device->CreateTransferBuffer(pixelsMemory, pixelsSize, 0, &pixelsBuffer));
+
+	VkCommandPool commandPool;
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+	VkCommandBuffer commandBuffer;
+	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+
+	VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+	VkClearValue clearValues[2];
+	clearValues[0].color = clearColor;
+	clearValues[1].color = resolveClearColor;
+
+	const VkRenderPassBeginInfo renderPassBeginInfo = {
+		VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,  // sType
+		nullptr,                                   // pNext
+		renderPass,                                // renderPass
+		framebuffer,                               // framebuffer
+		{ { 0, 0 }, { width, height } },           // renderArea
+		resolve ? 2u : 1u,                         // clearValueCount
+		clearValues,                               // pClearValues
+	};
+
+	driver.vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	VkDeviceSize vertexOffset = 0;
+	driver.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+	if(indexBuffer != VK_NULL_HANDLE)
+	{
+		driver.vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	for(const Draw &draw : draws)
+	{
+		if(draw.indexed)
+		{
+			driver.vkCmdDrawIndexed(commandBuffer, draw.count, 1, draw.first, 0, 0);
+		}
+		else
+		{
+			driver.vkCmdDraw(commandBuffer, draw.count, 1, draw.first, 0);
+		}
+	}
+	driver.vkCmdEndRenderPass(commandBuffer);
+
+	const VkMemoryBarrier barrier = {
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,      // sType
+		nullptr,                               // pNext
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,  // srcAccessMask
+		VK_ACCESS_TRANSFER_READ_BIT,           // dstAccessMask
+	};
+	driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { width, height, 1 };
+	driver.vkCmdCopyImageToBuffer(commandBuffer, resolve ? resolveImage : colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                              pixelsBuffer, 1, &region);
+
+	VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+	VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+	VK_ASSERT(device->MapMemory(pixelsMemory, 0, pixelsSize, 0, &data));
+	pixels.resize(size_t(width) * height);
+	memcpy(pixels.data(), data, pixelsSize);
+	device->UnmapMemory(pixelsMemory);
+
+	device->FreeCommandBuffer(commandPool, commandBuffer);
+	device->DestroyCommandPool(commandPool);
+	device->DestroyBuffer(pixelsBuffer);
+	device->FreeMemory(pixelsMemory);
+	if(indexBuffer != VK_NULL_HANDLE)
+	{
+		device->DestroyBuffer(indexBuffer);
+		device->FreeMemory(indexMemory);
+	}
+	device->DestroyBuffer(vertexBuffer);
+	device->FreeMemory(vertexMemory);
+	device->DestroyPipeline(pipeline);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyShaderModule(fragmentModule);
+	device->DestroyShaderModule(vertexModule);
+	device->DestroyFramebuffer(framebuffer);
+	device->DestroyRenderPass(renderPass);
+	if(resolve)
+	{
+		device->DestroyImageView(resolveView);
+		device->DestroyImage(resolveImage);
+		device->FreeMemory(resolveMemory);
+	}
+	device->DestroyImageView(colorView);
+	device->DestroyImage(colorImage);
+	device->FreeMemory(colorMemory);
+	device.reset(nullptr);
+	driver.vkDestroyInstance(instance, nullptr);
+}
+
+// Draws overlapping triangles spanning several batches and screen tiles, with
+// and without SWIFTSHADER_TILED_RASTERIZATION, and expects identical results.
+TEST_F(SwiftShaderVulkanRenderTest, TiledRasterization)
+{
+	std::vector<float> vertices;
+	uint32_t seed = 1;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return float(seed >> 8) / float(1 << 24);
+	};
+
+	for(int i = 0; i < 3 * 300; i++)
+	{
+		vertices.push_back(random() * 2.4f - 1.2f);  // x
+		vertices.push_back(random() * 2.4f - 1.2f);  // y
+		vertices.push_back(random());                // r
+		vertices.push_back(random());                // g
+		vertices.push_back(random());                // b
+		vertices.push_back(1.0f);                    // a
+	}
+
+	const uint32_t width = 300;
+	const uint32_t height = 200;
+	const VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+	std::vector<uint32_t> untiled;
+	render(vertices, width, height, VK_SAMPLE_COUNT_1_BIT, clearColor, clearColor, untiled);
+
+	setEnvironmentVariable("SWIFTSHADER_TILED_RASTERIZATION", "1");
+	std::vector<uint32_t> tiled;
+	render(vertices, width, height, VK_SAMPLE_COUNT_1_BIT, clearColor, clearColor, tiled);
+	setEnvironmentVariable("SWIFTSHADER_TILED_RASTERIZATION", nullptr);
+
+	ASSERT_EQ(untiled.size(), size_t(width) * height);
+	ASSERT_EQ(tiled.size(), untiled.size());
+
+	size_t drawn = 0;
+	size_t mismatches = 0;
+	for(size_t i = 0; i < untiled.size(); i++)
+	{
+		drawn += (untiled[i] != 0xFF000000) ? 1 : 0;
+
+		if(untiled[i] != tiled[i] && mismatches++ == 0)
+		{
+			ADD_FAILURE() << "First mismatch at pixel (" << (i % width) << ", " << (i / width) << "): "
+			              << std::hex << untiled[i] << " != " << tiled[i];
+		}
+	}
+
+	EXPECT_EQ(mismatches, 0u);
+	EXPECT_GT(drawn, untiled.size() / 2);
+}
+
+// Resolves a multisample attachment into a single-sampled one which is loaded
+// with VK_ATTACHMENT_LOAD_OP_CLEAR. The resolved contents must not be
+// overwritten by the resolve attachment's clear.
+TEST_F(SwiftShaderVulkanRenderTest, ResolveIntoClearedAttachment)
+{
+	// A green triangle covering the top left half of the render area.
+	const std::vector<float> vertices = {
+		-1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+		1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+		-1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+	};
+
+	const uint32_t width = 64;
+	const uint32_t height = 64;
+	const VkClearColorValue red = { { 1.0f, 0.0f, 0.0f, 1.0f } };
+	const VkClearColorValue blue = { { 0.0f, 0.0f, 1.0f, 1.0f } };
+
+	std::vector<uint32_t> pixels;
+	render(vertices, width, height, VK_SAMPLE_COUNT_4_BIT, red, blue, pixels);
+	ASSERT_EQ(pixels.size(), size_t(width) * height);
+
+	for(uint32_t y = 0; y < height; y++)
+	{
+		for(uint32_t x = 0; x < width; x++)
+		{
+			uint32_t pixel = pixels[y * width + x];
+
+			// Pixels on the diagonal edge are a mix of both colors.
+			if(x + y + 2 < width)
+			{
+				ASSERT_EQ(0xFF00FF00u, pixel) << "at (" << x << ", " << y << ")";
+			}
+			else if(x + y > width)
+			{
+				ASSERT_EQ(0xFF0000FFu, pixel) << "at (" << x << ", " << y << ")";
+			}
+		}
+	}
+}
+
+// Alternates indexed draws spanning several batches, whose vertices are shaded
+// once per draw, with non-indexed draws. Draw calls are pooled, and a draw must
+// not use the shaded vertices of a previous indexed draw.
+TEST_F(SwiftShaderVulkanRenderTest, IndexedThenNonIndexedDraws)
+{
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+
+	// A green grid of 16 x 16 quads, 512 triangles, covering the left half.
+	const int grid = 16;
+	for(int y = 0; y <= grid; y++)
+	{
+		for(int x = 0; x <= grid; x++)
+		{
+			vertices.insert(vertices.end(), { -1.0f + float(x) / grid, -1.0f + 2.0f * float(y) / grid, 0.0f, 1.0f, 0.0f, 1.0f });
+		}
+	}
+
+	for(uint32_t y = 0; y < grid; y++)
+	{
+		for(uint32_t x = 0; x < grid; x++)
+		{
+			uint32_t i = y * (grid + 1) + x;
+			indices.insert(indices.end(), { i, i + 1, i + grid + 1, i + 1, i + grid + 2, i + grid + 1 });
+		}
+	}
+
+	// The right half is divided into 4 x 16 cells, each covered by two red
+	// triangles of its own non-indexed draw, so that a draw which uses other
+	// vertices leaves its cell blue.
+	const uint32_t firstCellVertex = static_cast<uint32_t>(vertices.size() / 6);
+	const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+	for(int cell = 0; cell < 64; cell++)
+	{
+		for(auto &corner : corners)
+		{
+			float x = 0.25f * (cell % 4 + corner[0]);
+			float y = -1.0f + 0.125f * (cell / 4 + corner[1]);
+			vertices.insert(vertices.end(), { x, y, 1.0f, 0.0f, 0.0f, 1.0f });
+		}
+	}
+
+	// Three draws per iteration, so that draw calls are reused by draws of the
+	// other kind, whichever pool slot they get.
+	std::vector<Draw> draws;
+	for(uint32_t cell = 0; cell < 64; cell += 2)
+	{
+		draws.push_back({ 0, static_cast<uint32_t>(indices.size()), true });
+		draws.push_back({ firstCellVertex + 6 * cell, 6, false });
+		draws.push_back({ firstCellVertex + 6 * (cell + 1), 6, false });
+	}
+
+	const uint32_t width = 64;
+	const uint32_t height = 64;
+	const VkClearColorValue blue = { { 0.0f, 0.0f, 1.0f, 1.0f } };
+
+	std::vector<uint32_t> pixels;
+	render(vertices, indices, draws, width, height, VK_SAMPLE_COUNT_1_BIT, blue, blue, pixels);
+	ASSERT_EQ(pixels.size(), size_t(width) * height);
+
+	for(uint32_t y = 0; y < height; y++)
+	{
+		for(uint32_t x = 0; x < width; x++)
+		{
+			uint32_t expected = (x < width / 2) ? 0xFF00FF00u : 0xFF0000FFu;
+			ASSERT_EQ(expected, pixels[y * width + x]) << "at (" << x << ", " << y << ")";
+		}
+	}
+}
+
+// Base class for tests that sample images from a compute shader and read back
+// the sampled texels.
+class SwiftShaderVulkanSamplingTest : public testing::Test
+{
+protected:
+	void SetUp() override;
+	void TearDown() override;
+
+	// createStagingBuffer() creates a host visible transfer buffer holding the
+	// size bytes at data.
+	void createStagingBuffer(const void *data, size_t size, VkBuffer *buffer, VkDeviceMemory *memory);
+
+	// submit() records commands into a new command buffer with record(), then
+	// submits it and waits for it to complete.
+	void submit(std::function<void(VkCommandBuffer commandBuffer)> record);
+
+	// sampleTexels() samples the center of every texel of the first mipLevels
+	// mip levels of a width x height 2D image, with nearest filtering, and
+	// returns their four components in texels, level by level, in row-major
+	// order.
+	void sampleTexels(VkImage image, VkFormat format, uint32_t width, uint32_t height,
+	                  uint32_t mipLevels, std::vector<float> &texels);
+
+	// testBlockDecoding() uploads the blocks produced by generate() to every
+	// mip level of a width x height image with a block compressed format, and
+	// compares the sampled texels against those produced by decode() from the
+	// same blocks.
+	void testBlockDecoding(VkFormat format, size_t blockBytes, uint32_t width, uint32_t height,
+	                       std::function<void(uint8_t *block, uint32_t blockIndex)> generate,
+	                       std::function<void(const uint8_t *block, int texel, float color[4])> decode);
+
+	Driver driver;
+	VkInstance instance = VK_NULL_HANDLE;
+	std::unique_ptr<Device> device;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+};
+
+void SwiftShaderVulkanSamplingTest::SetUp()
+{
+	ASSERT_TRUE(driver.loadSwiftShader());
+
+	const VkInstanceCreateInfo createInfo = {
+		VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+		nullptr,                                 // pNext
+		0,                                       // flags
+		nullptr,                                 // pApplicationInfo
+		0,                                       // enabledLayerCount
+		nullptr,                                 // ppEnabledLayerNames
+		0,                                       // enabledExtensionCount
+		nullptr,                                 // ppEnabledExtensionNames
+	};
+
+	VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+	ASSERT_TRUE(driver.resolve(instance));
+
+	VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+	ASSERT_TRUE(device->IsValid());
+
+	VK_ASSERT(device->CreateCommandPool(&commandPool));
+}
+
+void SwiftShaderVulkanSamplingTest::TearDown()
+{
+	if(device)
+	{
+		if(commandPool != VK_NULL_HANDLE)
+		{
+			device->DestroyCommandPool(commandPool);
+		}
+
+		device.reset(nullptr);
+	}
+
+	if(instance != VK_NULL_HANDLE)
+	{
+		driver.vkDestroyInstance(instance, nullptr);
+	}
+}
+
+void SwiftShaderVulkanSamplingTest::createStagingBuffer(const void *data, size_t size, VkBuffer *buffer, VkDeviceMemory *memory)
+{
+	VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memory));
+
+	void *mapped;
+	VK_ASSERT(device->MapMemory(*memory, 0, size, 0, &mapped));
+	memcpy(mapped, data, size);
+	device->UnmapMemory(*memory);
+
+	VK_ASSERT(device->CreateTransferBuffer(*memory, size, 0, buffer));
+}
+
+void SwiftShaderVulkanSamplingTest::submit(std::function<void(VkCommandBuffer commandBuffer)> record)
+{
+	VkCommandBuffer commandBuffer;
+	VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+	VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+	record(commandBuffer);
+
+	VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+	VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+	device->FreeCommandBuffer(commandPool, commandBuffer);
+}
+
+void SwiftShaderVulkanSamplingTest::sampleTexels(
+    VkImage image, VkFormat format, uint32_t width, uint32_t height,
+    uint32_t mipLevels, std::vector<float> &texels)
+{
+	// Each invocation samples the image at the (u, v, lod) of its element of
+	// the first buffer, and writes the result to the second one.
+	// clang-format off
+	auto code = compileSpirv(
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %1 \"main\" %2\n"
+              "OpExecutionMode %1 LocalSize 1 1 1\n"
+              "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %3 ArrayStride 16\n"
+              "OpMemberDecorate %4 0 Offset 0\n"
+              "OpDecorate %4 BufferBlock\n"
+              "OpDecorate %5 DescriptorSet 0\n"
+              "OpDecorate %5 Binding 0\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 1\n"
+              "OpDecorate %7 DescriptorSet 0\n"
+              "OpDecorate %7 Binding 2\n"
+         "%8 = OpTypeVoid\n"
+         "%9 = OpTypeFunction %8\n"
+        "%10 = OpTypeFloat 32\n"
+        "%11 = OpTypeVector %10 4\n"
+        "%12 = OpTypeVector %10 2\n"
+        "%13 = OpTypeInt 32 0\n"
+        "%14 = OpTypeVector %13 3\n"
+        "%15 = OpTypePointer Input %14\n"
+         "%2 = OpVariable %15 Input\n"
+         "%3 = OpTypeRuntimeArray %11\n"
+         "%4 = OpTypeStruct %3\n"
+        "%16 = OpTypePointer Uniform %4\n"
+         "%5 = OpVariable %16 Uniform\n"  // coordinates
+         "%6 = OpVariable %16 Uniform\n"  // texels
+        "%17 = OpTypeImage %10 2D 0 0 0 1 Unknown\n"
+        "%18 = OpTypeSampledImage %17\n"
+        "%19 = OpTypePointer UniformConstant %18\n"
+         "%7 = OpVariable %19 UniformConstant\n"
+        "%20 = OpTypeInt 32 1\n"
+        "%21 = OpConstant %20 0\n"
+        "%22 = OpTypePointer Uniform %11\n"
+        "%23 = OpTypePointer Input %13\n"
+        "%24 = OpConstant %13 0\n"
+         "%1 = OpFunction %8 None %9\n"
+        "%25 = OpLabel\n"
+        "%26 = OpAccessChain %23 %2 %24\n"
+        "%27 = OpLoad %13 %26\n"
+        "%28 = OpAccessChain %22 %5 %21 %27\n"
+        "%29 = OpLoad %11 %28\n"
+        "%30 = OpVectorShuffle %12 %29 %29 0 1\n"
+        "%31 = OpCompositeExtract %10 %29 2\n"
+        "%32 = OpLoad %18 %7\n"
+        "%33 = OpImageSampleExplicitLod %11 %32 %30 Lod %31\n"
+        "%34 = OpAccessChain %22 %6 %21 %27\n"
+              "OpStore %34 %33\n"
+              "OpReturn\n"
+              "OpFunctionEnd\n");
+	// clang-format on
+
+	std::vector<float> coordinates;
+	for(uint32_t level = 0; level < mipLevels; level++)
+	{
+		uint32_t levelWidth = std::max(width >> level, 1u);
+		uint32_t levelHeight = std::max(height >> level, 1u);
+
+		for(uint32_t y = 0; y < levelHeight; y++)
+		{
+			for(uint32_t x = 0; x < levelWidth; x++)
+			{
+				coordinates.insert(coordinates.end(), { (x + 0.5f) / levelWidth, (y + 0.5f) / levelHeight, float(level), 0.0f });
+			}
+		}
+	}
+
+	const uint32_t count = static_cast<uint32_t>(coordinates.size() / 4);
+	const VkDeviceSize size = coordinates.size() * sizeof(float);
+
+	VkDeviceMemory coordinatesMemory;
+	VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &coordinatesMemory));
+
+	void *mapped;
+	VK_ASSERT(device->MapMemory(coordinatesMemory, 0, size, 0, &mapped));
+	memcpy(mapped, coordinates.data(), size);
+	device->UnmapMemory(coordinatesMemory);
+
+	VkBuffer coordinatesBuffer;
+	VK_ASSERT(device->CreateStorageBuffer(coordinatesMemory, size, 0, &coordinatesBuffer));
+
+	VkDeviceMemory texelsMemory;
+	VK_ASSERT(device->AllocateMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &texelsMemory));
+
+	VkBuffer texelsBuffer;
+	VK_ASSERT(device->CreateStorageBuffer(texelsMemory, size, 0, &texelsBuffer));
+
+	VkImageView imageView;
+	VK_ASSERT(device->CreateImageView(image, format, &imageView, mipLevels));
+
+	VkSampler sampler;
+	VK_ASSERT(device->CreateSampler(&sampler));
+
+	VkShaderModule shaderModule;
+	VK_ASSERT(device->CreateShaderModule(code, &shaderModule));
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
+		{
+		    0,                                  // binding
+		    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+		    1,                                  // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+		    0,                                  // pImmutableSamplers
+		},
+		{
+		    1,                                  // binding
+		    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  // descriptorType
+		    1,                                  // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,        // stageFlags
+		    0,                                  // pImmutableSamplers
+		},
+		{
+		    2,                                          // binding
+		    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // descriptorType
+		    1,                                          // descriptorCount
+		    VK_SHADER_STAGE_COMPUTE_BIT,                // stageFlags
+		    0,                                          // pImmutableSamplers
+		}
+	};
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+	VkPipelineLayout pipelineLayout;
+	VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+	VkPipeline pipeline;
+	VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline));
+
+	VkDescriptorPool descriptorPool;
+	VK_ASSERT(device->CreateDescriptorPool({ { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+	                                         { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 } },
+	                                       &descriptorPool));
+
+	VkDescriptorSet descriptorSet;
+	VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+	std::vector<VkDescriptorBufferInfo> descriptorBufferInfos = {
+		{
+		    coordinatesBuffer,  // buffer
+		    0,                  // offset
+		    VK_WHOLE_SIZE,      // range
+		},
+		{
+		    texelsBuffer,   // buffer
+		    0,              // offset
+		    VK_WHOLE_SIZE,  // range
+		}
+	};
+	device->UpdateStorageBufferDescriptorSets(descriptorSet, descriptorBufferInfos);
+	device->UpdateCombinedImageSamplerDescriptorSet(descriptorSet, 2, imageView, sampler);
+
+	submit([&](VkCommandBuffer commandBuffer) {
+		driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+		                               0, nullptr);
+		driver.vkCmdDispatch(commandBuffer, count, 1, 1);
+	});
+
+	texels.resize(coordinates.size());
+	VK_ASSERT(device->MapMemory(texelsMemory, 0, size, 0, &mapped));
+	memcpy(texels.data(), mapped, size);
+	device->UnmapMemory(texelsMemory);
+
+	device->DestroyPipeline(pipeline);
+	device->DestroyPipelineLayout(pipelineLayout);
+	device->DestroyDescriptorSetLayout(descriptorSetLayout);
+	device->DestroyDescriptorPool(descriptorPool);
+	device->DestroyShaderModule(shaderModule);
+	device->DestroySampler(sampler);
+	device->DestroyImageView(imageView);
+	device->DestroyBuffer(texelsBuffer);
+	device->FreeMemory(texelsMemory);
+	device->DestroyBuffer(coordinatesBuffer);
+	device->FreeMemory(coordinatesMemory);
+}
+
+void SwiftShaderVulkanSamplingTest::testBlockDecoding(
+    VkFormat format, size_t blockBytes, uint32_t width, uint32_t height,
+    std::function<void(uint8_t *block, uint32_t blockIndex)> generate,
+    std::function<void(const uint8_t *block, int texel, float color[4])> decode)
+{
+	uint32_t mipLevels = 1;
+	while((std::max(width, height) >> mipLevels) != 0)
+	{
+		mipLevels++;
+	}
+
+	std::vector<uint8_t> blocks;
+	std::vector<VkBufferImageCopy> regions;
+	for(uint32_t level = 0; level < mipLevels; level++)
+	{
+		uint32_t levelWidth = std::max(width >> level, 1u);
+		uint32_t levelHeight = std::max(height >> level, 1u);
+		uint32_t blockCount = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = blocks.size();
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		region.imageExtent = { levelWidth, levelHeight, 1 };
+		regions.push_back(region);
+
+		size_t first = blocks.size() / blockBytes;
+		blocks.resize(blocks.size() + blockCount * blockBytes);
+		for(uint32_t i = 0; i < blockCount; i++)
+		{
+			generate(&blocks[(first + i) * blockBytes], static_cast<uint32_t>(first + i));
+		}
+	}
+
+	VkBuffer buffer;
+	VkDeviceMemory bufferMemory;
+	ASSERT_NO_FATAL_FAILURE(createStagingBuffer(blocks.data(), blocks.size(), &buffer, &bufferMemory));
+
+	VkImage image;
+	VkDeviceMemory imageMemory;
+	VK_ASSERT(device->CreateSampledImage(format, width, height, mipLevels, &image, &imageMemory));
+
+	ASSERT_NO_FATAL_FAILURE(submit([&](VkCommandBuffer commandBuffer) {
+		driver.vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                              static_cast<uint32_t>(regions.size()), regions.data());
+	}));
+
+	std::vector<float> texels;
+	ASSERT_NO_FATAL_FAILURE(sampleTexels(image, format, width, height, mipLevels, texels));
+
+	const float *texel = texels.data();
+	for(uint32_t level = 0; level < mipLevels; level++)
+	{
+		uint32_t levelWidth = std::max(width >> level, 1u);
+		uint32_t levelHeight = std::max(height >> level, 1u);
+		const uint8_t *levelBlocks = &blocks[regions[level].bufferOffset];
+
+		for(uint32_t y = 0; y < levelHeight; y++)
+		{
+			for(uint32_t x = 0; x < levelWidth; x++, texel += 4)
+			{
+				const uint8_t *block = levelBlocks + ((y / 4) * ((levelWidth + 3) / 4) + x / 4) * blockBytes;
+				float expected[4];
+				decode(block, (y % 4) * 4 + x % 4, expected);
+
+				// Allow for interpolating between endpoints expanded to 8 bits,
+				// and truncating the result, which the specification permits.
+				for(int c = 0; c < 4; c++)
+				{
+					ASSERT_NEAR(expected[c], texel[c], 1.5f / 255)
+					    << "component " << c << " at (" << x << ", " << y << ") of level " << level;
+				}
+			}
+		}
+	}
+
+	device->DestroyImage(image);
+	device->FreeMemory(imageMemory);
+	device->DestroyBuffer(buffer);
+	device->FreeMemory(bufferMemory);
+}
+
+// Fills a block with pseudo-random bytes, a different sequence for each block.
+static void randomBlock(uint8_t *block, size_t blockBytes, uint32_t blockIndex)
+{
+	uint32_t state = 0x9E3779B9u * (blockIndex + 1);
+	for(size_t i = 0; i < blockBytes; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		block[i] = static_cast<uint8_t>(state >> 24);
+	}
+}
+
+// Decodes a texel of a BC1 color block, or of the color part of a BC3 block,
+// as described in the Khronos Data Format Specification.
+static void decodeBC1Texel(const uint8_t *block, int texel, bool separateAlpha, float color[4])
+{
+	uint32_t c0 = block[0] | (block[1] << 8);
+	uint32_t c1 = block[2] | (block[3] << 8);
+	uint32_t selectors = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+	uint32_t selector = (selectors >> (2 * texel)) & 3;
+
+	const int shifts[3] = { 11, 5, 0 };
+	const int bits[3] = { 5, 6, 5 };
+	for(int c = 0; c < 3; c++)
+	{
+		uint32_t mask = (1 << bits[c]) - 1;
+		float e0 = float((c0 >> shifts[c]) & mask) / mask;
+		float e1 = float((c1 >> shifts[c]) & mask) / mask;
+
+		if(c0 > c1 || separateAlpha)
+		{
+			const float e[4] = { e0, e1, (2 * e0 + e1) / 3, (e0 + 2 * e1) / 3 };
+			color[c] = e[selector];
+		}
+		else
+		{
+			const float e[4] = { e0, e1, (e0 + e1) / 2, 0.0f };
+			color[c] = e[selector];
+		}
+	}
+
+	color[3] = (c0 <= c1 && !separateAlpha && selector == 3) ? 0.0f : 1.0f;
+}
+
+// Decodes a texel of a BC4 block, or of a channel of a BC5 block or the alpha
+// of a BC3 block.
+static float decodeBC4Texel(const uint8_t *block, int texel)
+{
+	float e0 = block[0] / 255.0f;
+	float e1 = block[1] / 255.0f;
+	uint64_t selectors = 0;
+	for(int i = 0; i < 6; i++)
+	{
+		selectors |= uint64_t(block[2 + i]) << (8 * i);
+	}
+	uint32_t selector = (selectors >> (3 * texel)) & 7;
+
+	if(selector < 2)
+	{
+		return selector == 0 ? e0 : e1;
+	}
+	else if(block[0] > block[1])
+	{
+		return ((8 - selector) * e0 + (selector - 1) * e1) / 7;
+	}
+	else if(selector < 6)
+	{
+		return ((6 - selector) * e0 + (selector - 1) * e1) / 5;
+	}
+	else
+	{
+		return selector == 6 ? 0.0f : 1.0f;
+	}
+}
+
+// The mip chain of a 20 x 12 image has levels which aren't a multiple of the
+// block size, down to partially covered blocks.
+TEST_F(SwiftShaderVulkanSamplingTest, BC1PunchThroughAlpha)
+{
+	testBlockDecoding(
+	    VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 20, 12,
+	    [](uint8_t *block, uint32_t blockIndex) {
+		    randomBlock(block, 8, blockIndex);
+
+		    // Alternate between four colors and three colors with transparent
+		    // black, which are selected by the order of the endpoints.
+		    bool fourColors = (blockIndex % 2) == 0;
+		    if((block[1] > block[3]) != fourColors)
+		    {
+			    std::swap(block[0], block[2]);
+			    std::swap(block[1], block[3]);
+		    }
+		    if(block[1] == block[3])
+		    {
+			    block[1] = fourColors ? 0xFF : 0x00;
+			    block[3] = fourColors ? 0x00 : 0xFF;
+		    }
+	    },
+	    [](const uint8_t *block, int texel, float color[4]) {
+		    decodeBC1Texel(block, texel, false, color);
+	    });
+}
+
+TEST_F(SwiftShaderVulkanSamplingTest, BC3)
+{
+	testBlockDecoding(
+	    VK_FORMAT_BC3_UNORM_BLOCK, 16, 20, 12,
+	    [](uint8_t *block, uint32_t blockIndex) {
+		    randomBlock(block, 16, blockIndex);
+
+		    // Alternate between eight alpha values and six with 0 and 1.
+		    if((block[0] > block[1]) != ((blockIndex % 2) == 0))
+		    {
+			    std::swap(block[0], block[1]);
+		    }
+	    },
+	    [](const uint8_t *block, int texel, float color[4]) {
+		    decodeBC1Texel(block + 8, texel, true, color);
+		    color[3] = decodeBC4Texel(block, texel);
+	    });
+}
+
+TEST_F(SwiftShaderVulkanSamplingTest, BC5)
+{
+	testBlockDecoding(
+	    VK_FORMAT_BC5_UNORM_BLOCK, 16, 20, 12,
+	    [](uint8_t *block, uint32_t blockIndex) {
+		    randomBlock(block, 16, blockIndex);
+
+		    // Use eight values for one channel and six for the other, in turn.
+		    bool eightValues = (blockIndex % 2) == 0;
+		    if((block[0] > block[1]) != eightValues)
+		    {
+			    std::swap(block[0], block[1]);
+		    }
+		    if((block[8] > block[9]) == eightValues)
+		    {
+			    std::swap(block[8], block[9]);
+		    }
+	    },
+	    [](const uint8_t *block, int texel, float color[4]) {
+		    color[0] = decodeBC4Texel(block, texel);
+		    color[1] = decodeBC4Texel(block + 8, texel);
+		    color[2] = 0.0f;
+		    color[3] = 1.0f;
+	    });
+}
+
+// Sampled-only images are stored in 4x4 tiles. Write a mip chain with odd
+// extents through buffer copies, blits and clears, which each address the
+// tiles, and check that sampling finds every texel where it was written.
+TEST_F(SwiftShaderVulkanSamplingTest, TiledImageTransfers)
+{
+	const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+	const uint32_t width = 37;
+	const uint32_t height = 23;
+	const uint32_t mipLevels = 6;
+
+	auto levelWidth = [&](uint32_t level) { return std::max(width >> level, 1u); };
+	auto levelHeight = [&](uint32_t level) { return std::max(height >> level, 1u); };
+
+	// The texels expected in each level, as packed RGBA8 values.
+	std::vector<std::vector<uint32_t>> expected(mipLevels);
+
+	// Fill every level with a copy of the whole level, then overwrite a
+	// rectangle of level 0 which starts and ends within tiles.
+	std::vector<uint32_t> texels;
+	std::vector<VkBufferImageCopy> regions;
+	for(uint32_t level = 0; level < mipLevels; level++)
+	{
+		VkBufferImageCopy region = {};
+		region.bufferOffset = texels.size() * sizeof(uint32_t);
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		region.imageExtent = { levelWidth(level), levelHeight(level), 1 };
+		regions.push_back(region);
+
+		for(uint32_t y = 0; y < levelHeight(level); y++)
+		{
+			for(uint32_t x = 0; x < levelWidth(level); x++)
+			{
+				uint32_t texel = 0xFF000000u | ((40 * level + 1) << 16) | ((y * 11) << 8) | (x * 6);
+				texels.push_back(texel);
+				expected[level].push_back(texel);
+			}
+		}
+	}
+
+	const VkOffset3D copyOffset = { 5, 3, 0 };
+	const VkExtent3D copyExtent = { 13, 7, 1 };
+	{
+		VkBufferImageCopy region = {};
+		region.bufferOffset = texels.size() * sizeof(uint32_t);
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = copyOffset;
+		region.imageExtent = copyExtent;
+		regions.push_back(region);
+
+		for(uint32_t y = 0; y < copyExtent.height; y++)
+		{
+			for(uint32_t x = 0; x < copyExtent.width; x++)
+			{
+				uint32_t texel = 0x80FF0000u | (y << 12) | (x << 4);
+				texels.push_back(texel);
+				expected[0][(copyOffset.y + y) * width + copyOffset.x + x] = texel;
+			}
+		}
+	}
+
+	VkBuffer buffer;
+	VkDeviceMemory bufferMemory;
+	ASSERT_NO_FATAL_FAILURE(createStagingBuffer(texels.data(), texels.size() * sizeof(uint32_t), &buffer, &bufferMemory));
+
+	// Blit a row-linear image, one texel per texel, into a rectangle of level 1.
+	const VkExtent3D blitExtent = { 13, 9, 1 };
+	const VkOffset3D blitOffset = { 3, 1, 0 };
+	std::vector<uint32_t> blitTexels;
+	for(uint32_t y = 0; y < blitExtent.height; y++)
+	{
+		for(uint32_t x = 0; x < blitExtent.width; x++)
+		{
+			uint32_t texel = 0xC00000FFu | (y << 16) | (x << 8);
+			blitTexels.push_back(texel);
+			expected[1][(blitOffset.y + y) * levelWidth(1) + blitOffset.x + x] = texel;
+		}
+	}
+
+	VkBuffer blitBuffer;
+	VkDeviceMemory blitBufferMemory;
+	ASSERT_NO_FATAL_FAILURE(createStagingBuffer(blitTexels.data(), blitTexels.size() * sizeof(uint32_t), &blitBuffer, &blitBufferMemory));
+
+	VkImage blitImage;
+	VkDeviceMemory blitImageMemory;
+	VK_ASSERT(device->CreateTransferImage(format, blitExtent.width, blitExtent.height, &blitImage, &blitImageMemory));
+
+	// Clear levels 2 and 3, whose extents aren't a multiple of the tile size.
+	const VkClearColorValue clearColor = { { 0.2f, 0.4f, 0.6f, 0.8f } };
+	const VkImageSubresourceRange clearRange = { VK_IMAGE_ASPECT_COLOR_BIT, 2, 2, 0, 1 };
+	for(uint32_t level = 2; level < 4; level++)
+	{
+		std::fill(expected[level].begin(), expected[level].end(), 0xCC996633u);
+	}
+
+	VkImage image;
+	VkDeviceMemory imageMemory;
+	VK_ASSERT(device->CreateSampledImage(format, width, height, mipLevels, &image, &imageMemory));
+
+	ASSERT_NO_FATAL_FAILURE(submit([&](VkCommandBuffer commandBuffer) {
+		driver.vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                              static_cast<uint32_t>(regions.size()), regions.data());
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = blitExtent;
+		driver.vkCmdCopyBufferToImage(commandBuffer, blitBuffer, blitImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		VkImageBlit blit = {};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.srcOffsets[1] = { int32_t(blitExtent.width), int32_t(blitExtent.height), 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 1, 0, 1 };
+		blit.dstOffsets[0] = blitOffset;
+		blit.dstOffsets[1] = { blitOffset.x + int32_t(blitExtent.width), blitOffset.y + int32_t(blitExtent.height), 1 };
+		driver.vkCmdBlitImage(commandBuffer, blitImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		                      image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_NEAREST);
+
+		driver.vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &clearRange);
+	}));
+
+	std::vector<float> sampled;
+	ASSERT_NO_FATAL_FAILURE(sampleTexels(image, format, width, height, mipLevels, sampled));
+
+	const float *texel = sampled.data();
+	for(uint32_t level = 0; level < mipLevels; level++)
+	{
+		for(uint32_t y = 0; y < levelHeight(level); y++)
+		{
+			for(uint32_t x = 0; x < levelWidth(level); x++, texel += 4)
+			{
+				uint32_t packed = expected[level][y * levelWidth(level) + x];
+				for(int c = 0; c < 4; c++)
+				{
+					ASSERT_NEAR(((packed >> (8 * c)) & 0xFF) / 255.0f, texel[c], 0.5f / 255)
+					    << "component " << c << " at (" << x << ", " << y << ") of level " << level;
+				}
+			}
+		}
+	}
+
+	device->DestroyImage(image);
+	device->FreeMemory(imageMemory);
+	device->DestroyImage(blitImage);
+	device->FreeMemory(blitImageMemory);
+	device->DestroyBuffer(blitBuffer);
+	device->FreeMemory(blitBufferMemory);
+	device->DestroyBuffer(buffer);
+	device->FreeMemory(bufferMemory);
+}
@@ -215,10 +215,12 @@ void Cfg::translate() {
   // Cache the possibly-overridden optimization level once translation begins.
   // It would be nicer to do this in the constructor, but we need to wait until
   // after setFunctionName() has a chance to be called.
-  OptimizationLevel =
-      getFlags().matchForceO2(getFunctionName(), getSequenceNumber())
-          ? Opt_2
-          : getFlags().getOptLevel();
+  if (!HasOptLevelOverride) {
+    OptimizationLevel =
+        getFlags().matchForceO2(getFunctionName(), getSequenceNumber())
+            ? Opt_2
+            : getFlags().getOptLevel();
+  }
   if (BuildDefs::timers()) {
     if (getFlags().matchTimingFocus(getFunctionName(), getSequenceNumber())) {
       setFocusedTiming();
@@ -44,6 +44,12 @@ public:
   GlobalContext *getContext() const { return Ctx; }
   uint32_t getSequenceNumber() const { return SequenceNumber; }
   OptLevel getOptLevel() const { return OptimizationLevel; }
+  /// Overrides the optimization level from the command line flags for this
+  /// function. Must be called before translate().
+  void setOptLevel(OptLevel Level) {
+    OptimizationLevel = Level;
+    HasOptLevelOverride = true;
+  }
 
   static constexpr VerboseMask defaultVerboseMask() {
     return (IceV_NO_PER_PASS_DUMP_BEYOND << 1) - 1;
@@ -313,6 +319,7 @@ private:
   GlobalContext *Ctx;
   uint32_t SequenceNumber; /// output order for emission
   OptLevel OptimizationLevel = Opt_m1;
+  bool HasOptLevelOverride = false;
   uint32_t ConstantBlindingCookie = 0; /// cookie for constant blinding
   VerboseMask VMask;
   GlobalString FunctionName;